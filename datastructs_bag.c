@@ -0,0 +1,325 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Smallest table, in slots */
+#define BAG_MIN_CAPACITY 16
+
+
+/**
+ * Bag - slots
+ */
+static inline __attribute__((always_inline))
+bool equal_bag(bag_t *const b, const uint8_t key_type, const void *const x,
+        const void *const y)
+{
+    switch (key_type) {
+        case BINARYTREE_KEY_INT64:  return *(const int64_t *)x == *(const int64_t *)y;
+        case BINARYTREE_KEY_STRING: return strcmp(x, y) == 0;
+        case BINARYTREE_KEY_CUSTOM: return b->compare(x, y) == 0;
+        default:                    return x == y;
+    }
+}
+
+static inline uint64_t max_load_bag(uint64_t capacity)
+{
+    return capacity / 4 * 3;
+}
+
+/**
+ * Slot holding data or the empty slot ending its probe, items are compared
+ * on equal hashes only
+ */
+static inline __attribute__((always_inline))
+uint64_t probe_typed(bag_t *const b, const uint8_t key_type, const void *const data,
+        uint64_t h)
+{
+    uint64_t mask = b->capacity - 1;
+
+    for (uint64_t i = h & mask; ; i = (i + 1) & mask) {
+        bag_entry_t *e = b->entries + i;
+
+        if (e->count == 0 || (e->hash == h && equal_bag(b, key_type, data, e->data)))
+            return i;
+    }
+}
+
+static uint64_t probe_bag(bag_t *const b, const void *const data, uint64_t h)
+{
+    switch (b->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return probe_typed(b, BINARYTREE_KEY_INT64, data, h);
+        case BINARYTREE_KEY_STRING:
+            return probe_typed(b, BINARYTREE_KEY_STRING, data, h);
+        case BINARYTREE_KEY_CUSTOM:
+            return probe_typed(b, BINARYTREE_KEY_CUSTOM, data, h);
+        default:
+            return probe_typed(b, BINARYTREE_KEY_ADDRESS, data, h);
+    }
+}
+
+/**
+ * Move all items into a table of the given number of slots, the kept
+ * hashes place them without hashing again
+ */
+static int8_t resize_bag(bag_t *const b, uint64_t capacity)
+{
+    bag_entry_t *entries = calloc(capacity, sizeof(*entries));
+
+    if (entries == NULL) return -1;
+
+    for (uint64_t i = 0; i < b->capacity; i++) {
+        if (b->entries[i].count == 0) continue;
+
+        uint64_t j = b->entries[i].hash & (capacity - 1);
+        while (entries[j].count != 0)
+            j = (j + 1) & (capacity - 1);
+
+        entries[j] = b->entries[i];
+    }
+
+    free(b->entries);
+
+    b->entries = entries;
+    b->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Refill an emptied slot. Items of the following run whose probe started at
+ * or before the hole move back into it, which moves on to where they came
+ * from.
+ */
+static void shift_bag(bag_t *const b, uint64_t hole)
+{
+    uint64_t mask = b->capacity - 1;
+
+    for (uint64_t i = (hole + 1) & mask; b->entries[i].count != 0; i = (i + 1) & mask) {
+        uint64_t home = b->entries[i].hash & mask;
+
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            b->entries[hole] = b->entries[i];
+            b->entries[i].count = 0;
+            hole = i;
+        }
+    }
+}
+
+
+/**
+ * Bag - core
+ */
+bag_t *create_bag(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *))
+{
+    bag_t *b = calloc(1, sizeof(bag_t));
+
+    if (b == NULL) return NULL;
+
+    b->entries = calloc(BAG_MIN_CAPACITY, sizeof(*b->entries));
+
+    if (b->entries == NULL) {
+        free(b);
+        return NULL;
+    }
+
+    b->capacity = BAG_MIN_CAPACITY;
+    b->key_type = key_type;
+    b->hash = hash;
+    b->compare = compare;
+    return b;
+}
+
+void free_bag(bag_t *b)
+{
+    free(b->entries);
+    free(b);
+}
+
+void reset_bag(bag_t *const b)
+{
+    memset(b->entries, 0, b->capacity * sizeof(*b->entries));
+    b->distinct = 0;
+    b->total = 0;
+}
+
+int8_t reserve_bag(bag_t *const b, uint64_t distinct)
+{
+    uint64_t capacity = b->capacity;
+
+    while (max_load_bag(capacity) < distinct)
+        capacity *= 2;
+
+    if (capacity == b->capacity) return 1;
+
+    return resize_bag(b, capacity);
+}
+
+int8_t add_bag(bag_t *const b, void *const data)
+{
+    uint64_t h = hashed_key(b->key_type, b->hash, data);
+    uint64_t i = probe_bag(b, data, h);
+
+    if (b->entries[i].count == 0) {
+        if (b->distinct + 1 > max_load_bag(b->capacity)) {
+            if (reserve_bag(b, b->distinct + 1) < 0) return -1;
+
+            i = probe_bag(b, data, h);
+        }
+
+        b->entries[i].data = data;
+        b->entries[i].hash = h;
+        b->distinct++;
+    }
+
+    b->entries[i].count++;
+    b->total++;
+    return 1;
+}
+
+int8_t remove_bag(bag_t *const b, void *const data)
+{
+    uint64_t i = probe_bag(b, data, hashed_key(b->key_type, b->hash, data));
+
+    if (b->entries[i].count == 0) return -1;
+
+    b->total--;
+
+    if (--b->entries[i].count == 0) {
+        b->distinct--;
+        shift_bag(b, i);
+    }
+
+    return 1;
+}
+
+uint64_t count_bag(bag_t *const b, const void *const data)
+{
+    return b->entries[probe_bag(b, data, hashed_key(b->key_type, b->hash, data))].count;
+}
+
+
+/**
+ * Bag - derived
+ */
+uint64_t distinct_bag(bag_t *const b)
+{
+    return b->distinct;
+}
+
+uint64_t total_bag(bag_t *const b)
+{
+    return b->total;
+}
+
+size_t memory_bag(bag_t *const b)
+{
+    return b->capacity * sizeof(*b->entries) + sizeof(*b);
+}
+
+void map_bag(bag_t *const b, void (*func)(void *, uint64_t, void *), void *func_data)
+{
+    for (uint64_t i = 0; i < b->capacity; i++)
+        if (b->entries[i].count != 0)
+            func(b->entries[i].data, b->entries[i].count, func_data);
+}
+
+/**
+ * Restore the min-heap order of counts below entry i
+ */
+static void sift_down_bag(bag_entry_t *const heap, uint64_t n, uint64_t i)
+{
+    bag_entry_t e = heap[i];
+
+    for (uint64_t c = 2 * i + 1; c < n; i = c, c = 2 * i + 1) {
+        if (c + 1 < n && heap[c + 1].count < heap[c].count) c++;
+        if (heap[c].count >= e.count) break;
+
+        heap[i] = heap[c];
+    }
+
+    heap[i] = e;
+}
+
+uint64_t top_bag(bag_t *const b, uint64_t k, bag_entry_t *const top)
+{
+    uint64_t n = 0;
+
+    if (k == 0) return 0;
+
+    // the k largest counts seen so far, the smallest of them on top
+    for (uint64_t i = 0; i < b->capacity; i++) {
+        bag_entry_t *e = b->entries + i;
+
+        if (e->count == 0) continue;
+
+        if (n < k) {
+            uint64_t j = n++;
+
+            for (; j > 0 && top[(j - 1) / 2].count > e->count; j = (j - 1) / 2)
+                top[j] = top[(j - 1) / 2];
+            top[j] = *e;
+        } else if (e->count > top[0].count) {
+            top[0] = *e;
+            sift_down_bag(top, n, 0);
+        }
+    }
+
+    // taking the smallest off the heap fills the array from the back
+    for (uint64_t m = n; m > 1; m--) {
+        bag_entry_t e = top[0];
+
+        top[0] = top[m - 1];
+        top[m - 1] = e;
+        sift_down_bag(top, m - 1, 0);
+    }
+
+    return n;
+}
+
+static inline __attribute__((always_inline))
+void merge_typed(bag_t *const dst, bag_t *const src, const uint8_t key_type)
+{
+    for (uint64_t i = 0; i < src->capacity; i++) {
+        bag_entry_t *e = src->entries + i;
+
+        if (e->count == 0) continue;
+
+        uint64_t j = probe_typed(dst, key_type, e->data, e->hash);
+
+        if (dst->entries[j].count == 0) {
+            dst->entries[j] = *e;
+            dst->distinct++;
+        } else
+            dst->entries[j].count += e->count;
+    }
+
+    dst->total += src->total;
+}
+
+int8_t merge_bag(bag_t *const dst, bag_t *const src)
+{
+    if (dst->key_type != src->key_type || dst->hash != src->hash ||
+            dst->compare != src->compare)
+        return -1;
+
+    if (dst == src) {
+        for (uint64_t i = 0; i < dst->capacity; i++)
+            dst->entries[i].count *= 2;
+
+        dst->total *= 2;
+        return 1;
+    }
+
+    // room for all items of src up front, a failure leaves dst as it was
+    if (reserve_bag(dst, dst->distinct + src->distinct) < 0) return -1;
+
+    switch (dst->key_type) {
+        case BINARYTREE_KEY_INT64:  merge_typed(dst, src, BINARYTREE_KEY_INT64); break;
+        case BINARYTREE_KEY_STRING: merge_typed(dst, src, BINARYTREE_KEY_STRING); break;
+        case BINARYTREE_KEY_CUSTOM: merge_typed(dst, src, BINARYTREE_KEY_CUSTOM); break;
+        default:                    merge_typed(dst, src, BINARYTREE_KEY_ADDRESS); break;
+    }
+
+    return 1;
+}
@@ -1,4 +1,6 @@
 #include "datastructs.h"
+#include <string.h>
+#include <unistd.h>
 
 
 /**
@@ -6,10 +8,854 @@
  */
 binarytree_t *create_binarytree()
 {
-    binarytree_t *t = malloc(sizeof(binarytree_t));
+    return calloc(1, sizeof(binarytree_t));
+}
+
+binarytree_t *create_binarytree_pooled()
+{
+    binarytree_t *t = create_binarytree();
+    t->pool = shared_node_pool(NODE_POOL_DLP);
+    return t;
+}
+
+binarytree_t *create_binarytree_arena()
+{
+    binarytree_t *t = create_binarytree();
+    t->pool = create_node_pool(sizeof(dlp_node_t), NODE_ARENA_SLAB);
+    return t;
+}
+
+binarytree_t *create_binarytree_mode(uint8_t mode)
+{
+    binarytree_t *t = create_binarytree();
+    t->mode = mode;
+    return t;
+}
+
+binarytree_t *create_binarytree_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *))
+{
+    binarytree_t *t = create_binarytree();
+    t->key_type = BINARYTREE_KEY_CUSTOM;
+    t->compare = compare;
+    t->prefix = prefix;
     return t;
 }
 
+binarytree_t *create_binarytree_int()
+{
+    binarytree_t *t = create_binarytree();
+    t->key_type = BINARYTREE_KEY_INT64;
+    return t;
+}
+
+binarytree_t *create_binarytree_str()
+{
+    binarytree_t *t = create_binarytree();
+    t->key_type = BINARYTREE_KEY_STRING;
+    return t;
+}
+
+
+/**
+ * Binary tree - keys
+ */
+#define SIZE(n) ((n) != NULL ? (n)->size : 0)
+
+uint64_t cached_key(uint8_t key_type, uint64_t (*prefix)(const void *),
+        const void *const data)
+{
+    switch (key_type) {
+        case BINARYTREE_KEY_INT64:
+            // flip the sign so negative values order below positive ones
+            return (uint64_t)*(const int64_t *)data ^ 1ULL << 63;
+
+        case BINARYTREE_KEY_STRING: {
+            const unsigned char *c = data;
+            uint64_t key = 0;
+
+            // first 8 bytes big-endian, a shorter string pads with zeros
+            for (int i = 0; i < 8; i++) {
+                key = key << 8 | *c;
+                c += *c != 0;
+            }
+            return key;
+        }
+
+        case BINARYTREE_KEY_CUSTOM:
+            return prefix != NULL ? prefix(data) : 0;
+
+        default:
+            return (uintptr_t)data;
+    }
+}
+
+static uint64_t key_binarytree(binarytree_t *const t, const void *const data)
+{
+    return cached_key(t->key_type, t->prefix, data);
+}
+
+/**
+ * Order data against a node, the cached keys decide unless they are equal.
+ * Always inlined with a constant key type, so every key type gets its own
+ * descent without an indirect call.
+ */
+static inline __attribute__((always_inline))
+int compare_binarytree(binarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data, const dlp_node_t *const n)
+{
+    if (key != n->key)
+        return key < n->key ? -1 : 1;
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING: return strcmp(data, n->data);
+        case BINARYTREE_KEY_CUSTOM: return t->compare(data, n->data);
+        default:                    return 0; // key is the whole value
+    }
+}
+
+static inline __attribute__((always_inline))
+dlp_node_t **descend_typed(binarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data, dlp_node_t **parent)
+{
+    dlp_node_t **link = &t->root;
+    int order;
+
+    *parent = NULL;
+
+    while (*link != NULL &&
+            (order = compare_binarytree(t, key_type, key, data, *link)) != 0) {
+        *parent = *link;
+        link = order < 0 ? &(*link)->prev : &(*link)->next;
+    }
+
+    return link;
+}
+
+/**
+ * Link that holds data, or where it would be added below parent
+ */
+static dlp_node_t **descend_binarytree(binarytree_t *const t, uint64_t key,
+        const void *const data, dlp_node_t **parent)
+{
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return descend_typed(t, BINARYTREE_KEY_INT64, key, data, parent);
+        case BINARYTREE_KEY_STRING:
+            return descend_typed(t, BINARYTREE_KEY_STRING, key, data, parent);
+        case BINARYTREE_KEY_CUSTOM:
+            return descend_typed(t, BINARYTREE_KEY_CUSTOM, key, data, parent);
+        default:
+            return descend_typed(t, BINARYTREE_KEY_ADDRESS, key, data, parent);
+    }
+}
+
+/**
+ * Descend towards data, remembering the last node on the side asked for.
+ * Above gives the smallest node after data, otherwise the largest before it.
+ */
+static inline __attribute__((always_inline))
+dlp_node_t *bound_typed(binarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data, bool above, bool inclusive)
+{
+    dlp_node_t *walk = t->root;
+    dlp_node_t *bound = NULL;
+
+    while (walk != NULL) {
+        int order = compare_binarytree(t, key_type, key, data, walk);
+
+        if (order == 0 && inclusive)
+            return walk;
+
+        if (above ? order < 0 : order > 0) {
+            bound = walk;
+            walk = above ? walk->prev : walk->next;
+        } else
+            walk = above ? walk->next : walk->prev;
+    }
+
+    return bound;
+}
+
+static dlp_node_t *bound_binarytree(binarytree_t *const t, const void *const data,
+        bool above, bool inclusive)
+{
+    uint64_t key = key_binarytree(t, data);
+
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return bound_typed(t, BINARYTREE_KEY_INT64, key, data, above, inclusive);
+        case BINARYTREE_KEY_STRING:
+            return bound_typed(t, BINARYTREE_KEY_STRING, key, data, above, inclusive);
+        case BINARYTREE_KEY_CUSTOM:
+            return bound_typed(t, BINARYTREE_KEY_CUSTOM, key, data, above, inclusive);
+        default:
+            return bound_typed(t, BINARYTREE_KEY_ADDRESS, key, data, above, inclusive);
+    }
+}
+
+/**
+ * Count the nodes ordered before data on the way down, every step right
+ * passes a node and its prev subtree
+ */
+static inline __attribute__((always_inline))
+uint64_t rank_typed(binarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data)
+{
+    dlp_node_t *walk = t->root;
+    uint64_t rank = 0;
+
+    while (walk != NULL) {
+        int order = compare_binarytree(t, key_type, key, data, walk);
+
+        if (order == 0)
+            return rank + SIZE(walk->prev);
+
+        if (order > 0) {
+            rank += SIZE(walk->prev) + 1;
+            walk = walk->next;
+        } else
+            walk = walk->prev;
+    }
+
+    return rank;
+}
+
+static uint64_t rank_keyed(binarytree_t *const t, const void *const data)
+{
+    uint64_t key = key_binarytree(t, data);
+
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return rank_typed(t, BINARYTREE_KEY_INT64, key, data);
+        case BINARYTREE_KEY_STRING:
+            return rank_typed(t, BINARYTREE_KEY_STRING, key, data);
+        case BINARYTREE_KEY_CUSTOM:
+            return rank_typed(t, BINARYTREE_KEY_CUSTOM, key, data);
+        default:
+            return rank_typed(t, BINARYTREE_KEY_ADDRESS, key, data);
+    }
+}
+
+/**
+ * Binary tree - bulk sort
+ */
+struct sort_pair {
+    uint64_t key;
+    void *data;
+};
+
+/** Share of a parallel sort one thread works on */
+struct sort_job {
+    binarytree_t *t;
+    void *const *items;
+    struct sort_pair *pairs;        // keyed items, scratch after the scatter
+    struct sort_pair *sorted;       // items scattered into buckets
+    uint64_t begin, end;            // chunk of items of this job
+    uint64_t min, max;              // key range of the chunk, then of all items
+    uint32_t shift;                 // bits of key - min below the bucket
+    uint64_t buckets[256];          // bucket sizes, then scatter offsets
+    const uint64_t *bucket_start;   // first item of every bucket and the end
+    _Atomic uint32_t *next_bucket;  // next bucket to sort
+};
+
+enum sort_phase { SORT_KEYS, SORT_COUNT, SORT_SCATTER, SORT_BUCKETS };
+
+struct sort_thread {
+    struct sort_job *job;
+    enum sort_phase phase;
+};
+
+static int compare_ties(binarytree_t *const t, const void *a, const void *b)
+{
+    return t->key_type == BINARYTREE_KEY_STRING ? strcmp(a, b) : t->compare(a, b);
+}
+
+static void insertion_sort_pairs(binarytree_t *const t, struct sort_pair *a,
+        uint64_t n, bool ties)
+{
+    for (uint64_t i = 1; i < n; i++) {
+        struct sort_pair p = a[i];
+        uint64_t j = i;
+
+        while (j > 0 && (a[j - 1].key > p.key || (ties && a[j - 1].key == p.key
+                && compare_ties(t, a[j - 1].data, p.data) > 0))) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = p;
+    }
+}
+
+/**
+ * Order items sharing a cached key with the comparator, stable merge sort
+ * using scratch of the same size
+ */
+static void merge_sort_ties(binarytree_t *const t, struct sort_pair *a,
+        struct sort_pair *scratch, uint64_t n)
+{
+    if (n <= 16) {
+        insertion_sort_pairs(t, a, n, true);
+        return;
+    }
+
+    uint64_t half = n / 2;
+    merge_sort_ties(t, a, scratch, half);
+    merge_sort_ties(t, a + half, scratch + half, n - half);
+
+    uint64_t i = 0, j = half, k = 0;
+
+    while (i < half && j < n)
+        scratch[k++] = compare_ties(t, a[j].data, a[i].data) < 0 ? a[j++] : a[i++];
+    while (i < half)
+        scratch[k++] = a[i++];
+
+    memcpy(a, scratch, sizeof(*a) * k);
+}
+
+/**
+ * Sort a bucket on the key bits below its shift, least significant byte
+ * first. Bytes all items agree on are skipped, the result ends up in a.
+ */
+static void radix_sort_bucket(struct sort_job *const job, struct sort_pair *a,
+        struct sort_pair *scratch, uint64_t n)
+{
+    binarytree_t *t = job->t;
+    bool ties = t->key_type == BINARYTREE_KEY_STRING || t->key_type == BINARYTREE_KEY_CUSTOM;
+
+    if (n < 64)
+        insertion_sort_pairs(t, a, n, false);
+    else {
+        struct sort_pair *src = a, *dst = scratch, *swap;
+        uint64_t counts[256];
+
+        for (uint32_t bit = 0; bit < job->shift; bit += 8) {
+            memset(counts, 0, sizeof(counts));
+            for (uint64_t i = 0; i < n; i++)
+                counts[(src[i].key - job->min) >> bit & 0xff]++;
+
+            if (counts[(src[0].key - job->min) >> bit & 0xff] == n)
+                continue;
+
+            for (uint64_t b = 0, sum = 0; b < 256; b++) {
+                uint64_t c = counts[b];
+                counts[b] = sum;
+                sum += c;
+            }
+            for (uint64_t i = 0; i < n; i++)
+                dst[counts[(src[i].key - job->min) >> bit & 0xff]++] = src[i];
+
+            swap = src; src = dst; dst = swap;
+        }
+
+        if (src != a)
+            memcpy(a, src, sizeof(*a) * n);
+    }
+
+    if (!ties) return;
+
+    for (uint64_t i = 0, j; i < n; i = j) {
+        for (j = i + 1; j < n && a[j].key == a[i].key; j++);
+
+        if (j - i > 1)
+            merge_sort_ties(t, a + i, scratch + i, j - i);
+    }
+}
+
+static uint32_t sort_bucket(const struct sort_job *const job, uint64_t key)
+{
+    return (key - job->min) >> job->shift;
+}
+
+static void *run_sort_job(void *arg)
+{
+    struct sort_thread *st = arg;
+    struct sort_job *job = st->job;
+    uint64_t i, b;
+
+    switch (st->phase) {
+        case SORT_KEYS:
+            job->min = UINT64_MAX;
+            job->max = 0;
+
+            for (i = job->begin; i < job->end; i++) {
+                uint64_t key = key_binarytree(job->t, job->items[i]);
+
+                job->pairs[i].key = key;
+                job->pairs[i].data = job->items[i];
+                if (key < job->min) job->min = key;
+                if (key > job->max) job->max = key;
+            }
+            break;
+
+        case SORT_COUNT:
+            memset(job->buckets, 0, sizeof(job->buckets));
+            for (i = job->begin; i < job->end; i++)
+                job->buckets[sort_bucket(job, job->pairs[i].key)]++;
+            break;
+
+        case SORT_SCATTER:
+            for (i = job->begin; i < job->end; i++)
+                job->sorted[job->buckets[sort_bucket(job, job->pairs[i].key)]++] =
+                    job->pairs[i];
+            break;
+
+        case SORT_BUCKETS:
+            while ((b = atomic_fetch_add(job->next_bucket, 1)) < 256) {
+                uint64_t start = job->bucket_start[b];
+
+                radix_sort_bucket(job, job->sorted + start, job->pairs + start,
+                        job->bucket_start[b + 1] - start);
+            }
+            break;
+    }
+
+    return NULL;
+}
+
+/**
+ * Run a phase on every job, the calling thread takes the first one
+ */
+static void run_sort_phase(struct sort_job *jobs, uint32_t threads, enum sort_phase phase)
+{
+    pthread_t tid[BINARYTREE_SORT_THREADS];
+    struct sort_thread st[BINARYTREE_SORT_THREADS];
+    uint32_t started = 1;
+
+    for (uint32_t i = 0; i < threads; i++) {
+        st[i].job = &jobs[i];
+        st[i].phase = phase;
+    }
+
+    for (; started < threads; started++)
+        if (pthread_create(&tid[started], NULL, run_sort_job, &st[started]) != 0)
+            break;
+
+    run_sort_job(&st[0]);
+
+    // jobs no thread could be started for run here as well
+    for (uint32_t i = 1; i < threads; i++)
+        if (i < started)
+            pthread_join(tid[i], NULL);
+        else
+            run_sort_job(&st[i]);
+}
+
+static uint32_t sort_threads(uint64_t count)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t threads = count / BINARYTREE_SORT_PARALLEL;
+
+    if (cpus > 0 && threads > (uint64_t)cpus) threads = cpus;
+    if (threads > BINARYTREE_SORT_THREADS) threads = BINARYTREE_SORT_THREADS;
+
+    return threads > 0 ? threads : 1;
+}
+
+/**
+ * Sort items by cached key into 256 buckets on the highest bits the keys
+ * differ in, then radix sort every bucket on the remaining bits. Both run in
+ * parallel on large inputs. Items with equal keys get ordered with the
+ * comparator afterwards. Returns the sorted pairs, NULL if out of memory.
+ */
+static struct sort_pair *sort_pairs(binarytree_t *const t, void *const *items,
+        uint64_t count)
+{
+    uint32_t threads = sort_threads(count);
+    struct sort_job jobs[BINARYTREE_SORT_THREADS];
+    uint64_t bucket_start[257];
+    _Atomic uint32_t next_bucket = 0;
+    struct sort_pair *pairs = malloc(sizeof(*pairs) * count);
+    struct sort_pair *sorted = malloc(sizeof(*sorted) * count);
+
+    if (pairs == NULL || sorted == NULL) {
+        free(pairs);
+        free(sorted);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < threads; i++) {
+        jobs[i] = (struct sort_job) {
+            .t = t, .items = items, .pairs = pairs, .sorted = sorted,
+            .begin = count * i / threads, .end = count * (i + 1) / threads,
+            .bucket_start = bucket_start, .next_bucket = &next_bucket
+        };
+    }
+
+    run_sort_phase(jobs, threads, SORT_KEYS);
+
+    uint64_t min = UINT64_MAX, max = 0;
+
+    for (uint32_t i = 0; i < threads; i++) {
+        if (jobs[i].min < min) min = jobs[i].min;
+        if (jobs[i].max > max) max = jobs[i].max;
+    }
+
+    // keys share every bit above the width of max - min
+    uint32_t width = max > min ? 64 - __builtin_clzll(max - min) : 0;
+    uint32_t shift = width > 8 ? width - 8 : 0;
+
+    for (uint32_t i = 0; i < threads; i++) {
+        jobs[i].min = min;
+        jobs[i].shift = shift;
+    }
+
+    run_sort_phase(jobs, threads, SORT_COUNT);
+
+    // every job scatters behind the items of the same bucket of earlier jobs
+    uint64_t offset = 0;
+
+    for (uint32_t b = 0; b < 256; b++) {
+        bucket_start[b] = offset;
+
+        for (uint32_t i = 0; i < threads; i++) {
+            uint64_t size = jobs[i].buckets[b];
+            jobs[i].buckets[b] = offset;
+            offset += size;
+        }
+    }
+    bucket_start[256] = offset;
+
+    run_sort_phase(jobs, threads, SORT_SCATTER);
+    run_sort_phase(jobs, threads, SORT_BUCKETS);
+
+    free(pairs);
+    return sorted;
+}
+
+static bool equal_pairs(binarytree_t *const t, const struct sort_pair *a,
+        const struct sort_pair *b)
+{
+    if (a->key != b->key)
+        return false;
+
+    switch (t->key_type) {
+        case BINARYTREE_KEY_STRING:
+        case BINARYTREE_KEY_CUSTOM:
+            return compare_ties(t, a->data, b->data) == 0;
+        default:
+            return true;
+    }
+}
+
+/**
+ * Drop sorted pairs equal to their predecessor, returns the number kept
+ */
+static uint64_t unique_pairs(binarytree_t *const t, struct sort_pair *sorted,
+        uint64_t count)
+{
+    uint64_t unique = 0;
+
+    for (uint64_t i = 0; i < count; i++)
+        if (unique == 0 || !equal_pairs(t, &sorted[unique - 1], &sorted[i]))
+            sorted[unique++] = sorted[i];
+
+    return unique;
+}
+
+uint64_t sort_binarytree_array(binarytree_t *const t, void **const items, uint64_t count)
+{
+    if (count == 0) return 0;
+
+    struct sort_pair *sorted = sort_pairs(t, items, count);
+
+    if (sorted == NULL) return 0;
+
+    uint64_t unique = unique_pairs(t, sorted, count);
+
+    for (uint64_t i = 0; i < unique; i++)
+        items[i] = sorted[i].data;
+
+    free(sorted);
+    return unique;
+}
+
+
+/**
+ * Binary tree - balancing
+ */
+#define IS_RED(n) ((n) != NULL && (n)->color == NODE_RED)
+
+/**
+ * Node rotated up takes over the subtree size of n, n is counted again
+ */
+static void resize_rotated(dlp_node_t *const n, dlp_node_t *const up)
+{
+    up->size = n->size;
+    n->size = SIZE(n->prev) + SIZE(n->next) + 1;
+}
+
+static void replace_child(binarytree_t *const t, dlp_node_t *const n,
+        dlp_node_t *const child)
+{
+    if (n->parent == NULL)
+        t->root = child;
+    else if (n->parent->prev == n)
+        n->parent->prev = child;
+    else
+        n->parent->next = child;
+
+    if (child != NULL)
+        child->parent = n->parent;
+}
+
+static void rotate_prev(binarytree_t *const t, dlp_node_t *const n)
+{
+    dlp_node_t *up = n->next;
+
+    n->next = up->prev;
+    if (up->prev != NULL)
+        up->prev->parent = n;
+
+    replace_child(t, n, up);
+    up->prev = n;
+    n->parent = up;
+    resize_rotated(n, up);
+}
+
+static void rotate_next(binarytree_t *const t, dlp_node_t *const n)
+{
+    dlp_node_t *up = n->prev;
+
+    n->prev = up->next;
+    if (up->next != NULL)
+        up->next->parent = n;
+
+    replace_child(t, n, up);
+    up->next = n;
+    n->parent = up;
+    resize_rotated(n, up);
+}
+
+/**
+ * Rotate n up to the root, two levels at a time. Lifting the parent first on
+ * a straight line roughly halves the depth of every node on the path.
+ */
+static void splay_binarytree(binarytree_t *const t, dlp_node_t *const n)
+{
+    while (n->parent != NULL) {
+        dlp_node_t *parent = n->parent;
+        dlp_node_t *grand = parent->parent;
+        bool prev = n == parent->prev;
+
+        if (grand != NULL && prev == (parent == grand->prev)) {
+            // zig-zig
+            if (prev) rotate_next(t, grand);
+            else rotate_prev(t, grand);
+        }
+
+        // zig, second half of zig-zig or first half of zig-zag
+        if (prev) rotate_next(t, parent);
+        else rotate_prev(t, parent);
+
+        if (grand != NULL && n->parent == grand) {
+            // rest of zig-zag
+            if (n == grand->prev) rotate_next(t, grand);
+            else rotate_prev(t, grand);
+        }
+    }
+}
+
+static void balance_added(binarytree_t *const t, dlp_node_t *n)
+{
+    // n is red, fix a red parent by recoloring upwards or rotating once
+    while (IS_RED(n->parent)) {
+        dlp_node_t *parent = n->parent;
+        dlp_node_t *grand = parent->parent;
+
+        if (parent == grand->prev) {
+            dlp_node_t *uncle = grand->next;
+
+            if (IS_RED(uncle)) {
+                parent->color = uncle->color = NODE_BLACK;
+                grand->color = NODE_RED;
+                n = grand;
+                continue;
+            }
+
+            if (n == parent->next) {
+                rotate_prev(t, parent);
+                n = parent;
+                parent = n->parent;
+            }
+
+            parent->color = NODE_BLACK;
+            grand->color = NODE_RED;
+            rotate_next(t, grand);
+        } else {
+            dlp_node_t *uncle = grand->prev;
+
+            if (IS_RED(uncle)) {
+                parent->color = uncle->color = NODE_BLACK;
+                grand->color = NODE_RED;
+                n = grand;
+                continue;
+            }
+
+            if (n == parent->prev) {
+                rotate_next(t, parent);
+                n = parent;
+                parent = n->parent;
+            }
+
+            parent->color = NODE_BLACK;
+            grand->color = NODE_RED;
+            rotate_prev(t, grand);
+        }
+    }
+
+    t->root->color = NODE_BLACK;
+}
+
+static void balance_deleted(binarytree_t *const t, dlp_node_t *n, dlp_node_t *parent)
+{
+    // n carries an extra black, n may be NULL so its parent is passed along
+    while (n != t->root && !IS_RED(n)) {
+        if (n == parent->prev) {
+            dlp_node_t *sibling = parent->next;
+
+            if (IS_RED(sibling)) {
+                sibling->color = NODE_BLACK;
+                parent->color = NODE_RED;
+                rotate_prev(t, parent);
+                sibling = parent->next;
+            }
+
+            if (!IS_RED(sibling->prev) && !IS_RED(sibling->next)) {
+                sibling->color = NODE_RED;
+                n = parent;
+                parent = n->parent;
+                continue;
+            }
+
+            if (!IS_RED(sibling->next)) {
+                sibling->prev->color = NODE_BLACK;
+                sibling->color = NODE_RED;
+                rotate_next(t, sibling);
+                sibling = parent->next;
+            }
+
+            sibling->color = parent->color;
+            parent->color = NODE_BLACK;
+            sibling->next->color = NODE_BLACK;
+            rotate_prev(t, parent);
+        } else {
+            dlp_node_t *sibling = parent->prev;
+
+            if (IS_RED(sibling)) {
+                sibling->color = NODE_BLACK;
+                parent->color = NODE_RED;
+                rotate_next(t, parent);
+                sibling = parent->prev;
+            }
+
+            if (!IS_RED(sibling->prev) && !IS_RED(sibling->next)) {
+                sibling->color = NODE_RED;
+                n = parent;
+                parent = n->parent;
+                continue;
+            }
+
+            if (!IS_RED(sibling->prev)) {
+                sibling->next->color = NODE_BLACK;
+                sibling->color = NODE_RED;
+                rotate_prev(t, sibling);
+                sibling = parent->prev;
+            }
+
+            sibling->color = parent->color;
+            parent->color = NODE_BLACK;
+            sibling->prev->color = NODE_BLACK;
+            rotate_next(t, parent);
+        }
+
+        n = t->root;
+    }
+
+    if (n != NULL)
+        n->color = NODE_BLACK;
+}
+
+
+/**
+ * Binary tree - iteration
+ */
+dlp_node_t *first_binarytree(binarytree_t *const t)
+{
+    dlp_node_t *n = t->root;
+
+    while (n != NULL && n->prev != NULL)
+        n = n->prev;
+
+    return n;
+}
+
+dlp_node_t *last_binarytree(binarytree_t *const t)
+{
+    dlp_node_t *n = t->root;
+
+    while (n != NULL && n->next != NULL)
+        n = n->next;
+
+    return n;
+}
+
+dlp_node_t *next_binarytree(dlp_node_t *n)
+{
+    if (n->next != NULL) {
+        for (n = n->next; n->prev != NULL; n = n->prev);
+        return n;
+    }
+
+    // climb until coming up from a prev subtree
+    while (n->parent != NULL && n->parent->next == n)
+        n = n->parent;
+
+    return n->parent;
+}
+
+dlp_node_t *prev_binarytree(dlp_node_t *n)
+{
+    if (n->prev != NULL) {
+        for (n = n->prev; n->next != NULL; n = n->next);
+        return n;
+    }
+
+    while (n->parent != NULL && n->parent->prev == n)
+        n = n->parent;
+
+    return n->parent;
+}
+
+dlp_node_t *seek_binarytree(binarytree_t *const t, void *const data)
+{
+    return bound_binarytree(t, data, true, true);
+}
+
+uint64_t scan_binarytree(binarytree_t *const t, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data)
+{
+    dlp_node_t *n = low != NULL ? seek_binarytree(t, low) : first_binarytree(t);
+    uint64_t high_key = high != NULL ? key_binarytree(t, high) : 0;
+    uint64_t scanned = 0;
+
+    for (; n != NULL; n = next_binarytree(n)) {
+        if (high != NULL && compare_binarytree(t, t->key_type, high_key, high, n) <= 0)
+            break;
+
+        scanned++;
+        if (!func(n->data, func_data))
+            break;
+    }
+
+    return scanned;
+}
+
+
+/**
+ * Binary tree - core
+ */
+
 void *lowest_binarytree(binarytree_t *const t)
 {
     if (t->root == NULL)
@@ -44,81 +890,293 @@ void *highest_binarytree(binarytree_t *const t)
 
 int8_t add_binarytree(binarytree_t *const t, void *const data)
 {
-    if (t->root == NULL) {
-        t->root = create_dlpnode(data);
-        return 1;
+    uint64_t key = key_binarytree(t, data);
+    dlp_node_t *parent;
+    dlp_node_t **link = descend_binarytree(t, key, data, &parent);
+
+    if (*link != NULL) {
+        if (t->mode == BINARYTREE_SPLAY)
+            splay_binarytree(t, *link);
+        return 0;
     }
 
-    dlp_node_t *current = t->root;
+    dlp_node_t *n = alloc_dlpnode(t->pool, data);
+    n->key = key;
+    n->parent = parent;
+    *link = n;
 
-    while (1) {
-        if (current->data == data)
-            return 0;
-        else if (current->data > data) {
-            if (current->prev == NULL) {
-                current->prev = create_dlpnode(data);
-                current->prev->parent = current;
-                return 1;
-            }
-            else current = current->prev;
-        }
+    for (; parent != NULL; parent = parent->parent)
+        parent->size++;
+
+    if (t->mode == BINARYTREE_REDBLACK)
+        balance_added(t, n);
+    else if (t->mode == BINARYTREE_SPLAY)
+        splay_binarytree(t, n);
+
+    return 1;
+}
+
+dlp_node_t *search_binarytree(binarytree_t *const t, void *const data)
+{
+    dlp_node_t *parent;
+    dlp_node_t *found = *descend_binarytree(t, key_binarytree(t, data), data, &parent);
+
+    // a miss splays the node it ended at
+    if (t->mode == BINARYTREE_SPLAY && (found != NULL || parent != NULL))
+        splay_binarytree(t, found != NULL ? found : parent);
+
+    return found;
+}
+
+dlp_node_t *find_binarytree(dlp_node_t *const n, void *const data)
+{
+    dlp_node_t *walk = n;
+
+    while (walk != NULL && walk->data != data)
+        walk = walk->data > data ? walk->prev : walk->next;
+
+    return walk;
+}
+
+void *lower_bound_binarytree(binarytree_t *const t, void *const data)
+{
+    dlp_node_t *n = bound_binarytree(t, data, true, true);
+    return n != NULL ? n->data : NULL;
+}
+
+void *upper_bound_binarytree(binarytree_t *const t, void *const data)
+{
+    dlp_node_t *n = bound_binarytree(t, data, true, false);
+    return n != NULL ? n->data : NULL;
+}
+
+void *floor_binarytree(binarytree_t *const t, void *const data)
+{
+    dlp_node_t *n = bound_binarytree(t, data, false, true);
+    return n != NULL ? n->data : NULL;
+}
+
+void *ceiling_binarytree(binarytree_t *const t, void *const data)
+{
+    return lower_bound_binarytree(t, data);
+}
+
+uint64_t count_binarytree(binarytree_t *const t)
+{
+    return SIZE(t->root);
+}
+
+uint64_t rank_binarytree(binarytree_t *const t, void *const data)
+{
+    return rank_keyed(t, data);
+}
+
+void *select_binarytree(binarytree_t *const t, uint64_t k)
+{
+    dlp_node_t *walk = t->root;
+
+    while (walk != NULL) {
+        uint64_t before = SIZE(walk->prev);
+
+        if (k == before)
+            return walk->data;
+
+        if (k < before)
+            walk = walk->prev;
         else {
-            if (current->next == NULL) {
-                current->next = create_dlpnode(data);
-                current->next->parent = current;
-                return 1;
-            }
-            else current = current->next;
+            k -= before + 1;
+            walk = walk->next;
         }
     }
+
+    return NULL;
 }
 
-dlp_node_t *find_binarytree(dlp_node_t *const n, void *const data)
+uint64_t count_range_binarytree(binarytree_t *const t, void *const low,
+        void *const high)
 {
-    if (n == NULL) return NULL;
-    if (n->data == data) return n;
-    
-    dlp_node_t *walk = find_binarytree(n->prev, data);
-
-    if (walk != NULL) return walk;
+    uint64_t from = low != NULL ? rank_keyed(t, low) : 0;
+    uint64_t to = high != NULL ? rank_keyed(t, high) : SIZE(t->root);
 
-    return find_binarytree(n->next, data);
+    return to > from ? to - from : 0;
 }
 
 int8_t del_binarytree(binarytree_t *const t, void *const data)
 {
-    dlp_node_t *found = find_binarytree(t->root, data);
+    dlp_node_t *found = search_binarytree(t, data);
 
     if (found == NULL) return -1;
-   
-    // move up right side of this node to keep tree left-heavy
-    while (found->next != NULL) {
-        found->next->parent = found->parent;
-        found->prev->parent = found->next;
+
+    // child takes the place of whatever node leaves its position
+    dlp_node_t *child, *parent;
+    uint8_t removed = found->color;
+
+    if (found->prev == NULL || found->next == NULL) {
+        child = found->prev != NULL ? found->prev : found->next;
+        parent = found->parent;
+
+        for (dlp_node_t *up = parent; up != NULL; up = up->parent)
+            up->size--;
+
+        replace_child(t, found, child);
+    } else {
+        // the in-order successor moves into the position of found
+        dlp_node_t *successor = found->next;
+
+        while (successor->prev != NULL)
+            successor = successor->prev;
+
+        removed = successor->color;
+        child = successor->next;
+
+        // found is on the path and hands its size on to successor
+        for (dlp_node_t *up = successor->parent; up != NULL; up = up->parent)
+            up->size--;
+
+        if (successor->parent == found)
+            parent = successor;
+        else {
+            parent = successor->parent;
+            replace_child(t, successor, child);
+            successor->next = found->next;
+            successor->next->parent = successor;
+        }
+
+        replace_child(t, found, successor);
+        successor->prev = found->prev;
+        successor->prev->parent = successor;
+        successor->color = found->color;
+        successor->size = found->size;
     }
 
-    // our while loop did no modifications so we move up left node
-    if (found->data == data) {
-        found->prev->parent = found->parent;
-        found = found->prev;
+    if (t->mode == BINARYTREE_REDBLACK && removed == NODE_BLACK)
+        balance_deleted(t, child, parent);
+    else if (t->mode == BINARYTREE_SPLAY && parent != NULL)
+        splay_binarytree(t, parent);
+
+    release_dlpnode(t->pool, found);
+    return 1;
+}
+
+int8_t build_binarytree_from_array(binarytree_t *const t, void *const *items,
+        uint64_t count)
+{
+    if (t->root != NULL) return -1;
+    if (count == 0) return 1;
+
+    struct sort_pair *sorted = sort_pairs(t, items, count);
+
+    if (sorted == NULL) return -1;
+
+    uint64_t unique = unique_pairs(t, sorted, count);
+
+    // every node goes into one slab, handed out in breadth first order
+    struct build_range {
+        uint64_t low, high;
+        dlp_node_t *node;
+    } *queue = malloc(sizeof(*queue) * unique);
+    node_pool_t *pool = create_node_pool(sizeof(dlp_node_t),
+            unique > NODE_ARENA_SLAB && unique <= UINT32_MAX ? unique : NODE_ARENA_SLAB);
+
+    if (queue == NULL || pool == NULL) {
+        free(queue);
+        free_node_pool(pool);
+        free(sorted);
+        return -1;
     }
 
-    return 1;    
+    if (t->pool != NULL && t->pool->shared < 0)
+        free_node_pool(t->pool);
+    t->pool = pool;
+
+    // levels above the last one are complete, nodes on the last one are red
+    uint64_t complete = 1;
+
+    while (complete * 2 + 1 <= unique)
+        complete = complete * 2 + 1;
+
+    uint64_t tail = 1;
+
+    queue[0] = (struct build_range) { 0, unique, alloc_dlpnode(pool, NULL) };
+    t->root = queue[0].node;
+
+    for (uint64_t i = 0; i < unique; i++) {
+        struct build_range r = queue[i];
+        uint64_t mid = r.low + (r.high - r.low) / 2;
+        dlp_node_t *n = r.node;
+
+        n->data = sorted[mid].data;
+        n->key = sorted[mid].key;
+        n->color = i < complete ? NODE_BLACK : NODE_RED;
+        n->size = r.high - r.low;
+
+        if (r.low < mid) {
+            n->prev = alloc_dlpnode(pool, NULL);
+            n->prev->parent = n;
+            queue[tail++] = (struct build_range) { r.low, mid, n->prev };
+        }
+        if (mid + 1 < r.high) {
+            n->next = alloc_dlpnode(pool, NULL);
+            n->next->parent = n;
+            queue[tail++] = (struct build_range) { mid + 1, r.high, n->next };
+        }
+    }
+
+    free(queue);
+    free(sorted);
+    return 1;
+}
+
+/**
+ * Release a subtree children first without a stack: a node without children
+ * goes and unlinks itself, then the walk continues at its parent
+ */
+static void release_sub_binarytree(node_pool_t *const p, dlp_node_t *n, bool data)
+{
+    dlp_node_t *stop = n != NULL ? n->parent : NULL;
+
+    while (n != NULL) {
+        if (n->prev != NULL)
+            n = n->prev;
+        else if (n->next != NULL)
+            n = n->next;
+        else {
+            dlp_node_t *parent = n->parent;
+
+            if (parent != stop) {
+                if (parent->prev == n) parent->prev = NULL;
+                else parent->next = NULL;
+            }
+
+            if (data) free_dlpnode(n);
+            else release_dlpnode(p, n);
+
+            n = parent != stop ? parent : NULL;
+        }
+    }
 }
 
 void free_sub_binarytree(dlp_node_t *start)
 {
-    if (start == NULL) return;
+    release_sub_binarytree(NULL, start, true);
+}
 
-    free_sub_binarytree(start->prev);
-    free_sub_binarytree(start->next);
-    
-    free_dlpnode(start);
+void reset_binarytree(binarytree_t *const t)
+{
+    if (t->pool != NULL && t->pool->shared < 0)
+        reset_node_pool(t->pool);
+    else
+        release_sub_binarytree(t->pool, t->root, false);
+
+    t->root = NULL;
 }
 
 void free_binarytree(binarytree_t *t)
 {
-    if (t->root == NULL) return;
-    free_sub_binarytree(t->root);
-    if (t != NULL) free(t);
+    if (t->pool != NULL && t->pool->shared < 0)
+        free_node_pool(t->pool); // Arena, nodes go with their slabs
+    else
+        release_sub_binarytree(t->pool, t->root, false);
+
+    free(t);
 }
@@ -0,0 +1,964 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Values of a container up to which a sorted array beats a bitset */
+#define BITMAP_ARRAY_MAX 4096
+
+/** 64-bit words of a bitset container, one bit per low 16-bit value */
+#define BITMAP_WORDS 1024
+
+/** Bytes of a bitset container, no other container may grow beyond */
+#define BITMAP_BITS_BYTES (BITMAP_WORDS * sizeof(uint64_t))
+
+enum bitmap_type {
+    BITMAP_ARRAY,   // sorted uint16_t values
+    BITMAP_BITS,    // BITMAP_WORDS words
+    BITMAP_RUNS     // sorted bitmap_runs
+};
+
+struct bitmap_run {
+    uint16_t start;
+    uint16_t last;
+};
+
+/**
+ * Low 16 bits of the values sharing their high 16 bits
+ */
+struct bitmap_container {
+    void *data;         /**< values, words or runs by type */
+    uint32_t count;     /**< number of values */
+    uint32_t size;      /**< values of an array, runs of a run container */
+    uint32_t capacity;  /**< values or runs data has room for */
+    uint8_t type;       /**< bitmap_type of container */
+};
+
+
+/**
+ * Bitmap - words
+ */
+#ifdef __SSE2__
+static inline __m128i popcount_bytes(__m128i v)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+    return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+}
+#endif
+
+/**
+ * And or or two bitsets into out, NULL to only count, returns the number of
+ * bits set in the result
+ */
+static inline __attribute__((always_inline))
+uint32_t combine_words(uint64_t *out, const uint64_t *a, const uint64_t *b, const bool and)
+{
+#ifdef __SSE2__
+    __m128i sum = _mm_setzero_si128();
+    uint64_t lanes[2];
+
+    for (int i = 0; i < BITMAP_WORDS; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i v = and ? _mm_and_si128(x, y) : _mm_or_si128(x, y);
+
+        if (out != NULL)
+            _mm_storeu_si128((__m128i *)(out + i), v);
+
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(popcount_bytes(v), _mm_setzero_si128()));
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    return lanes[0] + lanes[1];
+#else
+    uint32_t count = 0;
+
+    for (int i = 0; i < BITMAP_WORDS; i++) {
+        uint64_t v = and ? a[i] & b[i] : a[i] | b[i];
+
+        if (out != NULL) out[i] = v;
+        count += __builtin_popcountll(v);
+    }
+
+    return count;
+#endif
+}
+
+static void set_range(uint64_t *words, uint32_t start, uint32_t last)
+{
+    for (uint32_t w = start >> 6; w <= last >> 6; w++) {
+        uint64_t mask = ~0ULL;
+
+        if (w == start >> 6) mask &= ~0ULL << (start & 63);
+        if (w == last >> 6) mask &= ~0ULL >> (63 - (last & 63));
+        words[w] |= mask;
+    }
+}
+
+static bool test_word(const uint64_t *words, uint16_t low)
+{
+    return words[low >> 6] >> (low & 63) & 1;
+}
+
+
+/**
+ * Bitmap - containers
+ */
+static uint16_t *values_of(const struct bitmap_container *c)
+{
+    return c->data;
+}
+
+static uint64_t *words_of(const struct bitmap_container *c)
+{
+    return c->data;
+}
+
+static struct bitmap_run *runs_of(const struct bitmap_container *c)
+{
+    return c->data;
+}
+
+static size_t container_bytes(const struct bitmap_container *c)
+{
+    switch (c->type) {
+        case BITMAP_BITS: return BITMAP_BITS_BYTES;
+        case BITMAP_RUNS: return c->capacity * sizeof(struct bitmap_run);
+        default:          return c->capacity * sizeof(uint16_t);
+    }
+}
+
+/**
+ * Room for capacity values or runs of a given size, growing by doubling
+ */
+static int8_t reserve_container(struct bitmap_container *c, uint32_t capacity, size_t item)
+{
+    if (capacity <= c->capacity) return 1;
+
+    uint32_t grown = c->capacity > 0 ? c->capacity * 2 : 4;
+
+    if (grown < capacity) grown = capacity;
+    if (grown * item > BITMAP_BITS_BYTES && capacity * item <= BITMAP_BITS_BYTES)
+        grown = BITMAP_BITS_BYTES / item;
+
+    void *data = realloc(c->data, grown * item);
+
+    if (data == NULL) return -1;
+
+    c->data = data;
+    c->capacity = grown;
+    return 1;
+}
+
+/**
+ * First index of a sorted array not below low
+ */
+static uint32_t lower_bound_values(const uint16_t *values, uint32_t n, uint16_t low)
+{
+    uint32_t lo = 0, hi = n;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (values[mid] < low) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * Index of the last run starting at or before low, -1 if none does
+ */
+static int32_t find_run(const struct bitmap_container *c, uint16_t low)
+{
+    const struct bitmap_run *runs = runs_of(c);
+    uint32_t lo = 0, hi = c->size;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (runs[mid].start <= low) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return (int32_t)lo - 1;
+}
+
+static uint32_t count_runs(const struct bitmap_container *c)
+{
+    uint32_t runs = 0;
+
+    if (c->type == BITMAP_RUNS) return c->size;
+
+    if (c->type == BITMAP_ARRAY) {
+        const uint16_t *values = values_of(c);
+
+        for (uint32_t i = 0; i < c->count; i++)
+            runs += i == 0 || values[i] != values[i - 1] + 1;
+        return runs;
+    }
+
+    // a run starts at every set bit whose lower neighbour is clear
+    const uint64_t *words = words_of(c);
+    uint64_t carry = 0;
+
+    for (int i = 0; i < BITMAP_WORDS; i++) {
+        runs += __builtin_popcountll(words[i] & ~(words[i] << 1 | carry));
+        carry = words[i] >> 63;
+    }
+
+    return runs;
+}
+
+/**
+ * Bitset with the values of c in out, c is unchanged
+ */
+static int8_t expand_container(const struct bitmap_container *c, struct bitmap_container *out)
+{
+    uint64_t *words = calloc(BITMAP_WORDS, sizeof(*words));
+
+    if (words == NULL) return -1;
+
+    if (c->type == BITMAP_BITS)
+        memcpy(words, c->data, BITMAP_BITS_BYTES);
+    else if (c->type == BITMAP_RUNS)
+        for (uint32_t i = 0; i < c->size; i++)
+            set_range(words, runs_of(c)[i].start, runs_of(c)[i].last);
+    else
+        for (uint32_t i = 0; i < c->count; i++)
+            words[values_of(c)[i] >> 6] |= 1ULL << (values_of(c)[i] & 63);
+
+    *out = (struct bitmap_container) {
+        .data = words,
+        .count = c->count,
+        .type = BITMAP_BITS
+    };
+    return 1;
+}
+
+/**
+ * Add a value above all runs of a container with room for it
+ */
+static void append_run(struct bitmap_container *c, uint16_t low)
+{
+    struct bitmap_run *runs = runs_of(c);
+
+    if (c->size > 0 && (uint32_t)runs[c->size - 1].last + 1 == low)
+        runs[c->size - 1].last = low;
+    else
+        runs[c->size++] = (struct bitmap_run) { low, low };
+}
+
+/**
+ * Store a container as type, returns -1 if out of memory and leaves it as is
+ */
+static int8_t convert_container(struct bitmap_container *c, uint8_t type)
+{
+    struct bitmap_container out = { .type = type };
+
+    if (c->type == type) return 1;
+
+    if (type == BITMAP_BITS) {
+        if (expand_container(c, &out) < 0) return -1;
+    } else if (type == BITMAP_ARRAY) {
+        if (reserve_container(&out, c->count, sizeof(uint16_t)) < 0) return -1;
+
+        uint16_t *values = values_of(&out);
+
+        if (c->type == BITMAP_RUNS)
+            for (uint32_t i = 0; i < c->size; i++)
+                for (uint32_t v = runs_of(c)[i].start; v <= runs_of(c)[i].last; v++)
+                    values[out.size++] = v;
+        else
+            for (int w = 0; w < BITMAP_WORDS; w++)
+                for (uint64_t bits = words_of(c)[w]; bits != 0; bits &= bits - 1)
+                    values[out.size++] = w * 64 + __builtin_ctzll(bits);
+    } else {
+        if (reserve_container(&out, count_runs(c), sizeof(struct bitmap_run)) < 0)
+            return -1;
+
+        if (c->type == BITMAP_ARRAY)
+            for (uint32_t i = 0; i < c->count; i++)
+                append_run(&out, values_of(c)[i]);
+        else
+            for (int w = 0; w < BITMAP_WORDS; w++)
+                for (uint64_t bits = words_of(c)[w]; bits != 0; bits &= bits - 1)
+                    append_run(&out, w * 64 + __builtin_ctzll(bits));
+    }
+
+    out.count = c->count;
+    free(c->data);
+    *c = out;
+    return 1;
+}
+
+/**
+ * Store a container in whichever type takes the fewest bytes
+ */
+static int8_t shrink_container(struct bitmap_container *c)
+{
+    size_t runs = count_runs(c) * sizeof(struct bitmap_run);
+    size_t array = c->count <= BITMAP_ARRAY_MAX ? c->count * sizeof(uint16_t) :
+        BITMAP_BITS_BYTES + 1;
+
+    if (runs < array && runs < BITMAP_BITS_BYTES)
+        return convert_container(c, BITMAP_RUNS);
+    if (array <= BITMAP_BITS_BYTES)
+        return convert_container(c, BITMAP_ARRAY);
+    return convert_container(c, BITMAP_BITS);
+}
+
+static bool contains_container(const struct bitmap_container *c, uint16_t low)
+{
+    uint32_t pos;
+    int32_t run;
+
+    switch (c->type) {
+        case BITMAP_BITS:
+            return test_word(words_of(c), low);
+        case BITMAP_RUNS:
+            run = find_run(c, low);
+            return run >= 0 && low <= runs_of(c)[run].last;
+        default:
+            pos = lower_bound_values(values_of(c), c->size, low);
+            return pos < c->size && values_of(c)[pos] == low;
+    }
+}
+
+static int8_t add_run(struct bitmap_container *c, uint16_t low)
+{
+    int32_t i = find_run(c, low);
+    struct bitmap_run *runs = runs_of(c);
+    bool extends = i >= 0 && (uint32_t)runs[i].last + 1 == low;
+    bool precedes = (uint32_t)(i + 1) < c->size && (uint32_t)low + 1 == runs[i + 1].start;
+
+    if (i >= 0 && low <= runs[i].last) return 0;
+
+    if (extends && precedes) {
+        // low joins two runs
+        runs[i].last = runs[i + 1].last;
+        memmove(runs + i + 1, runs + i + 2, sizeof(*runs) * (c->size - i - 2));
+        c->size--;
+    } else if (extends)
+        runs[i].last = low;
+    else if (precedes)
+        runs[i + 1].start = low;
+    else {
+        if (reserve_container(c, c->size + 1, sizeof(*runs)) < 0) return -1;
+
+        runs = runs_of(c);
+        memmove(runs + i + 2, runs + i + 1, sizeof(*runs) * (c->size - i - 1));
+        runs[i + 1] = (struct bitmap_run) { low, low };
+        c->size++;
+    }
+
+    c->count++;
+    return 1;
+}
+
+static int8_t del_run(struct bitmap_container *c, uint16_t low)
+{
+    int32_t i = find_run(c, low);
+    struct bitmap_run *runs = runs_of(c);
+
+    if (i < 0 || low > runs[i].last) return -1;
+
+    if (runs[i].start == runs[i].last) {
+        memmove(runs + i, runs + i + 1, sizeof(*runs) * (c->size - i - 1));
+        c->size--;
+    } else if (low == runs[i].start)
+        runs[i].start++;
+    else if (low == runs[i].last)
+        runs[i].last--;
+    else {
+        // low splits its run in two
+        if (reserve_container(c, c->size + 1, sizeof(*runs)) < 0) return -1;
+
+        runs = runs_of(c);
+        memmove(runs + i + 2, runs + i + 1, sizeof(*runs) * (c->size - i - 1));
+        runs[i + 1] = (struct bitmap_run) { low + 1, runs[i].last };
+        runs[i].last = low - 1;
+        c->size++;
+    }
+
+    c->count--;
+    return 1;
+}
+
+static int8_t add_container(struct bitmap_container *c, uint16_t low)
+{
+    uint64_t *words;
+    uint16_t *values;
+    uint32_t pos;
+    int8_t result;
+
+    switch (c->type) {
+        case BITMAP_BITS:
+            words = words_of(c);
+            if (test_word(words, low)) return 0;
+
+            words[low >> 6] |= 1ULL << (low & 63);
+            c->count++;
+            return 1;
+
+        case BITMAP_RUNS:
+            result = add_run(c, low);
+
+            // scattered values outgrow a bitset as runs
+            if (result > 0 && c->size * sizeof(struct bitmap_run) > BITMAP_BITS_BYTES &&
+                    shrink_container(c) < 0)
+                return -1;
+            return result;
+
+        default:
+            values = values_of(c);
+
+            // ascending values append
+            if (c->size > 0 && values[c->size - 1] < low)
+                pos = c->size;
+            else
+                pos = lower_bound_values(values, c->size, low);
+
+            if (pos < c->size && values[pos] == low) return 0;
+
+            if (c->size == BITMAP_ARRAY_MAX) {
+                if (convert_container(c, BITMAP_BITS) < 0) return -1;
+                return add_container(c, low);
+            }
+
+            if (reserve_container(c, c->size + 1, sizeof(*values)) < 0) return -1;
+
+            values = values_of(c);
+            memmove(values + pos + 1, values + pos, sizeof(*values) * (c->size - pos));
+            values[pos] = low;
+            c->size++;
+            c->count++;
+            return 1;
+    }
+}
+
+static int8_t del_container(struct bitmap_container *c, uint16_t low)
+{
+    uint64_t *words;
+    uint16_t *values;
+    uint32_t pos;
+
+    switch (c->type) {
+        case BITMAP_BITS:
+            words = words_of(c);
+            if (!test_word(words, low)) return -1;
+
+            words[low >> 6] &= ~(1ULL << (low & 63));
+            c->count--;
+
+            // failing to shrink leaves a valid bitset
+            if (c->count <= BITMAP_ARRAY_MAX)
+                convert_container(c, BITMAP_ARRAY);
+            return 1;
+
+        case BITMAP_RUNS:
+            return del_run(c, low);
+
+        default:
+            values = values_of(c);
+            pos = lower_bound_values(values, c->size, low);
+
+            if (pos == c->size || values[pos] != low) return -1;
+
+            memmove(values + pos, values + pos + 1, sizeof(*values) * (c->size - pos - 1));
+            c->size--;
+            c->count--;
+            return 1;
+    }
+}
+
+static int8_t copy_container(const struct bitmap_container *c, struct bitmap_container *out)
+{
+    size_t bytes = c->type == BITMAP_BITS ? BITMAP_BITS_BYTES :
+        c->type == BITMAP_RUNS ? c->size * sizeof(struct bitmap_run) :
+        c->size * sizeof(uint16_t);
+
+    *out = *c;
+    out->capacity = c->type == BITMAP_BITS ? 0 : c->size;
+    out->data = malloc(bytes > 0 ? bytes : 1);
+
+    if (out->data == NULL) return -1;
+
+    memcpy(out->data, c->data, bytes);
+    return 1;
+}
+
+/**
+ * Values of two sorted arrays in both (and) or in any of them, out has room
+ * for na + nb values, returns the number of values written
+ */
+static uint32_t merge_values(const uint16_t *a, uint32_t na, const uint16_t *b,
+        uint32_t nb, bool and, uint16_t *out)
+{
+    uint32_t i = 0, j = 0, n = 0;
+
+    if (and && (na > 32 * nb || nb > 32 * na)) {
+        // look the values of the short array up in the long one
+        const uint16_t *s = na < nb ? a : b, *l = na < nb ? b : a;
+        uint32_t ns = na < nb ? na : nb, nl = na < nb ? nb : na;
+
+        for (; i < ns && j < nl; i++) {
+            j += lower_bound_values(l + j, nl - j, s[i]);
+
+            if (j < nl && l[j] == s[i])
+                out[n++] = s[i];
+        }
+
+        return n;
+    }
+
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            if (!and) out[n++] = a[i];
+            i++;
+        } else if (a[i] > b[j]) {
+            if (!and) out[n++] = b[j];
+            j++;
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    for (; !and && i < na; i++) out[n++] = a[i];
+    for (; !and && j < nb; j++) out[n++] = b[j];
+
+    return n;
+}
+
+/**
+ * Intersection (and) or union of two containers into an empty one
+ */
+static int8_t combine_containers(const struct bitmap_container *a,
+        const struct bitmap_container *b, bool and, struct bitmap_container *out)
+{
+    struct bitmap_container ea, eb;
+    int8_t result = 1;
+
+    *out = (struct bitmap_container) { .type = BITMAP_ARRAY };
+
+    // runs take part as bitsets, the result picks its type again below
+    if (a->type == BITMAP_RUNS || b->type == BITMAP_RUNS) {
+        if (expand_container(a, &ea) < 0) return -1;
+        if (expand_container(b, &eb) < 0) {
+            free(ea.data);
+            return -1;
+        }
+
+        result = combine_containers(&ea, &eb, and, out);
+        free(ea.data);
+        free(eb.data);
+
+        return result > 0 ? shrink_container(out) : result;
+    }
+
+    if (a->type == BITMAP_ARRAY && b->type == BITMAP_ARRAY &&
+            (and || a->count + b->count <= BITMAP_ARRAY_MAX)) {
+        uint32_t room = and ? (a->count < b->count ? a->count : b->count) :
+            a->count + b->count;
+
+        if (reserve_container(out, room > 0 ? room : 1, sizeof(uint16_t)) < 0) return -1;
+
+        out->size = out->count = merge_values(values_of(a), a->count, values_of(b),
+                b->count, and, values_of(out));
+        return 1;
+    }
+
+    if (and && (a->type == BITMAP_ARRAY || b->type == BITMAP_ARRAY)) {
+        // keep the values of the array set in the bitset
+        const struct bitmap_container *array = a->type == BITMAP_ARRAY ? a : b;
+        const struct bitmap_container *bits = a->type == BITMAP_ARRAY ? b : a;
+
+        if (reserve_container(out, array->count > 0 ? array->count : 1,
+                    sizeof(uint16_t)) < 0)
+            return -1;
+
+        for (uint32_t i = 0; i < array->count; i++)
+            if (test_word(words_of(bits), values_of(array)[i]))
+                values_of(out)[out->size++] = values_of(array)[i];
+
+        out->count = out->size;
+        return 1;
+    }
+
+    if (expand_container(a, &ea) < 0) return -1;
+    if (expand_container(b, &eb) < 0) {
+        free(ea.data);
+        return -1;
+    }
+
+    ea.count = and ? combine_words(words_of(&ea), words_of(&ea), words_of(&eb), true) :
+        combine_words(words_of(&ea), words_of(&ea), words_of(&eb), false);
+    free(eb.data);
+    *out = ea;
+
+    if (out->count <= BITMAP_ARRAY_MAX)
+        result = convert_container(out, BITMAP_ARRAY);
+
+    return result;
+}
+
+
+/**
+ * Bitmap - containers of a bitmap
+ */
+static uint32_t find_container(const bitmap_t *const b, uint16_t high)
+{
+    uint32_t lo = 0, hi = b->size;
+
+    // ascending values stay in the last container
+    if (b->size > 0 && b->keys[b->size - 1] <= high)
+        return b->keys[b->size - 1] == high ? b->size - 1 : b->size;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (b->keys[mid] < high) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+static int8_t insert_container(bitmap_t *const b, uint32_t pos, uint16_t high,
+        const struct bitmap_container *c)
+{
+    if (b->size == b->capacity) {
+        uint32_t capacity = b->capacity > 0 ? b->capacity * 2 : 4;
+        uint16_t *keys = realloc(b->keys, sizeof(*keys) * capacity);
+
+        if (keys != NULL) b->keys = keys;
+
+        struct bitmap_container *containers = realloc(b->containers,
+                sizeof(*containers) * capacity);
+
+        if (containers != NULL) b->containers = containers;
+        if (keys == NULL || containers == NULL) return -1;
+
+        b->capacity = capacity;
+    }
+
+    memmove(b->keys + pos + 1, b->keys + pos, sizeof(*b->keys) * (b->size - pos));
+    memmove(b->containers + pos + 1, b->containers + pos,
+            sizeof(*b->containers) * (b->size - pos));
+
+    b->keys[pos] = high;
+    b->containers[pos] = *c;
+    b->size++;
+    return 1;
+}
+
+static void remove_container(bitmap_t *const b, uint32_t pos)
+{
+    free(b->containers[pos].data);
+
+    memmove(b->keys + pos, b->keys + pos + 1, sizeof(*b->keys) * (b->size - pos - 1));
+    memmove(b->containers + pos, b->containers + pos + 1,
+            sizeof(*b->containers) * (b->size - pos - 1));
+    b->size--;
+}
+
+/**
+ * Append a non-empty container, frees it if out of memory
+ */
+static int8_t append_container(bitmap_t *const b, uint16_t high,
+        struct bitmap_container *c)
+{
+    if (insert_container(b, b->size, high, c) < 0) {
+        free(c->data);
+        return -1;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Bitmap - core
+ */
+bitmap_t *create_bitmap()
+{
+    return calloc(1, sizeof(bitmap_t));
+}
+
+void reset_bitmap(bitmap_t *const b)
+{
+    for (uint32_t i = 0; i < b->size; i++)
+        free(b->containers[i].data);
+
+    b->size = 0;
+}
+
+void free_bitmap(bitmap_t *b)
+{
+    reset_bitmap(b);
+    free(b->keys);
+    free(b->containers);
+    free(b);
+}
+
+int8_t add_bitmap(bitmap_t *const b, uint32_t value)
+{
+    uint16_t high = value >> 16;
+    uint32_t pos = find_container(b, high);
+
+    if (pos == b->size || b->keys[pos] != high) {
+        struct bitmap_container c = { .type = BITMAP_ARRAY };
+
+        if (insert_container(b, pos, high, &c) < 0) return -1;
+    }
+
+    int8_t result = add_container(&b->containers[pos], value & 0xffff);
+
+    if (b->containers[pos].count == 0)
+        remove_container(b, pos);
+
+    return result;
+}
+
+int8_t del_bitmap(bitmap_t *const b, uint32_t value)
+{
+    uint16_t high = value >> 16;
+    uint32_t pos = find_container(b, high);
+
+    if (pos == b->size || b->keys[pos] != high) return -1;
+
+    int8_t result = del_container(&b->containers[pos], value & 0xffff);
+
+    if (b->containers[pos].count == 0)
+        remove_container(b, pos);
+
+    return result;
+}
+
+int8_t contains_bitmap(const bitmap_t *const b, uint32_t value)
+{
+    uint32_t pos = find_container(b, value >> 16);
+
+    return pos < b->size && b->keys[pos] == value >> 16 &&
+        contains_container(&b->containers[pos], value & 0xffff);
+}
+
+int8_t optimize_bitmap(bitmap_t *const b)
+{
+    int8_t result = 1;
+
+    for (uint32_t i = 0; i < b->size; i++)
+        if (shrink_container(&b->containers[i]) < 0)
+            result = -1;
+
+    return result;
+}
+
+bitmap_t *union_bitmap(const bitmap_t *const a, const bitmap_t *const b)
+{
+    bitmap_t *r = create_bitmap();
+    uint32_t i = 0, j = 0;
+
+    while (r != NULL && (i < a->size || j < b->size)) {
+        struct bitmap_container c;
+        uint16_t high;
+        int8_t result;
+
+        if (j == b->size || (i < a->size && a->keys[i] < b->keys[j])) {
+            high = a->keys[i];
+            result = copy_container(&a->containers[i++], &c);
+        } else if (i == a->size || b->keys[j] < a->keys[i]) {
+            high = b->keys[j];
+            result = copy_container(&b->containers[j++], &c);
+        } else {
+            high = a->keys[i];
+            result = combine_containers(&a->containers[i++], &b->containers[j++],
+                    false, &c);
+        }
+
+        if (result < 0 || append_container(r, high, &c) < 0) {
+            if (result < 0) free(c.data);
+            free_bitmap(r);
+            r = NULL;
+        }
+    }
+
+    return r;
+}
+
+bitmap_t *intersect_bitmap(const bitmap_t *const a, const bitmap_t *const b)
+{
+    bitmap_t *r = create_bitmap();
+    uint32_t i = 0, j = 0;
+
+    while (r != NULL && i < a->size && j < b->size) {
+        struct bitmap_container c;
+
+        if (a->keys[i] < b->keys[j]) {
+            i++;
+            continue;
+        } else if (b->keys[j] < a->keys[i]) {
+            j++;
+            continue;
+        }
+
+        int8_t result = combine_containers(&a->containers[i], &b->containers[j],
+                true, &c);
+
+        if (result > 0 && c.count == 0)
+            free(c.data);
+        else if (result < 0 || append_container(r, a->keys[i], &c) < 0) {
+            if (result < 0) free(c.data);
+            free_bitmap(r);
+            r = NULL;
+        }
+
+        i++;
+        j++;
+    }
+
+    return r;
+}
+
+uint64_t count_intersect_bitmap(const bitmap_t *const a, const bitmap_t *const b)
+{
+    uint64_t count = 0;
+    uint32_t i = 0, j = 0;
+
+    while (i < a->size && j < b->size) {
+        const struct bitmap_container *x = &a->containers[i], *y = &b->containers[j];
+        struct bitmap_container c;
+
+        if (a->keys[i] < b->keys[j]) {
+            i++;
+            continue;
+        } else if (b->keys[j] < a->keys[i]) {
+            j++;
+            continue;
+        }
+
+        if (x->type == BITMAP_BITS && y->type == BITMAP_BITS)
+            count += combine_words(NULL, words_of(x), words_of(y), true);
+        else if (x->type != BITMAP_RUNS && y->type != BITMAP_RUNS &&
+                (x->type == BITMAP_BITS || y->type == BITMAP_BITS)) {
+            const struct bitmap_container *array = x->type == BITMAP_ARRAY ? x : y;
+            const uint64_t *words = words_of(x->type == BITMAP_ARRAY ? y : x);
+
+            for (uint32_t k = 0; k < array->count; k++)
+                count += test_word(words, values_of(array)[k]);
+        } else if (combine_containers(x, y, true, &c) > 0) {
+            count += c.count;
+            free(c.data);
+        } else {
+            // count without a container to spare
+            for (uint32_t v = 0; v <= UINT16_MAX; v++)
+                count += contains_container(x, v) && contains_container(y, v);
+        }
+
+        i++;
+        j++;
+    }
+
+    return count;
+}
+
+
+/**
+ * Bitmap - derived
+ */
+uint64_t count_bitmap(const bitmap_t *const b)
+{
+    uint64_t count = 0;
+
+    for (uint32_t i = 0; i < b->size; i++)
+        count += b->containers[i].count;
+
+    return count;
+}
+
+size_t memory_bitmap(const bitmap_t *const b)
+{
+    size_t bytes = sizeof(*b) + b->capacity * (sizeof(*b->keys) + sizeof(*b->containers));
+
+    for (uint32_t i = 0; i < b->size; i++)
+        bytes += container_bytes(&b->containers[i]);
+
+    return bytes;
+}
+
+void map_bitmap(const bitmap_t *const b, void (*func)(uint32_t, void *), void *func_data)
+{
+    for (uint32_t i = 0; i < b->size; i++) {
+        const struct bitmap_container *c = &b->containers[i];
+        uint32_t high = (uint32_t)b->keys[i] << 16;
+
+        if (c->type == BITMAP_ARRAY)
+            for (uint32_t k = 0; k < c->size; k++)
+                func(high | values_of(c)[k], func_data);
+        else if (c->type == BITMAP_RUNS)
+            for (uint32_t k = 0; k < c->size; k++)
+                for (uint32_t v = runs_of(c)[k].start; v <= runs_of(c)[k].last; v++)
+                    func(high | v, func_data);
+        else
+            for (int w = 0; w < BITMAP_WORDS; w++)
+                for (uint64_t bits = words_of(c)[w]; bits != 0; bits &= bits - 1)
+                    func(high | (w * 64 + __builtin_ctzll(bits)), func_data);
+    }
+}
+
+struct compress_set {
+    bitmap_t *b;
+    bool failed;
+};
+
+static bool compress_item(void *data, void *arg)
+{
+    struct compress_set *c = arg;
+    int64_t value = *(const int64_t *)data;
+
+    if (value < 0 || value > UINT32_MAX || add_bitmap(c->b, value) < 0)
+        c->failed = true;
+
+    return !c->failed;
+}
+
+static void compress_hashset_item(void *data, void *arg)
+{
+    compress_item(data, arg);
+}
+
+bitmap_t *compress_set(set_t *const s)
+{
+    uint8_t key_type = s->backend == SET_HASH ? s->hash->key_type :
+        s->backend == SET_BTREE ? s->btree->key_type : s->tree->key_type;
+    struct compress_set c = { .b = create_bitmap() };
+
+    if (key_type != BINARYTREE_KEY_INT64 || c.b == NULL) {
+        free(c.b);
+        return NULL;
+    }
+
+    // ordered sets hand out ascending values, which append to the last container
+    if (s->backend == SET_HASH)
+        map_hashset(s->hash, compress_hashset_item, &c);
+    else
+        scan_set(s, NULL, NULL, compress_item, &c);
+
+    if (c.failed || optimize_bitmap(c.b) < 0) {
+        free_bitmap(c.b);
+        return NULL;
+    }
+
+    return c.b;
+}
@@ -0,0 +1,751 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Sorted items shared by leaves and inner nodes, inner nodes keep the first
+ * item of every child but the first one as separators
+ */
+struct btree_node {
+    uint16_t count;             /**< number of items */
+    bool leaf;                  /**< node is a btree_leaf */
+    uint64_t keys[BTREE_ORDER]; /**< cached keys, searched first */
+    void *data[BTREE_ORDER];    /**< items, compared on equal keys */
+};
+
+struct btree_leaf {
+    struct btree_node node;
+    struct btree_leaf *prev;    /**< leaf with the preceding items */
+    struct btree_leaf *next;    /**< leaf with the following items */
+};
+
+struct btree_inner {
+    struct btree_node node;
+    struct btree_node *children[BTREE_ORDER + 1]; /**< count + 1 children */
+};
+
+/**
+ * Inner nodes passed on the way down and the child taken in each
+ */
+struct btree_path {
+    struct btree_inner *nodes[BTREE_MAX_HEIGHT];
+    uint16_t index[BTREE_MAX_HEIGHT];
+};
+
+
+/**
+ * B-tree - nodes
+ */
+static size_t btree_node_size(bool leaf)
+{
+    size_t size = leaf ? sizeof(struct btree_leaf) : sizeof(struct btree_inner);
+
+    // aligned_alloc wants a multiple of the alignment
+    return (size + DATASTRUCTS_CACHE_LINE - 1) & ~(size_t)(DATASTRUCTS_CACHE_LINE - 1);
+}
+
+static void *alloc_btree_node(btree_t *const t, bool leaf)
+{
+    struct btree_node *n = aligned_alloc(DATASTRUCTS_CACHE_LINE, btree_node_size(leaf));
+
+    if (n == NULL) return NULL;
+
+    n->count = 0;
+    n->leaf = leaf;
+
+    if (leaf) {
+        ((struct btree_leaf *)n)->prev = ((struct btree_leaf *)n)->next = NULL;
+        t->leaves++;
+    } else
+        t->inners++;
+
+    return n;
+}
+
+static void release_btree_node(btree_t *const t, struct btree_node *n)
+{
+    if (n->leaf)
+        t->leaves--;
+    else
+        t->inners--;
+
+    free(n);
+}
+
+static void release_sub_btree(btree_t *const t, struct btree_node *n)
+{
+    if (n == NULL) return;
+
+    if (!n->leaf)
+        for (uint16_t i = 0; i <= n->count; i++)
+            release_sub_btree(t, ((struct btree_inner *)n)->children[i]);
+
+    release_btree_node(t, n);
+}
+
+static void insert_btree_item(struct btree_node *n, uint16_t pos, uint64_t key, void *data)
+{
+    memmove(n->keys + pos + 1, n->keys + pos, sizeof(*n->keys) * (n->count - pos));
+    memmove(n->data + pos + 1, n->data + pos, sizeof(*n->data) * (n->count - pos));
+
+    n->keys[pos] = key;
+    n->data[pos] = data;
+    n->count++;
+}
+
+static void remove_btree_item(struct btree_node *n, uint16_t pos)
+{
+    n->count--;
+
+    memmove(n->keys + pos, n->keys + pos + 1, sizeof(*n->keys) * (n->count - pos));
+    memmove(n->data + pos, n->data + pos + 1, sizeof(*n->data) * (n->count - pos));
+}
+
+
+/**
+ * B-tree - keys
+ */
+static uint64_t key_btree(btree_t *const t, const void *const data)
+{
+    return cached_key(t->key_type, t->prefix, data);
+}
+
+static inline __attribute__((always_inline))
+int compare_btree(btree_t *const t, const uint8_t key_type, uint64_t key,
+        const void *const data, const struct btree_node *const n, uint16_t i)
+{
+    if (key != n->keys[i])
+        return key < n->keys[i] ? -1 : 1;
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING: return strcmp(data, n->data[i]);
+        case BINARYTREE_KEY_CUSTOM: return t->compare(data, n->data[i]);
+        default:                    return 0;
+    }
+}
+
+/**
+ * Leaf and position of the first item not ordered before data, the path
+ * holds the inner nodes above it. The leaf is NULL for an empty tree.
+ */
+static inline __attribute__((always_inline))
+uint16_t descend_typed(btree_t *const t, const uint8_t key_type, uint64_t key,
+        const void *const data, struct btree_path *path, struct btree_leaf **leaf)
+{
+    struct btree_node *n = t->root;
+    uint16_t lo, hi, mid;
+
+    for (uint32_t level = 0; n != NULL && !n->leaf; level++) {
+        struct btree_node **children = ((struct btree_inner *)n)->children;
+
+        // fetch the children while searching the keys, not after
+        for (size_t line = 0; line < sizeof(*children) * (BTREE_ORDER + 1);
+                line += DATASTRUCTS_CACHE_LINE)
+            __builtin_prefetch((char *)children + line);
+
+        // child after the last separator not ordered after data
+        if (key_type == BINARYTREE_KEY_ADDRESS || key_type == BINARYTREE_KEY_INT64) {
+            // keys decide alone, counting without branches beats bisecting
+            for (lo = 0, hi = 0; hi < n->count; hi++)
+                lo += n->keys[hi] <= key;
+        } else for (lo = 0, hi = n->count; lo < hi; ) {
+            mid = (lo + hi) / 2;
+
+            if (compare_btree(t, key_type, key, data, n, mid) >= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        path->nodes[level] = (struct btree_inner *)n;
+        path->index[level] = lo;
+        n = children[lo];
+    }
+
+    *leaf = (struct btree_leaf *)n;
+
+    if (n == NULL) return 0;
+
+    if (key_type == BINARYTREE_KEY_ADDRESS || key_type == BINARYTREE_KEY_INT64) {
+        for (lo = 0, hi = 0; hi < n->count; hi++)
+            lo += n->keys[hi] < key;
+        return lo;
+    }
+
+    for (lo = 0, hi = n->count; lo < hi; ) {
+        mid = (lo + hi) / 2;
+
+        if (compare_btree(t, key_type, key, data, n, mid) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static uint16_t descend_btree(btree_t *const t, uint64_t key, const void *const data,
+        struct btree_path *path, struct btree_leaf **leaf)
+{
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return descend_typed(t, BINARYTREE_KEY_INT64, key, data, path, leaf);
+        case BINARYTREE_KEY_STRING:
+            return descend_typed(t, BINARYTREE_KEY_STRING, key, data, path, leaf);
+        case BINARYTREE_KEY_CUSTOM:
+            return descend_typed(t, BINARYTREE_KEY_CUSTOM, key, data, path, leaf);
+        default:
+            return descend_typed(t, BINARYTREE_KEY_ADDRESS, key, data, path, leaf);
+    }
+}
+
+static bool equal_btree(btree_t *const t, uint64_t key, const void *const data,
+        const struct btree_leaf *const leaf, uint16_t pos)
+{
+    return leaf != NULL && pos < leaf->node.count &&
+        compare_btree(t, t->key_type, key, data, &leaf->node, pos) == 0;
+}
+
+
+/**
+ * B-tree - core
+ */
+btree_t *create_btree()
+{
+    return calloc(1, sizeof(btree_t));
+}
+
+btree_t *create_btree_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *))
+{
+    btree_t *t = create_btree();
+    t->key_type = BINARYTREE_KEY_CUSTOM;
+    t->compare = compare;
+    t->prefix = prefix;
+    return t;
+}
+
+btree_t *create_btree_int()
+{
+    btree_t *t = create_btree();
+    t->key_type = BINARYTREE_KEY_INT64;
+    return t;
+}
+
+btree_t *create_btree_str()
+{
+    btree_t *t = create_btree();
+    t->key_type = BINARYTREE_KEY_STRING;
+    return t;
+}
+
+void reset_btree(btree_t *const t)
+{
+    release_sub_btree(t, t->root);
+
+    t->root = NULL;
+    t->first = NULL;
+    t->count = 0;
+    t->height = 0;
+}
+
+void free_btree(btree_t *t)
+{
+    release_sub_btree(t, t->root);
+    free(t);
+}
+
+/**
+ * Split a full node into the empty node right while adding an item (leaf)
+ * or a separator and the child right of it (inner) at pos. The separator of
+ * right is handed back through key and data.
+ */
+static struct btree_node *split_btree_node(struct btree_node *n, struct btree_node *right,
+        uint16_t pos, uint64_t *key, void **data, struct btree_node *child)
+{
+    // one item more than fits, laid out in order before distributing
+    uint64_t keys[BTREE_ORDER + 1];
+    void *items[BTREE_ORDER + 1];
+    struct btree_node *children[BTREE_ORDER + 2];
+
+    memcpy(keys, n->keys, sizeof(*keys) * pos);
+    memcpy(items, n->data, sizeof(*items) * pos);
+    keys[pos] = *key;
+    items[pos] = *data;
+    memcpy(keys + pos + 1, n->keys + pos, sizeof(*keys) * (BTREE_ORDER - pos));
+    memcpy(items + pos + 1, n->data + pos, sizeof(*items) * (BTREE_ORDER - pos));
+
+    uint16_t half = (BTREE_ORDER + 1) / 2;
+
+    if (n->leaf) {
+        struct btree_leaf *l = (struct btree_leaf *)n;
+        struct btree_leaf *r = (struct btree_leaf *)right;
+
+        n->count = half;
+        right->count = BTREE_ORDER + 1 - half;
+        memcpy(n->keys, keys, sizeof(*keys) * n->count);
+        memcpy(n->data, items, sizeof(*items) * n->count);
+        memcpy(right->keys, keys + half, sizeof(*keys) * right->count);
+        memcpy(right->data, items + half, sizeof(*items) * right->count);
+
+        r->prev = l;
+        r->next = l->next;
+        if (l->next != NULL)
+            l->next->prev = r;
+        l->next = r;
+
+        // the first item of the right leaf separates it
+        *key = right->keys[0];
+        *data = right->data[0];
+        return right;
+    }
+
+    struct btree_inner *in = (struct btree_inner *)n;
+    struct btree_inner *ir = (struct btree_inner *)right;
+
+    memcpy(children, in->children, sizeof(*children) * (pos + 1));
+    children[pos + 1] = child;
+    memcpy(children + pos + 2, in->children + pos + 1,
+            sizeof(*children) * (BTREE_ORDER - pos));
+
+    // the middle separator moves up, it is the first item below right
+    n->count = half;
+    right->count = BTREE_ORDER - half;
+    memcpy(n->keys, keys, sizeof(*keys) * n->count);
+    memcpy(n->data, items, sizeof(*items) * n->count);
+    memcpy(in->children, children, sizeof(*children) * (n->count + 1));
+    memcpy(right->keys, keys + half + 1, sizeof(*keys) * right->count);
+    memcpy(right->data, items + half + 1, sizeof(*items) * right->count);
+    memcpy(ir->children, children + half + 1, sizeof(*children) * (right->count + 1));
+
+    *key = keys[half];
+    *data = items[half];
+    return right;
+}
+
+int8_t add_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint64_t key = key_btree(t, data);
+    uint16_t pos = descend_btree(t, key, data, &path, &leaf);
+
+    if (leaf == NULL) {
+        if ((leaf = alloc_btree_node(t, true)) == NULL) return -1;
+
+        t->root = &leaf->node;
+        t->first = leaf;
+        t->height = 1;
+    } else if (equal_btree(t, key, data, leaf, pos))
+        return 0;
+
+    if (leaf->node.count < BTREE_ORDER) {
+        insert_btree_item(&leaf->node, pos, key, data);
+        t->count++;
+        return 1;
+    }
+
+    // a sibling for the leaf and every full parent, and a root if all are
+    // full, allocated before the tree changes
+    struct btree_node *spare[BTREE_MAX_HEIGHT + 1];
+    int full = (int)t->height - 2;
+    int needed = 1;
+
+    while (full >= 0 && path.nodes[full]->node.count == BTREE_ORDER) {
+        full--;
+        needed++;
+    }
+
+    if (full < 0) needed++;
+
+    for (int i = 0; i < needed; i++) {
+        spare[i] = alloc_btree_node(t, i == 0);
+
+        if (spare[i] == NULL) {
+            while (i-- > 0)
+                release_btree_node(t, spare[i]);
+            return -1;
+        }
+    }
+
+    // split upwards until a node has room
+    uint64_t sep_key = key;
+    void *sep_data = data;
+    struct btree_node *right = split_btree_node(&leaf->node, spare[0], pos,
+            &sep_key, &sep_data, NULL);
+
+    t->count++;
+
+    for (int i = 1, level = (int)t->height - 2; level >= 0; i++, level--) {
+        struct btree_inner *parent = path.nodes[level];
+        uint16_t index = path.index[level];
+
+        if (parent->node.count < BTREE_ORDER) {
+            insert_btree_item(&parent->node, index, sep_key, sep_data);
+            memmove(parent->children + index + 2, parent->children + index + 1,
+                    sizeof(*parent->children) * (parent->node.count - index - 1));
+            parent->children[index + 1] = right;
+            return 1;
+        }
+
+        right = split_btree_node(&parent->node, spare[i], index, &sep_key, &sep_data, right);
+    }
+
+    struct btree_inner *root = (struct btree_inner *)spare[needed - 1];
+
+    root->node.count = 1;
+    root->node.keys[0] = sep_key;
+    root->node.data[0] = sep_data;
+    root->children[0] = t->root;
+    root->children[1] = right;
+
+    t->root = &root->node;
+    t->height++;
+
+    return 1;
+}
+
+void *find_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint64_t key = key_btree(t, data);
+    uint16_t pos = descend_btree(t, key, data, &path, &leaf);
+
+    return equal_btree(t, key, data, leaf, pos) ? leaf->node.data[pos] : NULL;
+}
+
+int8_t contains_btree(btree_t *const t, void *const data)
+{
+    return find_btree(t, data) != NULL;
+}
+
+/**
+ * Point the separator of the subtree whose first item changed at its new
+ * first item, it lives in the lowest inner node not entered at child 0
+ */
+static void update_btree_separator(struct btree_path *path, int level,
+        struct btree_node *first, uint16_t pos)
+{
+    for (; level >= 0; level--)
+        if (path->index[level] > 0) {
+            path->nodes[level]->node.keys[path->index[level] - 1] = first->keys[pos];
+            path->nodes[level]->node.data[path->index[level] - 1] = first->data[pos];
+            return;
+        }
+}
+
+int8_t del_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint64_t key = key_btree(t, data);
+    uint16_t pos = descend_btree(t, key, data, &path, &leaf);
+
+    if (!equal_btree(t, key, data, leaf, pos)) return -1;
+
+    remove_btree_item(&leaf->node, pos);
+    t->count--;
+
+    if (leaf->node.count > 0) {
+        if (pos == 0)
+            update_btree_separator(&path, t->height - 2, &leaf->node, 0);
+        return 1;
+    }
+
+    // underfull nodes are left as they are, only empty ones are removed
+    struct btree_leaf *next = leaf->next;
+
+    if (leaf->prev != NULL)
+        leaf->prev->next = leaf->next;
+    else
+        t->first = leaf->next;
+    if (leaf->next != NULL)
+        leaf->next->prev = leaf->prev;
+
+    release_btree_node(t, &leaf->node);
+
+    int level = t->height - 2;
+
+    for (; level >= 0; level--) {
+        struct btree_inner *parent = path.nodes[level];
+        uint16_t index = path.index[level];
+
+        if (parent->node.count > 0) {
+            remove_btree_item(&parent->node, index > 0 ? index - 1 : 0);
+            memmove(parent->children + index, parent->children + index + 1,
+                    sizeof(*parent->children) * (parent->node.count + 1 - index));
+            break;
+        }
+
+        release_btree_node(t, &parent->node);
+    }
+
+    if (level < 0) {
+        t->root = NULL;
+        t->height = 0;
+        return 1;
+    }
+
+    // the removed separator was the one pointing at the deleted item,
+    // unless the removed child was the first one
+    if (path.index[level] == 0 && next != NULL)
+        update_btree_separator(&path, level - 1, &next->node, 0);
+
+    while (!t->root->leaf && t->root->count == 0) {
+        struct btree_node *only = ((struct btree_inner *)t->root)->children[0];
+
+        release_btree_node(t, t->root);
+        t->root = only;
+        t->height--;
+    }
+
+    return 1;
+}
+
+/**
+ * Free the nodes of an interrupted load_btree, the built nodes of the level
+ * in progress and the unclaimed ones of the level below, and empty the tree
+ */
+static int8_t abort_load_btree(btree_t *const t, struct btree_node **level,
+        uint64_t built, uint64_t unclaimed, uint64_t count, uint64_t *keys)
+{
+    for (uint64_t i = 0; i < built; i++)
+        release_sub_btree(t, level[i]);
+
+    for (uint64_t i = unclaimed; i < count; i++)
+        release_sub_btree(t, level[i]);
+
+    free(level);
+    free(keys);
+
+    t->first = NULL;
+    t->height = 0;
+    return -1;
+}
+
+int8_t load_btree(btree_t *const t, void *const *items, uint64_t n)
+{
+    if (t->root != NULL) return -1;
+    if (n == 0) return 1;
+
+    uint64_t *keys = malloc(sizeof(*keys) * n);
+
+    if (keys == NULL) return -1;
+
+    for (uint64_t i = 0; i < n; i++) {
+        keys[i] = key_btree(t, items[i]);
+
+        if (i > 0 && (keys[i - 1] > keys[i] || (keys[i - 1] == keys[i] &&
+                    (t->key_type == BINARYTREE_KEY_STRING ? strcmp(items[i - 1], items[i]) :
+                     t->key_type == BINARYTREE_KEY_CUSTOM ? t->compare(items[i - 1], items[i]) :
+                     0) >= 0))) {
+            free(keys);
+            return -1;
+        }
+    }
+
+    // spread items evenly over as few leaves as possible
+    uint64_t count = (n + BTREE_ORDER - 1) / BTREE_ORDER;
+    struct btree_node **level = malloc(sizeof(*level) * count);
+    struct btree_leaf *prev = NULL;
+
+    if (level == NULL) {
+        free(keys);
+        return -1;
+    }
+
+    for (uint64_t i = 0, item = 0; i < count; i++) {
+        struct btree_leaf *leaf = alloc_btree_node(t, true);
+
+        if (leaf == NULL) return abort_load_btree(t, level, i, count, count, keys);
+
+        uint16_t size = n / count + (i < n % count);
+
+        memcpy(leaf->node.keys, keys + item, sizeof(*keys) * size);
+        memcpy(leaf->node.data, items + item, sizeof(*items) * size);
+        leaf->node.count = size;
+        item += size;
+
+        leaf->prev = prev;
+        if (prev != NULL)
+            prev->next = leaf;
+        else
+            t->first = leaf;
+
+        prev = leaf;
+        level[i] = &leaf->node;
+    }
+
+    t->height = 1;
+
+    // every separator is the first item of the leftmost leaf below its child
+    while (count > 1) {
+        uint64_t parents = (count + BTREE_ORDER) / (BTREE_ORDER + 1);
+
+        for (uint64_t i = 0, child = 0; i < parents; i++) {
+            struct btree_inner *inner = alloc_btree_node(t, false);
+
+            // built parents take the slots of children already claimed
+            if (inner == NULL) return abort_load_btree(t, level, i, child, count, keys);
+
+            uint16_t size = count / parents + (i < count % parents);
+
+            for (uint16_t c = 0; c < size; c++) {
+                struct btree_node *first = level[child + c];
+
+                inner->children[c] = first;
+                if (c == 0) continue;
+
+                while (!first->leaf)
+                    first = ((struct btree_inner *)first)->children[0];
+
+                inner->node.keys[c - 1] = first->keys[0];
+                inner->node.data[c - 1] = first->data[0];
+            }
+
+            inner->node.count = size - 1;
+            child += size;
+            level[i] = &inner->node;
+        }
+
+        count = parents;
+        t->height++;
+    }
+
+    t->root = level[0];
+    t->count = n;
+
+    free(level);
+    free(keys);
+
+    return 1;
+}
+
+
+/**
+ * B-tree - ordered queries
+ */
+static void *step_btree(struct btree_leaf *leaf, int32_t pos)
+{
+    // pos may be one past either end of leaf, leaves are never empty
+    if (pos < 0) {
+        leaf = leaf->prev;
+        return leaf != NULL ? leaf->node.data[leaf->node.count - 1] : NULL;
+    }
+
+    if (pos >= leaf->node.count) {
+        leaf = leaf->next;
+        return leaf != NULL ? leaf->node.data[0] : NULL;
+    }
+
+    return leaf->node.data[pos];
+}
+
+void *lower_bound_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint16_t pos = descend_btree(t, key_btree(t, data), data, &path, &leaf);
+
+    return leaf != NULL ? step_btree(leaf, pos) : NULL;
+}
+
+void *upper_bound_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint64_t key = key_btree(t, data);
+    uint16_t pos = descend_btree(t, key, data, &path, &leaf);
+
+    if (leaf == NULL) return NULL;
+
+    return step_btree(leaf, pos + equal_btree(t, key, data, leaf, pos));
+}
+
+void *floor_btree(btree_t *const t, void *const data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf;
+    uint64_t key = key_btree(t, data);
+    uint16_t pos = descend_btree(t, key, data, &path, &leaf);
+
+    if (leaf == NULL) return NULL;
+
+    return step_btree(leaf, (int32_t)pos - !equal_btree(t, key, data, leaf, pos));
+}
+
+void *ceiling_btree(btree_t *const t, void *const data)
+{
+    return lower_bound_btree(t, data);
+}
+
+
+/**
+ * B-tree - derived
+ */
+uint64_t count_btree(btree_t *const t)
+{
+    return t->count;
+}
+
+size_t memory_btree(btree_t *const t)
+{
+    return t->leaves * btree_node_size(true) + t->inners * btree_node_size(false) +
+        sizeof(*t);
+}
+
+void map_btree(btree_t *const t, void (*func)(void *, void *), void *func_data)
+{
+    for (struct btree_leaf *leaf = t->first; leaf != NULL; leaf = leaf->next)
+        for (uint16_t i = 0; i < leaf->node.count; i++)
+            func(leaf->node.data[i], func_data);
+}
+
+void map_range_btree(btree_t *const t, void *const low, void *const high,
+        void (*func)(void *, void *), void *func_data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf = t->first;
+    uint16_t pos = 0;
+    uint64_t high_key = high != NULL ? key_btree(t, high) : 0;
+
+    if (low != NULL)
+        pos = descend_btree(t, key_btree(t, low), low, &path, &leaf);
+
+    for (; leaf != NULL; leaf = leaf->next, pos = 0)
+        for (; pos < leaf->node.count; pos++) {
+            if (high != NULL &&
+                    compare_btree(t, t->key_type, high_key, high, &leaf->node, pos) <= 0)
+                return;
+
+            func(leaf->node.data[pos], func_data);
+        }
+}
+
+uint64_t scan_btree(btree_t *const t, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data)
+{
+    struct btree_path path;
+    struct btree_leaf *leaf = t->first;
+    uint16_t pos = 0;
+    uint64_t high_key = high != NULL ? key_btree(t, high) : 0;
+    uint64_t scanned = 0;
+
+    if (low != NULL)
+        pos = descend_btree(t, key_btree(t, low), low, &path, &leaf);
+
+    for (; leaf != NULL; leaf = leaf->next, pos = 0)
+        for (; pos < leaf->node.count; pos++) {
+            if (high != NULL &&
+                    compare_btree(t, t->key_type, high_key, high, &leaf->node, pos) <= 0)
+                return scanned;
+
+            scanned++;
+            if (!func(leaf->node.data[pos], func_data))
+                return scanned;
+        }
+
+    return scanned;
+}
@@ -8,74 +8,201 @@
  */
 deque_t *create_deque()
 {
-    deque_t *dq = malloc(sizeof(deque_t));
-    dq->count = 0;
+    return calloc(1, sizeof(deque_t));
+}
+
+deque_t *create_deque_pooled()
+{
+    deque_t *dq = create_deque();
+    dq->pool = shared_node_pool(NODE_POOL_DL);
     return dq;
 }
 
-void add_first_deque(deque_t *const dq, void *const data)
+deque_t *create_deque_arena()
 {
-    dl_node_t *n = create_dlnode(data);
-    
-    if (dq->count == 0)
-        dq->first = n;
-    else if (dq->count == 1) {
-        n->next = dq->last = dq->first;
-        dq->first = dq->last->prev = n;
+    deque_t *dq = create_deque();
+    dq->pool = create_node_pool(sizeof(dl_node_t), NODE_ARENA_SLAB);
+    return dq;
+}
+
+static int8_t rebalance_deque_map(deque_t *const dq, bool front)
+{
+    uint32_t first = dq->head / DEQUE_BLOCK_SIZE;
+    uint32_t used = dq->count ? (dq->tail - 1) / DEQUE_BLOCK_SIZE - first + 1 : 0;
+    uint32_t size = dq->map_size ? dq->map_size : 8;
+
+    // keep at least half of the map free so rebalancing stays rare
+    while (size < (used + 1) * 2)
+        size <<= 1;
+
+    void ***map = calloc(size, sizeof(*map));
+
+    if (map == NULL) return -1;
+
+    // center used blocks, with room for a block in front when adding first
+    uint32_t start = (size - used - 1) / 2 + front;
+
+    for (uint32_t i = 0; i < used; i++)
+        map[start + i] = dq->map[first + i];
+
+    // spare blocks fill the remaining slots so nothing gets reallocated
+    uint32_t slot = (start + used) % size;
+
+    for (uint32_t i = 0; i < dq->map_size - used; i++) {
+        map[slot] = dq->map[(first + used + i) % dq->map_size];
+        slot = (slot + 1) % size;
     }
-    else {
-        n->next = dq->first;
-        dq->first = dq->first->prev = n;
+
+    free(dq->map);
+    dq->map = map;
+    dq->map_size = size;
+    dq->head = start * DEQUE_BLOCK_SIZE + dq->head % DEQUE_BLOCK_SIZE;
+    dq->tail = dq->head + dq->count;
+
+    return 1;
+}
+
+deque_t *create_deque_block()
+{
+    deque_t *dq = create_deque();
+
+    dq->mode = DEQUE_BLOCK;
+    rebalance_deque_map(dq, false);
+
+    return dq;
+}
+
+static void **deque_block(deque_t *const dq, uint32_t index)
+{
+    void ***block = &dq->map[index / DEQUE_BLOCK_SIZE];
+
+    if (*block == NULL)
+        *block = malloc(sizeof(**block) * DEQUE_BLOCK_SIZE);
+
+    return *block;
+}
+
+static void recenter_deque(deque_t *const dq)
+{
+    dq->head = dq->tail = dq->map_size / 2 * DEQUE_BLOCK_SIZE;
+}
+
+void add_first_deque(deque_t *const dq, void *const data)
+{
+    if (dq->mode == DEQUE_BLOCK) {
+        if (dq->head == 0 && rebalance_deque_map(dq, true) < 0)
+            return;
+
+        void **block = deque_block(dq, dq->head - 1);
+
+        if (block == NULL) return;
+
+        block[--dq->head % DEQUE_BLOCK_SIZE] = data;
+        dq->count++;
+        return;
     }
 
+    dl_node_t *n = alloc_dlnode(dq->pool, data);
+
+    n->next = dq->first;
+
+    if (dq->first == NULL)
+        dq->last = n;
+    else
+        dq->first->prev = n;
+
+    dq->first = n;
     dq->count++;
 }
 
 void add_last_deque(deque_t *const dq, void *const data)
 {
-    dl_node_t *n = create_dlnode(data);
+    if (dq->mode == DEQUE_BLOCK) {
+        if (dq->tail == dq->map_size * DEQUE_BLOCK_SIZE &&
+                rebalance_deque_map(dq, false) < 0)
+            return;
 
-    if (dq->count == 0)
-        dq->first = n;
-    else if (dq->count == 1) {
-        dq->last = n;
-        dq->last->prev = dq->first;
-        dq->first->next = dq->last;
+        void **block = deque_block(dq, dq->tail);
+
+        if (block == NULL) return;
+
+        block[dq->tail++ % DEQUE_BLOCK_SIZE] = data;
+        dq->count++;
+        return;
     }
-    else {
-        n->prev = dq->last;
+
+    dl_node_t *n = alloc_dlnode(dq->pool, data);
+
+    n->prev = dq->last;
+
+    if (dq->last == NULL)
+        dq->first = n;
+    else
         dq->last->next = n;
-        dq->last = n;
-    }
 
+    dq->last = n;
     dq->count++;
 }
 
 void *pop_first_deque(deque_t *const dq)
 {
+    if (dq->mode == DEQUE_BLOCK) {
+        if (dq->count == 0) return NULL;
+
+        void *data = dq->map[dq->head / DEQUE_BLOCK_SIZE][dq->head % DEQUE_BLOCK_SIZE];
+        dq->head++;
+
+        if (--dq->count == 0)
+            recenter_deque(dq);
+
+        return data;
+    }
+
     if (dq->first == NULL) return NULL;
 
     dl_node_t *n = dq->first;
     dq->first = dq->first->next;
+
+    if (dq->first == NULL)
+        dq->last = NULL;
+    else
+        dq->first->prev = NULL;
     
     dq->count--;
     void *data = n->data;
     
-    free(n);
+    release_dlnode(dq->pool, n);
     return data;
 }
 
 void *pop_last_deque(deque_t *const dq)
 {
+    if (dq->mode == DEQUE_BLOCK) {
+        if (dq->count == 0) return NULL;
+
+        dq->tail--;
+        void *data = dq->map[dq->tail / DEQUE_BLOCK_SIZE][dq->tail % DEQUE_BLOCK_SIZE];
+
+        if (--dq->count == 0)
+            recenter_deque(dq);
+
+        return data;
+    }
+
     if (dq->last == NULL) return NULL;
 
     dl_node_t *n = dq->last;
     dq->last = dq->last->prev;
 
+    if (dq->last == NULL)
+        dq->first = NULL;
+    else
+        dq->last->next = NULL;
+
     dq->count--;
     void *data = n->data;
     
-    free(n);
+    release_dlnode(dq->pool, n);
     return data;
 }
 
@@ -86,9 +213,30 @@ void *contains_deque(deque_t *const dq)
     return n->data;
 }
 
+void reset_deque(deque_t *const dq)
+{
+    if (dq->mode == DEQUE_BLOCK)
+        recenter_deque(dq); // blocks are kept for reuse
+    else if (dq->pool != NULL && dq->pool->shared < 0)
+        reset_node_pool(dq->pool);
+    else
+        release_dlnode_seq(dq->pool, dq->first);
+
+    dq->first = dq->last = NULL;
+    dq->count = 0;
+}
+
 void free_deque(deque_t *dq)
 {
-    free_dlnode_seq(dq->first);
+    if (dq->mode == DEQUE_BLOCK) {
+        for (uint32_t i = 0; i < dq->map_size; i++)
+            free(dq->map[i]);
+        free(dq->map);
+    } else if (dq->pool != NULL && dq->pool->shared < 0)
+        free_node_pool(dq->pool); // Arena, nodes go with their slabs
+    else
+        release_dlnode_seq(dq->pool, dq->first);
+
     free(dq);
 }
 
@@ -99,14 +247,34 @@ void free_deque(deque_t *dq)
 
 uint32_t count_deque(deque_t *const dq) 
 {
-    if (dq->first == NULL)
-        return 0;
-
-    count_dlnode_seq(dq->first, 0);
+    return dq->count;
 }
 
 void map_deque(deque_t *const dq, void (*func)(dl_node_t *, void *), void *func_data, bool reverse)
 {
+    if (dq->mode == DEQUE_BLOCK) {
+        dl_node_t n = { .next = NULL, .prev = NULL };
+
+        // walk each block as one contiguous run
+        for (uint32_t i = 0; i < dq->count; ) {
+            uint32_t index = reverse ? dq->tail - 1 - i : dq->head + i;
+            uint32_t offset = index % DEQUE_BLOCK_SIZE;
+            uint32_t run = reverse ? offset + 1 : DEQUE_BLOCK_SIZE - offset;
+            void **block = dq->map[index / DEQUE_BLOCK_SIZE];
+
+            if (run > dq->count - i)
+                run = dq->count - i;
+
+            for (uint32_t j = 0; j < run; j++) {
+                n.data = block[reverse ? offset - j : offset + j];
+                func(&n, func_data);
+            }
+
+            i += run;
+        }
+        return;
+    }
+
     dl_node_t *start;
 
     if (reverse)
@@ -114,5 +282,5 @@ void map_deque(deque_t *const dq, void (*func)(dl_node_t *, void *), void *func_
     else
         start = dq->first;
 
-    map_dlnode_seq(dq->last, func, func_data, reverse); 
+    map_dlnode_seq(start, func, func_data, reverse); 
 }
@@ -0,0 +1,324 @@
+#include "datastructs.h"
+#include <stdlib.h>
+
+
+/**
+ * Objects retired while the global epoch had one value
+ */
+struct epoch_limbo {
+    uint64_t epoch;
+    uint32_t count;
+    uint32_t capacity;
+    struct epoch_retired {
+        void *ptr;
+        void (*free_fn)(void *);
+    } *items;
+};
+
+/**
+ * Per-thread state, local is the announced epoch shifted left by one with
+ * the lowest bit set while inside a critical section
+ */
+struct epoch_record {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint64_t local;
+    uint32_t nest;
+    uint32_t retired;
+    struct epoch_limbo limbo[3];
+    _Atomic bool in_use;
+    struct epoch_record *next;
+};
+
+/**
+ * Record a thread holds in a domain, domains are checked against the live
+ * list before a binding is touched because they can be freed before the
+ * thread exits
+ */
+struct epoch_binding {
+    epoch_domain_t *domain;
+    uint64_t id;
+    struct epoch_record *record;
+    struct epoch_binding *next;
+};
+
+static epoch_domain_t *live_domains;
+static uint64_t domain_ids;
+static pthread_mutex_t domains_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static epoch_domain_t *shared_domain;
+static pthread_once_t shared_domain_once = PTHREAD_ONCE_INIT;
+
+static __attribute__((tls_model("initial-exec")))
+    _Thread_local struct epoch_binding *bindings;
+static pthread_key_t binding_key;
+static pthread_once_t binding_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Epoch - records
+ */
+static void free_limbo(struct epoch_limbo *l)
+{
+    for (uint32_t i = 0; i < l->count; i++)
+        l->items[i].free_fn(l->items[i].ptr);
+
+    l->count = 0;
+}
+
+static void release_bindings(void *list)
+{
+    struct epoch_binding *b = *(struct epoch_binding **)list;
+    struct epoch_binding *tmp;
+
+    pthread_mutex_lock(&domains_lock);
+    while (b != NULL) {
+        tmp = b->next;
+
+        // leftovers stay in the limbo of the record for its next owner
+        for (epoch_domain_t *d = live_domains; d != NULL; d = d->next)
+            if (d == b->domain && d->id == b->id)
+                atomic_store_explicit(&b->record->in_use, false, memory_order_release);
+
+        free(b);
+        b = tmp;
+    }
+    pthread_mutex_unlock(&domains_lock);
+}
+
+static void create_binding_key()
+{
+    pthread_key_create(&binding_key, release_bindings);
+}
+
+static struct epoch_record *acquire_record(epoch_domain_t *const d)
+{
+    struct epoch_record *r = atomic_load_explicit(&d->records, memory_order_acquire);
+
+    // adopt a record left behind by an exited thread first
+    for (; r != NULL; r = r->next) {
+        bool expected = false;
+        if (!atomic_load_explicit(&r->in_use, memory_order_relaxed) &&
+                atomic_compare_exchange_strong(&r->in_use, &expected, true))
+            return r;
+    }
+
+    r = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*r));
+
+    if (r == NULL) return NULL;
+
+    *r = (struct epoch_record){ .in_use = true };
+    r->next = atomic_load_explicit(&d->records, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(&d->records, &r->next, r,
+                memory_order_release, memory_order_relaxed));
+
+    return r;
+}
+
+static struct epoch_record *thread_record(epoch_domain_t *const d)
+{
+    struct epoch_binding *b = bindings;
+
+    if (b != NULL && b->domain == d && b->id == d->id)
+        return b->record;
+
+    for (struct epoch_binding *prev = b; prev != NULL && prev->next != NULL;
+            prev = prev->next) {
+        struct epoch_binding *found = prev->next;
+
+        if (found->domain == d && found->id == d->id) {
+            // move to front, threads tend to stick to one domain
+            prev->next = found->next;
+            found->next = bindings;
+            bindings = found;
+            return found->record;
+        }
+    }
+
+    pthread_once(&binding_once, create_binding_key);
+
+    b = malloc(sizeof(*b));
+
+    if (b == NULL) return NULL;
+
+    b->domain = d;
+    b->id = d->id;
+    b->record = acquire_record(d);
+
+    if (b->record == NULL) {
+        free(b);
+        return NULL;
+    }
+
+    b->next = bindings;
+    bindings = b;
+    pthread_setspecific(binding_key, &bindings);
+
+    return b->record;
+}
+
+
+/**
+ * Epoch - domains
+ */
+epoch_domain_t *create_epoch_domain()
+{
+    epoch_domain_t *d = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*d));
+
+    if (d == NULL) return NULL;
+
+    atomic_init(&d->epoch, 0);
+    atomic_init(&d->records, NULL);
+
+    pthread_mutex_lock(&domains_lock);
+    d->id = ++domain_ids;
+    d->next = live_domains;
+    live_domains = d;
+    pthread_mutex_unlock(&domains_lock);
+
+    return d;
+}
+
+void free_epoch_domain(epoch_domain_t *d)
+{
+    pthread_mutex_lock(&domains_lock);
+    for (epoch_domain_t **walk = &live_domains; *walk != NULL; walk = &(*walk)->next)
+        if (*walk == d) {
+            *walk = d->next;
+            break;
+        }
+    pthread_mutex_unlock(&domains_lock);
+
+    struct epoch_record *r = atomic_load(&d->records);
+    struct epoch_record *tmp;
+
+    while (r != NULL) {
+        tmp = r->next;
+
+        for (int i = 0; i < 3; i++) {
+            free_limbo(&r->limbo[i]);
+            free(r->limbo[i].items);
+        }
+
+        free(r);
+        r = tmp;
+    }
+
+    free(d);
+}
+
+static void create_shared_domain()
+{
+    shared_domain = create_epoch_domain();
+}
+
+epoch_domain_t *shared_epoch_domain()
+{
+    pthread_once(&shared_domain_once, create_shared_domain);
+    return shared_domain;
+}
+
+
+/**
+ * Epoch - critical sections and reclamation
+ */
+int8_t enter_epoch(epoch_domain_t *const d)
+{
+    struct epoch_record *r = thread_record(d);
+
+    if (r == NULL) return -1;
+
+    if (r->nest++ > 0) return 1;
+
+    uint64_t e = atomic_load_explicit(&d->epoch, memory_order_relaxed);
+    atomic_store_explicit(&r->local, e << 1 | 1, memory_order_relaxed);
+
+    // the announcement must be visible before any shared node is read
+    atomic_thread_fence(memory_order_seq_cst);
+    return 1;
+}
+
+void exit_epoch(epoch_domain_t *const d)
+{
+    struct epoch_record *r = thread_record(d);
+
+    if (r == NULL || --r->nest > 0) return;
+
+    atomic_store_explicit(&r->local, 0, memory_order_release);
+}
+
+static bool advance_epoch(epoch_domain_t *const d)
+{
+    uint64_t e = atomic_load_explicit(&d->epoch, memory_order_seq_cst);
+    struct epoch_record *r = atomic_load_explicit(&d->records, memory_order_acquire);
+
+    // every thread in a critical section has to have seen the current epoch
+    for (; r != NULL; r = r->next) {
+        uint64_t local = atomic_load_explicit(&r->local, memory_order_seq_cst);
+
+        if ((local & 1) && (local >> 1) != e)
+            return false;
+    }
+
+    return atomic_compare_exchange_strong(&d->epoch, &e, e + 1);
+}
+
+static void collect_epoch(struct epoch_record *const r, uint64_t e)
+{
+    // objects retired in epoch x are unreachable for everybody from x + 2
+    for (int i = 0; i < 3; i++)
+        if (r->limbo[i].count > 0 && r->limbo[i].epoch + 2 <= e)
+            free_limbo(&r->limbo[i]);
+}
+
+int8_t retire_epoch(epoch_domain_t *const d, void *ptr, void (*free_fn)(void *))
+{
+    struct epoch_record *r = thread_record(d);
+
+    // never freeing the object is the only safe way out
+    if (r == NULL) return -1;
+
+    uint64_t e = atomic_load_explicit(&d->epoch, memory_order_acquire);
+    struct epoch_limbo *l = &r->limbo[e % 3];
+
+    // the bucket still holds objects from at least three epochs ago
+    if (l->epoch != e) {
+        free_limbo(l);
+        l->epoch = e;
+    }
+
+    if (l->count == l->capacity) {
+        uint32_t capacity = l->capacity ? l->capacity * 2 : EPOCH_SCAN;
+        void *items = realloc(l->items, sizeof(*l->items) * capacity);
+
+        if (items == NULL) return -1;
+
+        l->items = items;
+        l->capacity = capacity;
+    }
+
+    l->items[l->count].ptr = ptr;
+    l->items[l->count].free_fn = free_fn;
+    l->count++;
+
+    if (++r->retired >= EPOCH_SCAN) {
+        r->retired = 0;
+        advance_epoch(d);
+        collect_epoch(r, atomic_load_explicit(&d->epoch, memory_order_acquire));
+    }
+
+    return 1;
+}
+
+void flush_epoch(epoch_domain_t *const d)
+{
+    struct epoch_record *r = thread_record(d);
+
+    if (r == NULL) return;
+
+    // two advances move everything retired so far out of reach
+    for (int i = 0; i < 2; i++)
+        advance_epoch(d);
+
+    collect_epoch(r, atomic_load_explicit(&d->epoch, memory_order_acquire));
+}
@@ -0,0 +1,142 @@
+#include "datastructs.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** 4-bit counters in one block, a block fills a cache line */
+#define FILTER_BLOCK_COUNTERS (DATASTRUCTS_CACHE_LINE * 2)
+
+/** Counter value that sticks, it may stand for more hashes than it counts */
+#define FILTER_SATURATED 15
+
+/** Most counters per hash */
+#define FILTER_MAX_PROBES 16
+
+
+/**
+ * Filter - counters
+ */
+static uint8_t *block_filter(const filter_t *const f, uint64_t hash)
+{
+    // high half of the hash picks the block, scaled instead of masked
+    uint64_t block = ((hash >> 32) * f->block_count) >> 32;
+
+    return f->blocks + block * DATASTRUCTS_CACHE_LINE;
+}
+
+/**
+ * Counter i of a hash, the low bits of the hash give a start and an odd
+ * stride, so the counters of a hash are distinct
+ */
+static inline uint32_t counter_filter(uint64_t hash, uint32_t i)
+{
+    uint32_t start = hash & (FILTER_BLOCK_COUNTERS - 1);
+    uint32_t stride = (hash >> 7) | 1;
+
+    return (start + i * stride) & (FILTER_BLOCK_COUNTERS - 1);
+}
+
+static inline uint8_t get_counter(const uint8_t *block, uint32_t c)
+{
+    return block[c >> 1] >> ((c & 1) * 4) & 0xf;
+}
+
+static inline void inc_counter(uint8_t *block, uint32_t c)
+{
+    block[c >> 1] += 1 << ((c & 1) * 4);
+}
+
+static inline void dec_counter(uint8_t *block, uint32_t c)
+{
+    block[c >> 1] -= 1 << ((c & 1) * 4);
+}
+
+
+/**
+ * Filter - core
+ */
+filter_t *create_filter(uint64_t capacity, double fpr)
+{
+    filter_t *f = calloc(1, sizeof(filter_t));
+
+    if (f == NULL) return NULL;
+
+    if (capacity == 0) capacity = 1;
+    if (!(fpr > 0 && fpr < 1)) fpr = FILTER_DEFAULT_FPR;
+
+    // counters of a classic Bloom filter, a quarter more for the blocking
+    double per_item = -log(fpr) / (log(2) * log(2));
+    uint64_t counters = ceil(capacity * per_item * 1.25);
+    double probes = round(per_item * log(2));
+
+    f->capacity = capacity;
+    f->fpr = fpr;
+    f->probes = probes < 1 ? 1 : probes > FILTER_MAX_PROBES ? FILTER_MAX_PROBES : probes;
+    f->block_count = (counters + FILTER_BLOCK_COUNTERS - 1) / FILTER_BLOCK_COUNTERS;
+    f->blocks = aligned_alloc(DATASTRUCTS_CACHE_LINE, f->block_count * DATASTRUCTS_CACHE_LINE);
+
+    if (f->blocks == NULL) {
+        free(f);
+        return NULL;
+    }
+
+    reset_filter(f);
+    return f;
+}
+
+void reset_filter(filter_t *const f)
+{
+    memset(f->blocks, 0, f->block_count * DATASTRUCTS_CACHE_LINE);
+    f->count = 0;
+}
+
+void free_filter(filter_t *f)
+{
+    free(f->blocks);
+    free(f);
+}
+
+void add_filter(filter_t *const f, uint64_t hash)
+{
+    uint8_t *block = block_filter(f, hash);
+
+    for (uint32_t i = 0; i < f->probes; i++) {
+        uint32_t c = counter_filter(hash, i);
+
+        if (get_counter(block, c) < FILTER_SATURATED)
+            inc_counter(block, c);
+    }
+
+    f->count++;
+}
+
+void del_filter(filter_t *const f, uint64_t hash)
+{
+    uint8_t *block = block_filter(f, hash);
+
+    for (uint32_t i = 0; i < f->probes; i++) {
+        uint32_t c = counter_filter(hash, i);
+        uint8_t value = get_counter(block, c);
+
+        if (value > 0 && value < FILTER_SATURATED)
+            dec_counter(block, c);
+    }
+
+    f->count--;
+}
+
+int8_t contains_filter(const filter_t *const f, uint64_t hash)
+{
+    const uint8_t *block = block_filter(f, hash);
+
+    for (uint32_t i = 0; i < f->probes; i++)
+        if (get_counter(block, counter_filter(hash, i)) == 0)
+            return 0;
+
+    return 1;
+}
+
+size_t memory_filter(const filter_t *const f)
+{
+    return f->block_count * DATASTRUCTS_CACHE_LINE + sizeof(*f);
+}
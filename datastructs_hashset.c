@@ -0,0 +1,368 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Control byte of an empty slot, full slots keep the high bit clear */
+#define HASHSET_EMPTY 0x80
+
+/** Smallest table, in groups */
+#define HASHSET_MIN_GROUPS 1
+
+
+/**
+ * Hash set - hashing
+ */
+static uint64_t hash_string(const unsigned char *c)
+{
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (; *c != 0; c++)
+        h = (h ^ *c) * 0x100000001b3ULL;
+
+    return h;
+}
+
+static inline __attribute__((always_inline))
+uint64_t hash_hashset(hashset_t *const t, const uint8_t key_type, const void *const data)
+{
+    uint64_t h;
+
+    if (t->hash != NULL)
+        h = t->hash(data);
+    else switch (key_type) {
+        case BINARYTREE_KEY_INT64:  h = (uint64_t)*(const int64_t *)data; break;
+        case BINARYTREE_KEY_STRING: h = hash_string(data); break;
+        case BINARYTREE_KEY_CUSTOM: h = 0; break;
+        default:                    h = (uintptr_t)data; break;
+    }
+
+    // spread every input bit over the group index and the control byte
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline __attribute__((always_inline))
+bool equal_hashset(hashset_t *const t, const uint8_t key_type, const void *const a,
+        const void *const b)
+{
+    switch (key_type) {
+        case BINARYTREE_KEY_INT64:  return *(const int64_t *)a == *(const int64_t *)b;
+        case BINARYTREE_KEY_STRING: return strcmp(a, b) == 0;
+        case BINARYTREE_KEY_CUSTOM: return t->compare(a, b) == 0;
+        default:                    return a == b;
+    }
+}
+
+static inline uint8_t tag_hashset(uint64_t h)
+{
+    return h >> 57;
+}
+
+static inline uint64_t home_hashset(hashset_t *const t, uint64_t h)
+{
+    return h & (t->groups - 1);
+}
+
+
+/**
+ * Hash set - groups
+ */
+
+/**
+ * Bit i is set for every slot i of the group whose control byte is tag
+ */
+static inline uint32_t match_group(const uint8_t *const ctrl, uint8_t tag)
+{
+#ifdef __SSE2__
+    __m128i group = _mm_load_si128((const __m128i *)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+
+    for (int i = 0; i < HASHSET_GROUP; i++)
+        mask |= (uint32_t)(ctrl[i] == tag) << i;
+    return mask;
+#endif
+}
+
+/**
+ * Bit i is set for every empty slot i of the group
+ */
+static inline uint32_t match_empty(const uint8_t *const ctrl)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)ctrl));
+#else
+    uint32_t mask = 0;
+
+    for (int i = 0; i < HASHSET_GROUP; i++)
+        mask |= (uint32_t)(ctrl[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+/**
+ * Slot holding data or -1, the hash of data goes to h. Groups are probed in
+ * turn from the home group of the hash until one with an empty slot, items
+ * never sit behind such a group.
+ */
+static inline __attribute__((always_inline))
+int64_t probe_typed(hashset_t *const t, const uint8_t key_type, const void *const data,
+        uint64_t *const h)
+{
+    *h = hash_hashset(t, key_type, data);
+
+    if (t->count == 0) return -1;
+
+    uint8_t tag = tag_hashset(*h);
+
+    for (uint64_t g = home_hashset(t, *h); ; g = (g + 1) & (t->groups - 1)) {
+        const uint8_t *ctrl = t->ctrl + g * HASHSET_GROUP;
+        void **slots = t->slots + g * HASHSET_GROUP;
+
+        // the slots are needed on a tag match, fetch them alongside
+        __builtin_prefetch(slots);
+        __builtin_prefetch(slots + HASHSET_GROUP / 2);
+
+        for (uint32_t m = match_group(ctrl, tag); m != 0; m &= m - 1) {
+            int i = __builtin_ctz(m);
+
+            if (equal_hashset(t, key_type, data, slots[i]))
+                return g * HASHSET_GROUP + i;
+        }
+
+        if (match_empty(ctrl) != 0) return -1;
+    }
+}
+
+static int64_t probe_hashset(hashset_t *const t, const void *const data, uint64_t *const h)
+{
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return probe_typed(t, BINARYTREE_KEY_INT64, data, h);
+        case BINARYTREE_KEY_STRING:
+            return probe_typed(t, BINARYTREE_KEY_STRING, data, h);
+        case BINARYTREE_KEY_CUSTOM:
+            return probe_typed(t, BINARYTREE_KEY_CUSTOM, data, h);
+        default:
+            return probe_typed(t, BINARYTREE_KEY_ADDRESS, data, h);
+    }
+}
+
+/**
+ * Put an item not in the table into the first empty slot of its probe
+ */
+static void place_hashset(uint8_t *const ctrl, void **const slots, uint64_t groups,
+        uint64_t h, void *const data)
+{
+    for (uint64_t g = h & (groups - 1); ; g = (g + 1) & (groups - 1)) {
+        uint32_t empty = match_empty(ctrl + g * HASHSET_GROUP);
+
+        if (empty != 0) {
+            uint64_t slot = g * HASHSET_GROUP + __builtin_ctz(empty);
+
+            ctrl[slot] = tag_hashset(h);
+            slots[slot] = data;
+            return;
+        }
+    }
+}
+
+static uint64_t max_load_hashset(uint64_t groups)
+{
+    return groups * HASHSET_GROUP / 8 * 7;
+}
+
+/**
+ * Move all items into a table of the given number of groups
+ */
+static int8_t resize_hashset(hashset_t *const t, uint64_t groups)
+{
+    size_t slots = groups * HASHSET_GROUP;
+    uint8_t *ctrl = aligned_alloc(HASHSET_GROUP, slots);
+    void **data = malloc(sizeof(*data) * slots);
+
+    if (ctrl == NULL || data == NULL) {
+        free(ctrl);
+        free(data);
+        return -1;
+    }
+
+    memset(ctrl, HASHSET_EMPTY, slots);
+
+    for (uint64_t i = 0; i < t->groups * HASHSET_GROUP; i++)
+        if (t->ctrl[i] != HASHSET_EMPTY)
+            place_hashset(ctrl, data, groups,
+                    hash_hashset(t, t->key_type, t->slots[i]), t->slots[i]);
+
+    free(t->ctrl);
+    free(t->slots);
+
+    t->ctrl = ctrl;
+    t->slots = data;
+    t->groups = groups;
+    return 1;
+}
+
+/**
+ * Refill the slot emptied in a full group. Items probing past that group
+ * are moved back into the hole, which moves on to where they came from.
+ */
+static void shift_hashset(hashset_t *const t, uint64_t hole)
+{
+    uint64_t mask = t->groups - 1;
+    uint64_t g = hole / HASHSET_GROUP;
+
+    for (uint64_t j = (g + 1) & mask; j != g; j = (j + 1) & mask) {
+        uint8_t *ctrl = t->ctrl + j * HASHSET_GROUP;
+        uint32_t empty = match_empty(ctrl);
+
+        // any item of group j whose probe started at or before the hole
+        for (uint32_t full = ~empty & 0xffff; full != 0; full &= full - 1) {
+            uint64_t slot = j * HASHSET_GROUP + __builtin_ctz(full);
+            uint64_t home = home_hashset(t, hash_hashset(t, t->key_type, t->slots[slot]));
+
+            if (((j - home) & mask) >= ((j - g) & mask)) {
+                t->ctrl[hole] = t->ctrl[slot];
+                t->slots[hole] = t->slots[slot];
+                t->ctrl[slot] = HASHSET_EMPTY;
+
+                hole = slot;
+                g = j;
+                break;
+            }
+        }
+
+        // no probe passes a group that had an empty slot
+        if (empty != 0) return;
+    }
+}
+
+
+/**
+ * Hash set - core
+ */
+uint64_t hashed_key(uint8_t key_type, uint64_t (*hash)(const void *),
+        const void *const data)
+{
+    hashset_t t = { .hash = hash };
+
+    return hash_hashset(&t, key_type, data);
+}
+
+hashset_t *create_hashset(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *))
+{
+    hashset_t *t = calloc(1, sizeof(hashset_t));
+    t->key_type = key_type;
+    t->hash = hash;
+    t->compare = compare;
+    return t;
+}
+
+void reset_hashset(hashset_t *const t)
+{
+    if (t->ctrl != NULL)
+        memset(t->ctrl, HASHSET_EMPTY, t->groups * HASHSET_GROUP);
+
+    t->count = 0;
+}
+
+void free_hashset(hashset_t *t)
+{
+    free(t->ctrl);
+    free(t->slots);
+    free(t);
+}
+
+int8_t reserve_hashset(hashset_t *const t, uint64_t count)
+{
+    uint64_t groups = t->groups > 0 ? t->groups : HASHSET_MIN_GROUPS;
+
+    while (max_load_hashset(groups) < count)
+        groups *= 2;
+
+    if (groups == t->groups) return 1;
+
+    return resize_hashset(t, groups);
+}
+
+int8_t add_hashset(hashset_t *const t, void *const data)
+{
+    uint64_t h;
+
+    if (probe_hashset(t, data, &h) >= 0) return 0;
+
+    if (t->count + 1 > max_load_hashset(t->groups) &&
+            reserve_hashset(t, t->count + 1) < 0)
+        return -1;
+
+    place_hashset(t->ctrl, t->slots, t->groups, h, data);
+    t->count++;
+    return 1;
+}
+
+int8_t del_hashset(hashset_t *const t, void *const data)
+{
+    uint64_t h;
+    int64_t slot = probe_hashset(t, data, &h);
+
+    if (slot < 0) return -1;
+
+    uint8_t *ctrl = t->ctrl + slot / HASHSET_GROUP * HASHSET_GROUP;
+    bool full = match_empty(ctrl) == 0;
+
+    t->ctrl[slot] = HASHSET_EMPTY;
+    t->count--;
+
+    // only a full group can have been probed past
+    if (full)
+        shift_hashset(t, slot);
+
+    return 1;
+}
+
+void *find_hashset(hashset_t *const t, const void *const data)
+{
+    uint64_t h;
+    int64_t slot = probe_hashset(t, data, &h);
+
+    return slot >= 0 ? t->slots[slot] : NULL;
+}
+
+int8_t contains_hashset(hashset_t *const t, const void *const data)
+{
+    uint64_t h;
+    return probe_hashset(t, data, &h) >= 0;
+}
+
+
+/**
+ * Hash set - derived
+ */
+uint64_t count_hashset(hashset_t *const t)
+{
+    return t->count;
+}
+
+size_t memory_hashset(hashset_t *const t)
+{
+    return t->groups * HASHSET_GROUP * (sizeof(*t->ctrl) + sizeof(*t->slots)) +
+        sizeof(*t);
+}
+
+void map_hashset(hashset_t *const t, void (*func)(void *, void *), void *func_data)
+{
+    for (uint64_t i = 0; i < t->groups * HASHSET_GROUP; i++)
+        if (t->ctrl[i] != HASHSET_EMPTY)
+            func(t->slots[i], func_data);
+}
@@ -0,0 +1,141 @@
+#include "datastructs.h"
+#include <stdlib.h>
+
+
+/**
+ * Lock-free queue - nodes
+ */
+static lf_node_t *alloc_lfnode(void *const data)
+{
+    lf_node_t *n = alloc_node_pool(shared_node_pool(NODE_POOL_LF));
+
+    if (n == NULL) return NULL;
+
+    n->data = data;
+    atomic_init(&n->next, NULL);
+    return n;
+}
+
+static void release_lfnode(void *n)
+{
+    release_node_pool(shared_node_pool(NODE_POOL_LF), n);
+}
+
+
+/**
+ * Lock-free queue - core
+ */
+lf_queue_t *create_lf_queue()
+{
+    lf_queue_t *q = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*q));
+
+    if (q == NULL) return NULL;
+
+    lf_node_t *dummy = alloc_lfnode(NULL);
+
+    q->epoch = shared_epoch_domain();
+
+    if (dummy == NULL || q->epoch == NULL) {
+        if (dummy != NULL)
+            release_lfnode(dummy);
+        free(q);
+        return NULL;
+    }
+
+    atomic_init(&q->first, dummy);
+    atomic_init(&q->last, dummy);
+
+    return q;
+}
+
+void free_lf_queue(lf_queue_t *q)
+{
+    lf_node_t *n = atomic_load(&q->first);
+    lf_node_t *tmp;
+
+    while (n != NULL) {
+        tmp = atomic_load_explicit(&n->next, memory_order_relaxed);
+        release_lfnode(n);
+        n = tmp;
+    }
+
+    free(q);
+}
+
+int8_t add_lf_queue(lf_queue_t *const q, void *const data)
+{
+    lf_node_t *n = alloc_lfnode(data);
+    lf_node_t *last, *next;
+
+    if (n == NULL) return -1;
+
+    if (enter_epoch(q->epoch) < 0) {
+        release_lfnode(n);
+        return -1;
+    }
+
+    while (1) {
+        last = atomic_load_explicit(&q->last, memory_order_acquire);
+        next = atomic_load_explicit(&last->next, memory_order_acquire);
+
+        if (last != atomic_load_explicit(&q->last, memory_order_acquire))
+            continue;
+
+        if (next != NULL) {
+            // help a slow add that linked its node but did not move last yet
+            atomic_compare_exchange_weak_explicit(&q->last, &last, next,
+                    memory_order_release, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&last->next, &next, n,
+                    memory_order_release, memory_order_relaxed))
+            break;
+    }
+
+    atomic_compare_exchange_strong_explicit(&q->last, &last, n,
+            memory_order_release, memory_order_relaxed);
+
+    exit_epoch(q->epoch);
+    return 1;
+}
+
+void *pop_lf_queue(lf_queue_t *const q)
+{
+    lf_node_t *first, *last, *next;
+    void *data;
+
+    if (enter_epoch(q->epoch) < 0) return NULL;
+
+    while (1) {
+        first = atomic_load_explicit(&q->first, memory_order_acquire);
+        last = atomic_load_explicit(&q->last, memory_order_acquire);
+        next = atomic_load_explicit(&first->next, memory_order_acquire);
+
+        if (first != atomic_load_explicit(&q->first, memory_order_acquire))
+            continue;
+
+        if (next == NULL) {
+            exit_epoch(q->epoch);
+            return NULL;
+        }
+
+        if (first == last) {
+            atomic_compare_exchange_weak_explicit(&q->last, &last, next,
+                    memory_order_release, memory_order_relaxed);
+            continue;
+        }
+
+        // next becomes the new dummy, its data has to be read before that
+        data = next->data;
+
+        if (atomic_compare_exchange_weak_explicit(&q->first, &first, next,
+                    memory_order_acq_rel, memory_order_relaxed))
+            break;
+    }
+
+    retire_epoch(q->epoch, first, release_lfnode);
+    exit_epoch(q->epoch);
+
+    return data;
+}
@@ -0,0 +1,163 @@
+#include "datastructs.h"
+#include <stdlib.h>
+
+
+/**
+ * First node address and version share one word, user space addresses fit
+ * in the lower 48 bits on x86-64 and aarch64
+ */
+#define ADDRESS_BITS 48
+#define ADDRESS_MASK ((1ULL << ADDRESS_BITS) - 1)
+
+#define FIRST_NODE(v) ((lf_node_t *)(uintptr_t)((v) & ADDRESS_MASK))
+#define FIRST_NEXT(v, n) ((uint64_t)(uintptr_t)(n) | \
+        (((v) >> ADDRESS_BITS) + 1) << ADDRESS_BITS)
+
+/** Number of polls a push waits in an exchange slot for a pop */
+#define ELIMINATION_WAIT 128
+
+/** Marks an offer that a pop has taken */
+static char taken;
+
+static __attribute__((tls_model("initial-exec")))
+    _Thread_local uint32_t slot_seed;
+
+
+/**
+ * Lock-free stack - elimination
+ */
+static struct lf_exchanger *pick_exchanger(lf_stack_t *const s)
+{
+    if (slot_seed == 0)
+        slot_seed = (uint32_t)(uintptr_t)&slot_seed | 1;
+
+    slot_seed ^= slot_seed << 13;
+    slot_seed ^= slot_seed >> 17;
+    slot_seed ^= slot_seed << 5;
+
+    return &s->elimination[slot_seed % LF_STACK_ELIMINATION];
+}
+
+static bool offer_lf_stack(lf_stack_t *const s, void *const data)
+{
+    struct lf_exchanger *x = pick_exchanger(s);
+    void *expected = NULL;
+
+    if (!atomic_compare_exchange_strong_explicit(&x->offer, &expected, data,
+                memory_order_release, memory_order_relaxed))
+        return false;
+
+    for (int i = 0; i < ELIMINATION_WAIT; i++)
+        if (atomic_load_explicit(&x->offer, memory_order_acquire) == &taken)
+            break;
+
+    // withdraw, unless a pop took the offer in the meantime
+    expected = data;
+    if (atomic_compare_exchange_strong_explicit(&x->offer, &expected, NULL,
+                memory_order_relaxed, memory_order_relaxed))
+        return false;
+
+    atomic_store_explicit(&x->offer, NULL, memory_order_release);
+    return true;
+}
+
+static bool take_lf_stack(lf_stack_t *const s, void **data)
+{
+    struct lf_exchanger *x = pick_exchanger(s);
+    void *offer = atomic_load_explicit(&x->offer, memory_order_acquire);
+
+    if (offer == NULL || offer == &taken)
+        return false;
+
+    if (!atomic_compare_exchange_strong_explicit(&x->offer, &offer, &taken,
+                memory_order_acq_rel, memory_order_relaxed))
+        return false;
+
+    *data = offer;
+    return true;
+}
+
+
+/**
+ * Lock-free stack - core
+ */
+lf_stack_t *create_lf_stack()
+{
+    lf_stack_t *s = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*s));
+
+    if (s == NULL) return NULL;
+
+    atomic_init(&s->first, 0);
+    for (int i = 0; i < LF_STACK_ELIMINATION; i++)
+        atomic_init(&s->elimination[i].offer, NULL);
+
+    return s;
+}
+
+void free_lf_stack(lf_stack_t *s)
+{
+    lf_node_t *n = FIRST_NODE(atomic_load(&s->first));
+    lf_node_t *tmp;
+
+    while (n != NULL) {
+        tmp = atomic_load_explicit(&n->next, memory_order_relaxed);
+        release_node_pool(shared_node_pool(NODE_POOL_LF), n);
+        n = tmp;
+    }
+
+    free(s);
+}
+
+int8_t add_lf_stack(lf_stack_t *const s, void *const data)
+{
+    node_pool_t *pool = shared_node_pool(NODE_POOL_LF);
+    lf_node_t *n = alloc_node_pool(pool);
+    uint64_t first = atomic_load_explicit(&s->first, memory_order_relaxed);
+
+    if (n == NULL) return -1;
+
+    n->data = data;
+
+    while (1) {
+        atomic_store_explicit(&n->next, FIRST_NODE(first), memory_order_relaxed);
+
+        if (atomic_compare_exchange_weak_explicit(&s->first, &first,
+                    FIRST_NEXT(first, n), memory_order_release, memory_order_relaxed))
+            return 1;
+
+        // NULL can not be told apart from an empty slot
+        if (data != NULL && offer_lf_stack(s, data)) {
+            release_node_pool(pool, n);
+            return 1;
+        }
+
+        first = atomic_load_explicit(&s->first, memory_order_relaxed);
+    }
+}
+
+void *pop_lf_stack(lf_stack_t *const s)
+{
+    uint64_t first = atomic_load_explicit(&s->first, memory_order_acquire);
+    void *data;
+
+    while (1) {
+        lf_node_t *n = FIRST_NODE(first);
+
+        if (n == NULL) return NULL;
+
+        // n may be popped and reused meanwhile, the version makes the CAS fail
+        lf_node_t *next = atomic_load_explicit(&n->next, memory_order_relaxed);
+
+        if (atomic_compare_exchange_weak_explicit(&s->first, &first,
+                    FIRST_NEXT(first, next), memory_order_acquire, memory_order_acquire)) {
+            data = n->data;
+            release_node_pool(shared_node_pool(NODE_POOL_LF), n);
+            return data;
+        }
+
+        if (take_lf_stack(s, &data))
+            return data;
+
+        first = atomic_load_explicit(&s->first, memory_order_acquire);
+    }
+}
@@ -0,0 +1,109 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * MPMC queue - core
+ */
+mpmc_queue_t *create_mpmc_queue(uint32_t capacity)
+{
+    mpmc_queue_t *q = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*q));
+    uint64_t size = 2;
+
+    if (q == NULL) return NULL;
+
+    while (size < capacity)
+        size <<= 1;
+
+    memset(q, 0, sizeof(*q));
+    q->slots = malloc(sizeof(*q->slots) * size);
+    q->mask = size - 1;
+
+    if (q->slots == NULL) {
+        free(q);
+        return NULL;
+    }
+
+    // slot i is ready for the add at position i
+    for (uint64_t i = 0; i < size; i++)
+        atomic_init(&q->slots[i].sequence, i);
+
+    return q;
+}
+
+void free_mpmc_queue(mpmc_queue_t *q)
+{
+    free(q->slots);
+    free(q);
+}
+
+int8_t try_add_mpmc_queue(mpmc_queue_t *const q, void *const data)
+{
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    struct mpmc_slot *slot;
+
+    while (1) {
+        slot = &q->slots[pos & q->mask];
+
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return 0; // slot still holds the item from one lap ago
+        else
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    }
+
+    slot->data = data;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    return 1;
+}
+
+void *try_pop_mpmc_queue(mpmc_queue_t *const q)
+{
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    struct mpmc_slot *slot;
+
+    while (1) {
+        slot = &q->slots[pos & q->mask];
+
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return NULL; // slot not filled yet
+        else
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
+
+    void *data = slot->data;
+    // hand the slot to the add one lap ahead
+    atomic_store_explicit(&slot->sequence, pos + q->mask + 1, memory_order_release);
+
+    return data;
+}
+
+/**
+ * MPMC queue - derived
+ */
+uint32_t count_mpmc_queue(mpmc_queue_t *const q)
+{
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    if (tail <= head) return 0;
+
+    return tail - head > q->mask + 1 ? q->mask + 1 : tail - head;
+}
@@ -7,25 +7,64 @@
  */
 sl_node_t *create_slnode(void *const data) 
 {
-    struct sl_node *n = malloc(sizeof(*n));
+    return alloc_slnode(NULL, data);
+}
+
+dl_node_t *create_dlnode(void *const data) 
+{
+    return alloc_dlnode(NULL, data);
+}
+
+dlp_node_t *create_dlpnode(void *const data) 
+{
+    return alloc_dlpnode(NULL, data);
+}
+
+sl_node_t *alloc_slnode(node_pool_t *const p, void *const data)
+{
+    struct sl_node *n = p ? alloc_node_pool(p) : malloc(sizeof(*n));
     n->data = data;
+    n->next = NULL;
     return n;
 }
 
-dl_node_t *create_dlnode(void *const data) 
+dl_node_t *alloc_dlnode(node_pool_t *const p, void *const data)
 {
-    struct dl_node *n = malloc(sizeof(*n));
+    struct dl_node *n = p ? alloc_node_pool(p) : malloc(sizeof(*n));
     n->data = data;
+    n->prev = n->next = NULL;
     return n;
 }
 
-dlp_node_t *create_dlpnode(void *const data) 
+dlp_node_t *alloc_dlpnode(node_pool_t *const p, void *const data)
 {
-    struct dlp_node *n = malloc(sizeof(*n));
+    struct dlp_node *n = p ? alloc_node_pool(p) : malloc(sizeof(*n));
     n->data = data;
+    n->parent = n->prev = n->next = NULL;
+    n->key = 0;
+    n->color = NODE_RED;
+    n->size = 1;
     return n;
 }
 
+void release_slnode(node_pool_t *const p, sl_node_t *n)
+{
+    if (p) release_node_pool(p, n);
+    else free(n);
+}
+
+void release_dlnode(node_pool_t *const p, dl_node_t *n)
+{
+    if (p) release_node_pool(p, n);
+    else free(n);
+}
+
+void release_dlpnode(node_pool_t *const p, dlp_node_t *n)
+{
+    if (p) release_node_pool(p, n);
+    else free(n);
+}
+
 void free_slnode(sl_node_t *n)
 {
     free(n->data);
@@ -48,23 +87,33 @@ void free_dlpnode(dlp_node_t *n)
  * Node types, derived
  */
 void free_slnode_seq(sl_node_t *n)
+{
+    release_slnode_seq(NULL, n);
+}
+
+void free_dlnode_seq(dl_node_t *n)
+{
+    release_dlnode_seq(NULL, n);
+}
+
+void release_slnode_seq(node_pool_t *const p, sl_node_t *n)
 {
     struct sl_node *tmp;
 
     while (n != NULL) {
         tmp = n->next;
-        free(n);
+        release_slnode(p, n);
         n = tmp;
     }
 }
 
-void free_dlnode_seq(dl_node_t *n)
+void release_dlnode_seq(node_pool_t *const p, dl_node_t *n)
 {
     struct dl_node *tmp;
 
     while (n != NULL) {
         tmp = n->next;
-        free(n);
+        release_dlnode(p, n);
         n = tmp;
     }
 }
@@ -73,7 +122,7 @@ void map_slnode_seq(sl_node_t *const node, void (*func)(sl_node_t *, void *), vo
 {
     sl_node_t *n = node;
     while (n != NULL) {
-        func(n, NULL);
+        func(n, func_data);
         n = n->next;
     }
 }
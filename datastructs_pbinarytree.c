@@ -0,0 +1,447 @@
+#include "datastructs.h"
+#include <string.h>
+
+
+/**
+ * Immutable once published, only the write creating a node changes it
+ */
+struct pb_node {
+    void *data;
+    union {
+        struct {
+            struct pb_node *prev;
+            struct pb_node *next;
+        };
+        struct pb_node *child[2];   // prev and next, indexed by a comparison
+    };
+    uint64_t key;
+    uint64_t write;     // write that created the node
+    int32_t height;
+};
+
+/**
+ * Nodes one write created and the ones it replaced
+ */
+struct pb_write {
+    pbinarytree_t *t;
+    uint64_t write;
+    uint32_t replaced_count, created_count;
+    struct pb_node *replaced[3 * PBINARYTREE_MAX_HEIGHT];
+    struct pb_node *created[3 * PBINARYTREE_MAX_HEIGHT];
+    bool failed;        // out of memory, published nodes stay untouched
+};
+
+
+/**
+ * Persistent binary tree
+ */
+pbinarytree_t *create_pbinarytree(uint8_t key_type,
+        int (*compare)(const void *, const void *), uint64_t (*prefix)(const void *))
+{
+    pbinarytree_t *t = calloc(1, sizeof(*t));
+
+    pthread_mutex_init(&t->lock, NULL);
+    t->domain = create_epoch_domain();
+    t->key_type = key_type;
+    t->compare = compare;
+    t->prefix = prefix;
+
+    return t;
+}
+
+static void free_pb_nodes(struct pb_node *n)
+{
+    if (n == NULL) return;
+
+    // depth is bounded by PBINARYTREE_MAX_HEIGHT
+    free_pb_nodes(n->prev);
+    free_pb_nodes(n->next);
+    free(n);
+}
+
+void free_pbinarytree(pbinarytree_t *t)
+{
+    free_pb_nodes(atomic_load(&t->root));
+    free_epoch_domain(t->domain); // nodes of old versions
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+}
+
+uint64_t count_pbinarytree(pbinarytree_t *const t)
+{
+    return atomic_load_explicit(&t->count, memory_order_relaxed);
+}
+
+
+/**
+ * Persistent binary tree - order
+ */
+
+/**
+ * Always inlined with a constant key type in searches, so every key type
+ * gets its own descent without an indirect call
+ */
+static inline __attribute__((always_inline))
+int compare_pbinarytree(pbinarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data, const struct pb_node *const n)
+{
+    if (key != n->key)
+        return key < n->key ? -1 : 1;
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING: return strcmp(data, n->data);
+        case BINARYTREE_KEY_CUSTOM: return t->compare(data, n->data);
+        default:                    return 0; // key is the whole value
+    }
+}
+
+/**
+ * Descend a version towards data, remembering the lowest node after it
+ */
+static inline __attribute__((always_inline))
+const struct pb_node *descend_typed(pbinarytree_t *const t, const uint8_t key_type,
+        uint64_t key, const void *const data, const struct pb_node *n,
+        const struct pb_node **bound)
+{
+    const struct pb_node *after = NULL;
+    int order;
+
+    // index instead of branch, a mispredicted step starts loading a wrong path
+    while (n != NULL && (order = compare_pbinarytree(t, key_type, key, data, n)) != 0) {
+        after = order < 0 ? n : after;
+        n = n->child[order > 0];
+    }
+
+    *bound = after;
+    return n;
+}
+
+/**
+ * Node holding data in a version or NULL, bound gets the lowest node after
+ */
+static const struct pb_node *descend_pbinarytree(pbinarytree_t *const t,
+        const struct pb_node *version, const void *const data,
+        const struct pb_node **bound)
+{
+    uint64_t key = cached_key(t->key_type, t->prefix, data);
+
+    switch (t->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return descend_typed(t, BINARYTREE_KEY_INT64, key, data, version, bound);
+        case BINARYTREE_KEY_STRING:
+            return descend_typed(t, BINARYTREE_KEY_STRING, key, data, version, bound);
+        case BINARYTREE_KEY_CUSTOM:
+            return descend_typed(t, BINARYTREE_KEY_CUSTOM, key, data, version, bound);
+        default:
+            return descend_typed(t, BINARYTREE_KEY_ADDRESS, key, data, version, bound);
+    }
+}
+
+
+/**
+ * Persistent binary tree - path copying
+ */
+static int32_t height_pb(const struct pb_node *const n)
+{
+    return n != NULL ? n->height : 0;
+}
+
+static void update_pb(struct pb_node *const n)
+{
+    int32_t prev = height_pb(n->prev), next = height_pb(n->next);
+    n->height = 1 + (prev > next ? prev : next);
+}
+
+static struct pb_node *create_pb(struct pb_write *const w)
+{
+    struct pb_node *n = malloc(sizeof(*n));
+
+    if (n == NULL)
+        w->failed = true;
+    else
+        w->created[w->created_count++] = n;
+
+    return n;
+}
+
+/**
+ * Node of this write standing for n, copying n the first time it changes.
+ * Callers check failed before changing what they get.
+ */
+static struct pb_node *own_pb(struct pb_write *const w, struct pb_node *const n)
+{
+    if (n->write == w->write)
+        return n;
+
+    struct pb_node *copy = create_pb(w);
+
+    if (copy == NULL)
+        return n;
+
+    *copy = *n;
+    copy->write = w->write;
+    w->replaced[w->replaced_count++] = n;
+    return copy;
+}
+
+/**
+ * Rotations take and return nodes owned by the write
+ */
+static struct pb_node *rotate_next_pb(struct pb_write *const w, struct pb_node *const n)
+{
+    struct pb_node *up = own_pb(w, n->prev);
+
+    if (w->failed) return n;
+
+    n->prev = up->next;
+    up->next = n;
+    update_pb(n);
+    update_pb(up);
+    return up;
+}
+
+static struct pb_node *rotate_prev_pb(struct pb_write *const w, struct pb_node *const n)
+{
+    struct pb_node *up = own_pb(w, n->next);
+
+    if (w->failed) return n;
+
+    n->next = up->prev;
+    up->prev = n;
+    update_pb(n);
+    update_pb(up);
+    return up;
+}
+
+static struct pb_node *balance_pb(struct pb_write *const w, struct pb_node *const n)
+{
+    int32_t balance = height_pb(n->prev) - height_pb(n->next);
+
+    update_pb(n);
+
+    if (balance > 1) {
+        if (height_pb(n->prev->prev) < height_pb(n->prev->next))
+            n->prev = rotate_prev_pb(w, own_pb(w, n->prev));
+        return rotate_next_pb(w, n);
+    }
+
+    if (balance < -1) {
+        if (height_pb(n->next->next) < height_pb(n->next->prev))
+            n->next = rotate_next_pb(w, own_pb(w, n->next));
+        return rotate_prev_pb(w, n);
+    }
+
+    return n;
+}
+
+static struct pb_node *add_pb(struct pb_write *const w, struct pb_node *const n,
+        uint64_t key, void *const data)
+{
+    if (n == NULL) {
+        struct pb_node *fresh = create_pb(w);
+
+        if (fresh == NULL)
+            return NULL;
+
+        *fresh = (struct pb_node) {
+            .data = data, .key = key, .write = w->write, .height = 1
+        };
+        return fresh;
+    }
+
+    int order = compare_pbinarytree(w->t, w->t->key_type, key, data, n);
+
+    if (order == 0)
+        return n;
+
+    struct pb_node *child = add_pb(w, order < 0 ? n->prev : n->next, key, data);
+
+    // unchanged below, so n stays as it is
+    if (child == (order < 0 ? n->prev : n->next) || w->failed)
+        return n;
+
+    struct pb_node *c = own_pb(w, n);
+
+    if (w->failed) return n;
+
+    if (order < 0) c->prev = child;
+    else c->next = child;
+
+    return balance_pb(w, c);
+}
+
+/**
+ * Subtree without its lowest node, which is handed out in lowest
+ */
+static struct pb_node *del_lowest_pb(struct pb_write *const w, struct pb_node *const n,
+        struct pb_node **lowest)
+{
+    if (n->prev == NULL) {
+        *lowest = n;
+        return n->next;
+    }
+
+    struct pb_node *c = own_pb(w, n);
+    struct pb_node *prev = del_lowest_pb(w, n->prev, lowest);
+
+    if (w->failed) return n;
+
+    c->prev = prev;
+    return balance_pb(w, c);
+}
+
+static struct pb_node *del_pb(struct pb_write *const w, struct pb_node *const n,
+        uint64_t key, void *const data, bool *deleted)
+{
+    if (n == NULL)
+        return NULL;
+
+    int order = compare_pbinarytree(w->t, w->t->key_type, key, data, n);
+
+    if (order != 0) {
+        struct pb_node *child = del_pb(w, order < 0 ? n->prev : n->next, key, data, deleted);
+
+        if (!*deleted || w->failed)
+            return n;
+
+        struct pb_node *c = own_pb(w, n);
+
+        if (w->failed) return n;
+
+        if (order < 0) c->prev = child;
+        else c->next = child;
+
+        return balance_pb(w, c);
+    }
+
+    *deleted = true;
+    w->replaced[w->replaced_count++] = n;
+
+    if (n->prev == NULL) return n->next;
+    if (n->next == NULL) return n->prev;
+
+    // the lowest node after n moves into its place
+    struct pb_node *lowest;
+    struct pb_node *next = del_lowest_pb(w, n->next, &lowest);
+    struct pb_node *c = w->failed ? n : own_pb(w, lowest);
+
+    if (w->failed) return n;
+
+    c->prev = n->prev;
+    c->next = next;
+    return balance_pb(w, c);
+}
+
+/**
+ * Publish the new root, then retire what it replaced. A reader acquiring the
+ * old root before the store is inside its critical section already, so the
+ * retired nodes outlive it.
+ */
+static void publish_pb(struct pb_write *const w, struct pb_node *const root, int64_t delta)
+{
+    pbinarytree_t *t = w->t;
+
+    atomic_store_explicit(&t->root, root, memory_order_release);
+    atomic_fetch_add_explicit(&t->count, delta, memory_order_relaxed);
+
+    for (uint32_t i = 0; i < w->replaced_count; i++)
+        retire_epoch(t->domain, w->replaced[i], free);
+}
+
+/**
+ * Drop the nodes of a failed write, the published version never saw them
+ */
+static void abandon_pb(struct pb_write *const w)
+{
+    for (uint32_t i = 0; i < w->created_count; i++)
+        free(w->created[i]);
+}
+
+int8_t add_pbinarytree(pbinarytree_t *const t, void *const data)
+{
+    uint64_t key = cached_key(t->key_type, t->prefix, data);
+    int8_t result = 1;
+
+    pthread_mutex_lock(&t->lock);
+
+    struct pb_write w = { .t = t, .write = ++t->writes };
+    struct pb_node *root = atomic_load_explicit(&t->root, memory_order_relaxed);
+    struct pb_node *added = add_pb(&w, root, key, data);
+
+    if (w.failed) {
+        abandon_pb(&w);
+        result = -1;
+    } else if (added == root)
+        result = 0;
+    else
+        publish_pb(&w, added, 1);
+
+    pthread_mutex_unlock(&t->lock);
+    return result;
+}
+
+int8_t del_pbinarytree(pbinarytree_t *const t, void *const data)
+{
+    uint64_t key = cached_key(t->key_type, t->prefix, data);
+    bool deleted = false;
+    int8_t result = 1;
+
+    pthread_mutex_lock(&t->lock);
+
+    struct pb_write w = { .t = t, .write = ++t->writes };
+    struct pb_node *root = atomic_load_explicit(&t->root, memory_order_relaxed);
+    struct pb_node *rest = del_pb(&w, root, key, data, &deleted);
+
+    if (w.failed) {
+        abandon_pb(&w);
+        result = -1;
+    } else if (!deleted)
+        result = -1;
+    else
+        publish_pb(&w, rest, -1);
+
+    pthread_mutex_unlock(&t->lock);
+    return result;
+}
+
+
+/**
+ * Persistent binary tree - reading
+ */
+const pb_node_t *acquire_pbinarytree(pbinarytree_t *const t)
+{
+    enter_epoch(t->domain);
+    return atomic_load_explicit(&t->root, memory_order_acquire);
+}
+
+void release_pbinarytree(pbinarytree_t *const t)
+{
+    exit_epoch(t->domain);
+}
+
+void *find_pbinarytree(pbinarytree_t *const t, const pb_node_t *version,
+        void *const data)
+{
+    const struct pb_node *bound;
+    const struct pb_node *n = descend_pbinarytree(t, version, data, &bound);
+
+    return n != NULL ? n->data : NULL;
+}
+
+void *lower_bound_pbinarytree(pbinarytree_t *const t, const pb_node_t *version,
+        void *const data)
+{
+    const struct pb_node *bound;
+    const struct pb_node *n = descend_pbinarytree(t, version, data, &bound);
+
+    if (n != NULL) return n->data;
+    return bound != NULL ? bound->data : NULL;
+}
+
+void *search_pbinarytree(pbinarytree_t *const t, void *const data)
+{
+    void *found = find_pbinarytree(t, acquire_pbinarytree(t), data);
+
+    release_pbinarytree(t);
+    return found;
+}
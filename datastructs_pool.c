@@ -0,0 +1,220 @@
+#include "datastructs.h"
+#include <stdlib.h>
+
+
+/**
+ * Slab header, nodes follow directly after it
+ */
+struct node_slab {
+    struct node_slab *next;
+    void *nodes[];
+};
+
+/**
+ * Per-thread cache of nodes for one shared pool
+ */
+struct node_magazine {
+    uint32_t count;
+    void *nodes[NODE_POOL_MAGAZINE];
+};
+
+static node_pool_t shared_pools[NODE_POOL_SHARED] = {
+    [NODE_POOL_SL] = {
+        .node_size = sizeof(sl_node_t), .slab_nodes = NODE_POOL_SLAB,
+        .shared = NODE_POOL_SL, .lock = PTHREAD_MUTEX_INITIALIZER
+    },
+    [NODE_POOL_DL] = {
+        .node_size = sizeof(dl_node_t), .slab_nodes = NODE_POOL_SLAB,
+        .shared = NODE_POOL_DL, .lock = PTHREAD_MUTEX_INITIALIZER
+    },
+    [NODE_POOL_DLP] = {
+        .node_size = sizeof(dlp_node_t), .slab_nodes = NODE_POOL_SLAB,
+        .shared = NODE_POOL_DLP, .lock = PTHREAD_MUTEX_INITIALIZER
+    },
+    [NODE_POOL_LF] = {
+        .node_size = sizeof(lf_node_t), .slab_nodes = NODE_POOL_SLAB,
+        .shared = NODE_POOL_LF, .lock = PTHREAD_MUTEX_INITIALIZER
+    },
+};
+
+// initial-exec avoids a __tls_get_addr call on every pooled node operation
+static __attribute__((tls_model("initial-exec")))
+    _Thread_local struct node_magazine magazines[NODE_POOL_SHARED];
+static __attribute__((tls_model("initial-exec")))
+    _Thread_local bool magazines_registered;
+static pthread_key_t magazine_key;
+static pthread_once_t magazine_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Node pool - core
+ */
+static size_t node_stride(size_t node_size)
+{
+    // nodes are aligned to (and large enough for) the free list link
+    return (node_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+}
+
+static void *carve_node_pool(node_pool_t *const p)
+{
+    struct node_slab *slab = p->slab;
+
+    if (slab == NULL || p->carved == p->slab_nodes) {
+        // reuse slabs kept by a reset before growing
+        if (slab != NULL && slab->next != NULL)
+            slab = slab->next;
+        else {
+            struct node_slab *fresh = malloc(sizeof(*fresh)
+                    + node_stride(p->node_size) * p->slab_nodes);
+
+            if (fresh == NULL) return NULL;
+            fresh->next = NULL;
+
+            if (slab == NULL) p->slabs = fresh;
+            else slab->next = fresh;
+            slab = fresh;
+        }
+
+        p->slab = slab;
+        p->carved = 0;
+    }
+
+    return (unsigned char *)slab->nodes + node_stride(p->node_size) * p->carved++;
+}
+
+static void *take_node_pool(node_pool_t *const p)
+{
+    void *n = p->free;
+
+    if (n == NULL) return carve_node_pool(p);
+
+    p->free = *(void **)n;
+    return n;
+}
+
+static void give_node_pool(node_pool_t *const p, void *n)
+{
+    *(void **)n = p->free;
+    p->free = n;
+}
+
+node_pool_t *create_node_pool(size_t node_size, uint32_t slab_nodes)
+{
+    node_pool_t *p = calloc(1, sizeof(*p));
+
+    p->node_size = node_size;
+    p->slab_nodes = slab_nodes > 0 ? slab_nodes : NODE_POOL_SLAB;
+    p->shared = -1;
+
+    return p;
+}
+
+void reset_node_pool(node_pool_t *const p)
+{
+    if (p->shared >= 0) return;
+
+    p->free = NULL;
+    p->slab = p->slabs;
+    p->carved = 0;
+}
+
+void free_node_pool(node_pool_t *p)
+{
+    if (p == NULL || p->shared >= 0) return;
+
+    struct node_slab *slab = p->slabs;
+    struct node_slab *tmp;
+
+    while (slab != NULL) {
+        tmp = slab->next;
+        free(slab);
+        slab = tmp;
+    }
+
+    free(p);
+}
+
+
+/**
+ * Node pool - shared pools with per-thread magazines
+ */
+static void flush_magazines(void *mags)
+{
+    struct node_magazine *m = mags;
+
+    for (int i = 0; i < NODE_POOL_SHARED; i++) {
+        if (m[i].count == 0) continue;
+
+        pthread_mutex_lock(&shared_pools[i].lock);
+        while (m[i].count > 0)
+            give_node_pool(&shared_pools[i], m[i].nodes[--m[i].count]);
+        pthread_mutex_unlock(&shared_pools[i].lock);
+    }
+}
+
+static void create_magazine_key()
+{
+    pthread_key_create(&magazine_key, flush_magazines);
+}
+
+static struct node_magazine *thread_magazine(int8_t shared)
+{
+    if (!magazines_registered) {
+        // the key destructor hands the magazines back when the thread exits
+        pthread_once(&magazine_once, create_magazine_key);
+        pthread_setspecific(magazine_key, magazines);
+        magazines_registered = true;
+    }
+
+    return &magazines[shared];
+}
+
+node_pool_t *shared_node_pool(enum node_pool_type type)
+{
+    return &shared_pools[type];
+}
+
+void flush_node_pool_cache()
+{
+    flush_magazines(magazines);
+}
+
+void *alloc_node_pool(node_pool_t *const p)
+{
+    if (p->shared < 0) return take_node_pool(p);
+
+    struct node_magazine *m = thread_magazine(p->shared);
+
+    if (m->count == 0) {
+        pthread_mutex_lock(&p->lock);
+        while (m->count < NODE_POOL_MAGAZINE / 2) {
+            void *n = take_node_pool(p);
+            if (n == NULL) break;
+            m->nodes[m->count++] = n;
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        if (m->count == 0) return NULL;
+    }
+
+    return m->nodes[--m->count];
+}
+
+void release_node_pool(node_pool_t *const p, void *n)
+{
+    if (p->shared < 0) {
+        give_node_pool(p, n);
+        return;
+    }
+
+    struct node_magazine *m = thread_magazine(p->shared);
+
+    if (m->count == NODE_POOL_MAGAZINE) {
+        pthread_mutex_lock(&p->lock);
+        while (m->count > NODE_POOL_MAGAZINE / 2)
+            give_node_pool(p, m->nodes[--m->count]);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    m->nodes[m->count++] = n;
+}
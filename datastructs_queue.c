@@ -1,5 +1,6 @@
 #include "datastructs.h"
 #include <stdlib.h>
+#include <string.h>
 
 
 /**
@@ -7,34 +8,133 @@
  */
 struct queue *create_queue()
 {
-    return malloc(sizeof(queue_t));
+    return calloc(1, sizeof(queue_t));
 }
 
-void add_queue(queue_t *const q, void *const data)
+struct queue *create_queue_pooled()
 {
+    queue_t *q = create_queue();
+    q->pool = shared_node_pool(NODE_POOL_SL);
+    return q;
+}
+
+struct queue *create_queue_arena()
+{
+    queue_t *q = create_queue();
+    q->pool = create_node_pool(sizeof(sl_node_t), NODE_ARENA_SLAB);
+    return q;
+}
+
+static int8_t grow_queue_ring(queue_t *const q, uint32_t capacity)
+{
+    void **ring = malloc(sizeof(*ring) * capacity);
+
+    if (ring == NULL) return -1;
+
+    // unwrap items so the first one ends up at index 0
+    uint32_t count = q->tail - q->head;
+    uint32_t first = q->head & q->mask;
+    uint32_t split = count < q->mask + 1 - first ? count : q->mask + 1 - first;
+
+    if (count > 0) {
+        memcpy(ring, q->ring + first, sizeof(*ring) * split);
+        memcpy(ring + split, q->ring, sizeof(*ring) * (count - split));
+    }
+
+    free(q->ring);
+    q->ring = ring;
+    q->mask = capacity - 1;
+    q->head = 0;
+    q->tail = count;
+
+    return 1;
+}
+
+struct queue *create_queue_ring(uint32_t capacity)
+{
+    // a larger ring would not round up to a power of two in 32 bits
+    if (capacity > 1u << 31) return NULL;
+
+    queue_t *q = create_queue();
+    uint32_t size = 16;
+
+    if (q == NULL) return NULL;
+
+    while (size < capacity)
+        size <<= 1;
+
+    q->mode = QUEUE_RING;
+
+    if (grow_queue_ring(q, size) < 0) {
+        free(q);
+        return NULL;
+    }
+
+    return q;
+}
+
+int8_t add_queue(queue_t *const q, void *const data)
+{
+    if (q->mode == QUEUE_RING) {
+        // like create_queue_ring, rings stop at 2^31 slots
+        if (q->tail - q->head > q->mask &&
+                (q->mask >= (1u << 31) - 1 || grow_queue_ring(q, (q->mask + 1) * 2) < 0))
+            return -1;
+
+        q->ring[q->tail++ & q->mask] = data;
+        return 1;
+    }
+
     if (q->last == NULL)
-        q->last = q->first = create_slnode(data);
+        q->last = q->first = alloc_slnode(q->pool, data);
     else {
-        q->last->next = create_slnode(data);
+        q->last->next = alloc_slnode(q->pool, data);
         q->last = q->last->next;
     }
+
+    return 1;
 }
 
 void *pop_queue(queue_t *const q)
 {
+    if (q->mode == QUEUE_RING)
+        return q->head != q->tail ? q->ring[q->head++ & q->mask] : NULL;
+
     if (q->first == NULL) return NULL;
 
     sl_node_t *tmp = q->first;
     q->first = q->first->next;
 
+    if (q->first == NULL)
+        q->last = NULL;
+
     void *data = tmp->data;
-    free(tmp); // Regular free() as we return the data pointer
+    release_slnode(q->pool, tmp); // Data pointer is returned, not freed
     return data;
 }
 
+void reset_queue(queue_t *const q)
+{
+    if (q->mode == QUEUE_LINKED) {
+        if (q->pool != NULL && q->pool->shared < 0)
+            reset_node_pool(q->pool);
+        else
+            release_slnode_seq(q->pool, q->first);
+    }
+
+    q->first = q->last = NULL;
+    q->head = q->tail = 0;
+}
+
 void free_queue(queue_t *q)
 {
-    free_slnode_seq(q->first);
+    if (q->mode == QUEUE_RING)
+        free(q->ring);
+    else if (q->pool != NULL && q->pool->shared < 0)
+        free_node_pool(q->pool); // Arena, nodes go with their slabs
+    else
+        release_slnode_seq(q->pool, q->first);
+
     free(q);
 }
 
@@ -42,15 +142,28 @@ void free_queue(queue_t *q)
  * Queue - derived
  */
 
-uint32_t count_queue(queue_t *const s) 
+uint32_t count_queue(queue_t *const q) 
 {
-    if (s->first == NULL)
+    if (q->mode == QUEUE_RING)
+        return q->tail - q->head;
+
+    if (q->first == NULL)
         return 0;
 
-    count_slnode_seq(s->first);
+    return count_slnode_seq(q->first);
 }
 
 void map_queue(queue_t *const q, void (*func)(sl_node_t *, void *), void *func_data)
 {
+    if (q->mode == QUEUE_RING) {
+        sl_node_t n = { .next = NULL };
+
+        for (uint32_t i = q->head; i != q->tail; i++) {
+            n.data = q->ring[i & q->mask];
+            func(&n, func_data);
+        }
+        return;
+    }
+
     map_slnode_seq(q->first, func, func_data);
 }
@@ -1,6 +1,11 @@
 #include "datastructs.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Smallest capacity of the filter of a set */
+#define SET_FILTER_MIN 1024
 
 
 /**
@@ -8,17 +13,210 @@
  */
 set_t *create_set()
 {
-    return malloc(sizeof(set_t));
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree();
+    return s;
 }
 
-int8_t add_set(set_t *const s, void *const data)
+set_t *create_set_pooled()
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_pooled();
+    return s;
+}
+
+set_t *create_set_arena()
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_arena();
+    return s;
+}
+
+set_t *create_set_mode(uint8_t mode)
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_mode(mode);
+    return s;
+}
+
+set_t *create_set_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *))
 {
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_cmp(compare, prefix);
+    return s;
+}
+
+set_t *create_set_int()
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_int();
+    return s;
+}
+
+set_t *create_set_str()
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->tree = create_binarytree_str();
+    return s;
+}
+
+set_t *create_set_btree(uint8_t key_type, int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *))
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->btree = create_btree();
+    s->btree->key_type = key_type;
+    s->btree->compare = compare;
+    s->btree->prefix = prefix;
+    s->backend = SET_BTREE;
+    return s;
+}
+
+set_t *create_set_hash(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *))
+{
+    set_t *s = calloc(1, sizeof(set_t));
+    s->hash = create_hashset(key_type, hash, compare);
+    s->backend = SET_HASH;
+    return s;
+}
+
+/**
+ * Set - filter
+ */
+static uint64_t hash_set(set_t *const s, const void *const data)
+{
+    switch (s->backend) {
+        case SET_HASH:
+            return hashed_key(s->hash->key_type, s->hash->hash, data);
+        case SET_BTREE:
+            return hashed_key(s->btree->key_type, s->btree->key_type ==
+                    BINARYTREE_KEY_CUSTOM ? s->btree->prefix : NULL, data);
+        default:
+            return hashed_key(s->tree->key_type, s->tree->key_type ==
+                    BINARYTREE_KEY_CUSTOM ? s->tree->prefix : NULL, data);
+    }
+}
+
+/**
+ * Call a function on every item, in order unless s is a hash set
+ */
+static void map_set(set_t *const s, void (*func)(void *, void *), void *func_data)
+{
+    if (s->backend == SET_HASH)
+        map_hashset(s->hash, func, func_data);
+    else if (s->backend == SET_BTREE)
+        map_btree(s->btree, func, func_data);
+    else
+        for (dlp_node_t *n = first_binarytree(s->tree); n != NULL; n = next_binarytree(n))
+            func(n->data, func_data);
+}
+
+struct fill_filter {
+    set_t *s;
+    filter_t *f;
+};
+
+static void fill_filter_item(void *data, void *arg)
+{
+    struct fill_filter *fill = arg;
+
+    add_filter(fill->f, hash_set(fill->s, data));
+}
+
+/**
+ * Replace the filter of a set by one sized for capacity items, the old one
+ * stays if out of memory
+ */
+static int8_t rebuild_filter(set_t *const s, uint64_t capacity, double fpr)
+{
+    struct fill_filter fill = { s, create_filter(capacity, fpr) };
+
+    if (fill.f == NULL) return -1;
+
+    map_set(s, fill_filter_item, &fill);
+
+    if (s->filter != NULL) {
+        fill.f->rejected = s->filter->rejected;
+        fill.f->passed = s->filter->passed;
+        fill.f->false_positives = s->filter->false_positives;
+        free_filter(s->filter);
+    }
+
+    s->filter = fill.f;
+    return 1;
+}
+
+static uint64_t count_set(set_t *const s)
+{
+    switch (s->backend) {
+        case SET_HASH:  return count_hashset(s->hash);
+        case SET_BTREE: return count_btree(s->btree);
+        default:        return count_binarytree(s->tree);
+    }
+}
+
+int8_t attach_filter_set(set_t *const s, double fpr)
+{
+    uint8_t key_type = s->backend == SET_HASH ? s->hash->key_type :
+        s->backend == SET_BTREE ? s->btree->key_type : s->tree->key_type;
+    bool hashed = s->backend == SET_HASH ? s->hash->hash != NULL :
+        s->backend == SET_BTREE ? s->btree->prefix != NULL : s->tree->prefix != NULL;
+
+    // equal custom items need equal hashes
+    if (key_type == BINARYTREE_KEY_CUSTOM && !hashed) return -1;
+
+    uint64_t capacity = 2 * count_set(s);
+
+    return rebuild_filter(s, capacity > SET_FILTER_MIN ? capacity : SET_FILTER_MIN, fpr);
+}
+
+void detach_filter_set(set_t *const s)
+{
+    if (s->filter != NULL)
+        free_filter(s->filter);
+
+    s->filter = NULL;
+}
+
+/**
+ * Set - core
+ */
+static int8_t add_backend(set_t *const s, void *const data)
+{
+    if (s->backend == SET_HASH)
+        return add_hashset(s->hash, data);
+
+    if (s->backend == SET_BTREE)
+        return add_btree(s->btree, data);
+
     return add_binarytree(s->tree, data);
 }
 
-int8_t contains_set(set_t *const s, void *const data)
+int8_t add_set(set_t *const s, void *const data)
+{
+    int8_t result = add_backend(s, data);
+
+    if (result > 0 && s->filter != NULL) {
+        // a full filter makes way for one twice as large, holding data already
+        if (s->filter->count < s->filter->capacity ||
+                rebuild_filter(s, 2 * s->filter->capacity, s->filter->fpr) < 0)
+            add_filter(s->filter, hash_set(s, data));
+    }
+
+    return result;
+}
+
+static int8_t contains_backend(set_t *const s, void *const data)
 {
-    dlp_node_t *n = find_binarytree(s->tree->root, data);
+    if (s->backend == SET_HASH)
+        return contains_hashset(s->hash, data);
+
+    if (s->backend == SET_BTREE)
+        return contains_btree(s->btree, data);
+
+    dlp_node_t *n = search_binarytree(s->tree, data);
 
     if (n == NULL)
         return 0;
@@ -26,13 +224,773 @@ int8_t contains_set(set_t *const s, void *const data)
         return 1;
 }
 
-int8_t del_set(set_t *const s, void *const data)
+int8_t contains_set(set_t *const s, void *const data)
+{
+    if (s->filter == NULL)
+        return contains_backend(s, data);
+
+    if (!contains_filter(s->filter, hash_set(s, data))) {
+        s->filter->rejected++;
+        return 0;
+    }
+
+    int8_t result = contains_backend(s, data);
+
+    s->filter->passed++;
+    s->filter->false_positives += result == 0;
+    return result;
+}
+
+void *lower_bound_set(set_t *const s, void *const data)
+{
+    if (s->backend == SET_HASH)
+        return NULL;
+
+    if (s->backend == SET_BTREE)
+        return lower_bound_btree(s->btree, data);
+
+    return lower_bound_binarytree(s->tree, data);
+}
+
+void *upper_bound_set(set_t *const s, void *const data)
+{
+    if (s->backend == SET_HASH)
+        return NULL;
+
+    if (s->backend == SET_BTREE)
+        return upper_bound_btree(s->btree, data);
+
+    return upper_bound_binarytree(s->tree, data);
+}
+
+void *floor_set(set_t *const s, void *const data)
 {
+    if (s->backend == SET_HASH)
+        return NULL;
+
+    if (s->backend == SET_BTREE)
+        return floor_btree(s->btree, data);
+
+    return floor_binarytree(s->tree, data);
+}
+
+void *ceiling_set(set_t *const s, void *const data)
+{
+    if (s->backend == SET_HASH)
+        return NULL;
+
+    if (s->backend == SET_BTREE)
+        return ceiling_btree(s->btree, data);
+
+    return ceiling_binarytree(s->tree, data);
+}
+
+static int8_t build_backend(set_t *const s, void *const *items, uint64_t count)
+{
+    if (s->backend == SET_HASH) {
+        if (count_hashset(s->hash) > 0) return -1;
+        if (reserve_hashset(s->hash, count) < 0) return -1;
+
+        for (uint64_t i = 0; i < count; i++)
+            add_hashset(s->hash, items[i]);
+
+        return 1;
+    }
+
+    if (s->backend != SET_BTREE)
+        return build_binarytree_from_array(s->tree, items, count);
+
+    if (count_btree(s->btree) > 0) return -1;
+    if (count == 0) return 1;
+
+    // sort in the order of the btree, it bulk loads the unique items
+    binarytree_t order = {
+        .key_type = s->btree->key_type,
+        .compare = s->btree->compare,
+        .prefix = s->btree->prefix
+    };
+    void **sorted = malloc(sizeof(*sorted) * count);
+
+    if (sorted == NULL) return -1;
+
+    memcpy(sorted, items, sizeof(*sorted) * count);
+
+    uint64_t unique = sort_binarytree_array(&order, sorted, count);
+    int8_t result = unique > 0 ? load_btree(s->btree, sorted, unique) : -1;
+
+    free(sorted);
+    return result;
+}
+
+int8_t build_set_from_array(set_t *const s, void *const *items, uint64_t count)
+{
+    int8_t result = build_backend(s, items, count);
+
+    if (result > 0 && s->filter != NULL && count_set(s) > 0) {
+        uint64_t capacity = 2 * count_set(s);
+
+        if (capacity < s->filter->capacity) capacity = s->filter->capacity;
+        if (rebuild_filter(s, capacity, s->filter->fpr) < 0) return -1;
+    }
+
+    return result;
+}
+
+uint64_t scan_set(set_t *const s, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data)
+{
+    if (s->backend == SET_HASH)
+        return 0;
+
+    if (s->backend == SET_BTREE)
+        return scan_btree(s->btree, low, high, func, func_data);
+
+    return scan_binarytree(s->tree, low, high, func, func_data);
+}
+
+static int8_t del_backend(set_t *const s, void *const data)
+{
+    if (s->backend == SET_HASH)
+        return del_hashset(s->hash, data);
+
+    if (s->backend == SET_BTREE)
+        return del_btree(s->btree, data);
+
     return del_binarytree(s->tree, data);
 }
 
+int8_t del_set(set_t *const s, void *const data)
+{
+    // data is hashed, not the stored item, so equal items must hash equally;
+    // only items found in the set may take counters off the filter
+    if (s->filter != NULL && contains_backend(s, data)) {
+        uint64_t hash = hash_set(s, data);
+
+        if (del_backend(s, data) < 0) return -1;
+
+        del_filter(s->filter, hash);
+        return 1;
+    }
+
+    return del_backend(s, data);
+}
+
+void reset_set(set_t *const s)
+{
+    if (s->filter != NULL)
+        reset_filter(s->filter);
+
+    if (s->backend == SET_HASH)
+        reset_hashset(s->hash);
+    else if (s->backend == SET_BTREE)
+        reset_btree(s->btree);
+    else
+        reset_binarytree(s->tree);
+}
+
 void free_set(set_t *s)
 {
-    free_binarytree(s->tree);
+    if (s->backend == SET_HASH)
+        free_hashset(s->hash);
+    else if (s->backend == SET_BTREE)
+        free_btree(s->btree);
+    else
+        free_binarytree(s->tree);
+
+    if (s->filter != NULL)
+        free_filter(s->filter);
+
     free(s);
 }
+
+
+/**
+ * Set - algebra
+ */
+struct set_item {
+    uint64_t key;
+    void *data;
+};
+
+/** Which items of a merge go to the result */
+enum set_emit {
+    EMIT_A = 1,     /**< items only in a */
+    EMIT_B = 2,     /**< items only in b */
+    EMIT_BOTH = 4   /**< items in both, taken from a */
+};
+
+/** Share of a parallel set operation one thread works on */
+struct algebra_job {
+    const binarytree_t *order;
+    const struct set_item *a, *b;   // ranges to merge
+    uint64_t na, nb;
+    void *const *items;             // items to probe
+    uint64_t count;
+    set_t *probe;                   // set they are looked up in
+    bool probe_a;                   // probe is a
+    uint8_t emit;                   // set_emit of merge, EMIT_A keeps probe misses
+    void **out;                     // room for na + nb or count items
+    uint64_t produced;
+};
+
+/**
+ * Order of the items of a set, the hash sets order like binarytrees
+ */
+static binarytree_t order_set(set_t *const s)
+{
+    switch (s->backend) {
+        case SET_HASH:
+            return (binarytree_t) { .key_type = s->hash->key_type,
+                .compare = s->hash->compare };
+        case SET_BTREE:
+            return (binarytree_t) { .key_type = s->btree->key_type,
+                .compare = s->btree->compare, .prefix = s->btree->prefix };
+        default:
+            return (binarytree_t) { .key_type = s->tree->key_type,
+                .compare = s->tree->compare, .prefix = s->tree->prefix };
+    }
+}
+
+static uint8_t key_type_set(set_t *const s)
+{
+    return order_set(s).key_type;
+}
+
+/**
+ * Whether s keeps its items in the given order of the same key_type, custom
+ * items only share the order of an equal comparator and prefix
+ */
+static bool in_order_set(set_t *const s, const binarytree_t *const order)
+{
+    if (s->backend == SET_HASH) return false;
+
+    binarytree_t own = order_set(s);
+
+    return own.key_type != BINARYTREE_KEY_CUSTOM ||
+        (own.compare == order->compare && own.prefix == order->prefix);
+}
+
+/**
+ * Empty set with the backend and order of s
+ */
+static set_t *create_set_like(set_t *const s)
+{
+    set_t *r;
+
+    switch (s->backend) {
+        case SET_HASH:
+            return create_set_hash(s->hash->key_type, s->hash->hash, s->hash->compare);
+        case SET_BTREE:
+            return create_set_btree(s->btree->key_type, s->btree->compare,
+                    s->btree->prefix);
+        default:
+            r = create_set_mode(s->tree->mode);
+            r->tree->key_type = s->tree->key_type;
+            r->tree->compare = s->tree->compare;
+            r->tree->prefix = s->tree->prefix;
+            return r;
+    }
+}
+
+struct collect_items {
+    const binarytree_t *order;
+    struct set_item *items;
+    void **data;
+    uint64_t count;
+};
+
+static void collect_item(void *data, void *arg)
+{
+    struct collect_items *c = arg;
+
+    c->items[c->count].key = cached_key(c->order->key_type, c->order->prefix, data);
+    c->items[c->count++].data = data;
+}
+
+static void collect_data(void *data, void *arg)
+{
+    struct collect_items *c = arg;
+
+    c->data[c->count++] = data;
+}
+
+/**
+ * Items of a set in the given order, NULL if out of memory
+ */
+static struct set_item *collect_set(set_t *const s, const binarytree_t *order,
+        uint64_t *const count)
+{
+    struct collect_items c = {
+        .order = order,
+        .items = malloc(sizeof(*c.items) * (count_set(s) + 1))
+    };
+
+    if (c.items == NULL) return NULL;
+
+    if (in_order_set(s, order))
+        map_set(s, collect_item, &c);
+    else {
+        // hash sets and sets of another order get sorted like a binarytree would
+        binarytree_t sorter = *order;
+
+        c.data = malloc(sizeof(*c.data) * (count_set(s) + 1));
+
+        if (c.data != NULL)
+            map_set(s, collect_data, &c);
+
+        if (c.data == NULL ||
+                (c.count > 0 && sort_binarytree_array(&sorter, c.data, c.count) != c.count)) {
+            free(c.data);
+            free(c.items);
+            return NULL;
+        }
+
+        uint64_t n = c.count;
+        for (c.count = 0; c.count < n; )
+            collect_item(c.data[c.count], &c);
+
+        free(c.data);
+    }
+
+    *count = c.count;
+    return c.items;
+}
+
+static inline __attribute__((always_inline))
+int compare_items(const binarytree_t *const o, const uint8_t key_type,
+        const struct set_item *x, const struct set_item *y)
+{
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING: return strcmp(x->data, y->data);
+        case BINARYTREE_KEY_CUSTOM: return o->compare(x->data, y->data);
+        default:                    return 0;
+    }
+}
+
+/**
+ * Step through both ranges side by side
+ */
+static inline __attribute__((always_inline))
+uint64_t merge_linear(const binarytree_t *const o, const uint8_t key_type,
+        const struct set_item *a, uint64_t na, const struct set_item *b, uint64_t nb,
+        uint8_t emit, void **out)
+{
+    uint64_t i = 0, j = 0, n = 0;
+
+    while (i < na && j < nb) {
+        int c = compare_items(o, key_type, &a[i], &b[j]);
+
+        if (c < 0) {
+            if (emit & EMIT_A) out[n++] = a[i].data;
+            i++;
+        } else if (c > 0) {
+            if (emit & EMIT_B) out[n++] = b[j].data;
+            j++;
+        } else {
+            if (emit & EMIT_BOTH) out[n++] = a[i].data;
+            i++;
+            j++;
+        }
+    }
+
+    for (; (emit & EMIT_A) && i < na; i++) out[n++] = a[i].data;
+    for (; (emit & EMIT_B) && j < nb; j++) out[n++] = b[j].data;
+
+    return n;
+}
+
+/**
+ * Find every item of the small range in the large one with exponential steps
+ * from the last match, O(ns log(nl / ns)) comparisons. Runs of the large
+ * range passed over are copied whole.
+ */
+static inline __attribute__((always_inline))
+uint64_t merge_galloping(const binarytree_t *const o, const uint8_t key_type,
+        const struct set_item *s, uint64_t ns, const struct set_item *l, uint64_t nl,
+        bool small_a, uint8_t emit, void **out)
+{
+    uint8_t emit_small = small_a ? EMIT_A : EMIT_B;
+    uint8_t emit_large = small_a ? EMIT_B : EMIT_A;
+    uint64_t j = 0, n = 0;
+
+    for (uint64_t i = 0; i < ns; i++) {
+        uint64_t lo = j, hi = j, step = 1;
+
+        // first item of the large range not ordered before s[i]
+        while (hi < nl && compare_items(o, key_type, &l[hi], &s[i]) < 0) {
+            lo = hi + 1;
+            hi += step;
+            step *= 2;
+        }
+        if (hi > nl) hi = nl;
+
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+
+            if (compare_items(o, key_type, &l[mid], &s[i]) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+
+        if (emit & emit_large)
+            for (; j < lo; j++) out[n++] = l[j].data;
+        j = lo;
+
+        if (j < nl && compare_items(o, key_type, &l[j], &s[i]) == 0) {
+            if (emit & EMIT_BOTH) out[n++] = small_a ? s[i].data : l[j].data;
+            j++;
+        } else if (emit & emit_small)
+            out[n++] = s[i].data;
+    }
+
+    if (emit & emit_large)
+        for (; j < nl; j++) out[n++] = l[j].data;
+
+    return n;
+}
+
+static inline __attribute__((always_inline))
+uint64_t merge_typed(const binarytree_t *const o, const uint8_t key_type,
+        const struct set_item *a, uint64_t na, const struct set_item *b, uint64_t nb,
+        uint8_t emit, void **out)
+{
+    if (na > nb && na / SET_GALLOP_RATIO > nb)
+        return merge_galloping(o, key_type, b, nb, a, na, false, emit, out);
+    if (nb > na && nb / SET_GALLOP_RATIO > na)
+        return merge_galloping(o, key_type, a, na, b, nb, true, emit, out);
+
+    return merge_linear(o, key_type, a, na, b, nb, emit, out);
+}
+
+static void *run_merge_job(void *arg)
+{
+    struct algebra_job *job = arg;
+    const binarytree_t *o = job->order;
+
+    switch (o->key_type) {
+        case BINARYTREE_KEY_INT64:
+            job->produced = merge_typed(o, BINARYTREE_KEY_INT64, job->a, job->na,
+                    job->b, job->nb, job->emit, job->out);
+            break;
+        case BINARYTREE_KEY_STRING:
+            job->produced = merge_typed(o, BINARYTREE_KEY_STRING, job->a, job->na,
+                    job->b, job->nb, job->emit, job->out);
+            break;
+        case BINARYTREE_KEY_CUSTOM:
+            job->produced = merge_typed(o, BINARYTREE_KEY_CUSTOM, job->a, job->na,
+                    job->b, job->nb, job->emit, job->out);
+            break;
+        default:
+            job->produced = merge_typed(o, BINARYTREE_KEY_ADDRESS, job->a, job->na,
+                    job->b, job->nb, job->emit, job->out);
+    }
+
+    return NULL;
+}
+
+/**
+ * Item of a set equal to data or NULL
+ */
+static void *find_set(set_t *const s, void *const data)
+{
+    dlp_node_t *n;
+
+    switch (s->backend) {
+        case SET_HASH:
+            return find_hashset(s->hash, data);
+        case SET_BTREE:
+            return find_btree(s->btree, data);
+        default:
+            n = search_binarytree(s->tree, data);
+            return n != NULL ? n->data : NULL;
+    }
+}
+
+static void *run_probe_job(void *arg)
+{
+    struct algebra_job *job = arg;
+    bool keep_found = job->emit & EMIT_BOTH;
+
+    job->produced = 0;
+
+    for (uint64_t i = 0; i < job->count; i++) {
+        void *found = find_set(job->probe, job->items[i]);
+
+        if ((found != NULL) != keep_found) continue;
+
+        // items in both sets are taken from a
+        job->out[job->produced++] = found != NULL && job->probe_a ? found : job->items[i];
+    }
+
+    return NULL;
+}
+
+static uint32_t algebra_threads(uint64_t count)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t threads = count / SET_ALGEBRA_PARALLEL;
+
+    if (cpus > 0 && threads > (uint64_t)cpus) threads = cpus;
+    if (threads > SET_ALGEBRA_THREADS) threads = SET_ALGEBRA_THREADS;
+
+    return threads > 0 ? threads : 1;
+}
+
+/**
+ * Run every job, the calling thread takes the first one
+ */
+static void run_algebra_jobs(struct algebra_job *jobs, uint32_t threads,
+        void *(*run)(void *))
+{
+    pthread_t tid[SET_ALGEBRA_THREADS];
+    uint32_t started = 1;
+
+    for (; started < threads; started++)
+        if (pthread_create(&tid[started], NULL, run, &jobs[started]) != 0)
+            break;
+
+    run(&jobs[0]);
+
+    // jobs no thread could be started for run here as well
+    for (uint32_t i = 1; i < threads; i++)
+        if (i < started)
+            pthread_join(tid[i], NULL);
+        else
+            run(&jobs[i]);
+}
+
+/**
+ * Move the outputs of the jobs together, returns the number of items
+ */
+static uint64_t gather_jobs(struct algebra_job *jobs, uint32_t threads, void **out)
+{
+    uint64_t n = 0;
+
+    for (uint32_t i = 0; i < threads; i++) {
+        memmove(out + n, jobs[i].out, sizeof(*out) * jobs[i].produced);
+        n += jobs[i].produced;
+    }
+
+    return n;
+}
+
+/**
+ * First item of a range not ordered before x
+ */
+static uint64_t lower_bound_items(const binarytree_t *const o, const struct set_item *r,
+        uint64_t n, const struct set_item *x)
+{
+    uint64_t lo = 0, hi = n;
+
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+
+        if (compare_items(o, o->key_type, &r[mid], x) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * Merge the items of two sets in order. The larger one is cut into equal
+ * chunks for the threads, the smaller one where those chunks start.
+ */
+static uint64_t merge_sets(const binarytree_t *const o, const struct set_item *a,
+        uint64_t na, const struct set_item *b, uint64_t nb, uint8_t emit, void **out)
+{
+    struct algebra_job jobs[SET_ALGEBRA_THREADS];
+    uint32_t threads = algebra_threads(na + nb);
+    bool split_a = na >= nb;
+    uint64_t nl = split_a ? na : nb;
+    uint64_t cut[SET_ALGEBRA_THREADS + 1][2];
+
+    cut[0][0] = cut[0][1] = 0;
+    cut[threads][0] = na;
+    cut[threads][1] = nb;
+
+    for (uint32_t i = 1; i < threads; i++) {
+        uint64_t pos = nl / threads * i;
+
+        if (split_a) {
+            cut[i][0] = pos;
+            cut[i][1] = lower_bound_items(o, b, nb, &a[pos]);
+        } else {
+            cut[i][0] = lower_bound_items(o, a, na, &b[pos]);
+            cut[i][1] = pos;
+        }
+    }
+
+    // every job writes where its ranges start, no output outgrows its ranges
+    for (uint32_t i = 0; i < threads; i++)
+        jobs[i] = (struct algebra_job) {
+            .order = o,
+            .a = a + cut[i][0],
+            .na = cut[i + 1][0] - cut[i][0],
+            .b = b + cut[i][1],
+            .nb = cut[i + 1][1] - cut[i][1],
+            .emit = emit,
+            .out = out + cut[i][0] + cut[i][1]
+        };
+
+    run_algebra_jobs(jobs, threads, run_merge_job);
+    return gather_jobs(jobs, threads, out);
+}
+
+/**
+ * Look items up in a set on parallel chunks, keeping the ones found
+ * (EMIT_BOTH) or the ones missed in place
+ */
+static uint64_t probe_sets(set_t *const probe, bool probe_a, void **items,
+        uint64_t count, uint8_t emit)
+{
+    struct algebra_job jobs[SET_ALGEBRA_THREADS];
+    uint32_t threads = algebra_threads(count);
+
+    // splaying lookups rotate the tree
+    if (probe->backend == SET_BINARYTREE && probe->tree->mode == BINARYTREE_SPLAY)
+        threads = 1;
+
+    // a job only writes below what it has read
+    for (uint32_t i = 0; i < threads; i++) {
+        uint64_t begin = count / threads * i;
+        uint64_t end = i + 1 < threads ? count / threads * (i + 1) : count;
+
+        jobs[i] = (struct algebra_job) {
+            .items = items + begin,
+            .count = end - begin,
+            .probe = probe,
+            .probe_a = probe_a,
+            .emit = emit,
+            .out = items + begin
+        };
+    }
+
+    run_algebra_jobs(jobs, threads, run_probe_job);
+    return gather_jobs(jobs, threads, items);
+}
+
+/**
+ * Fill an empty set with unique items, btrees load sorted ones directly
+ */
+static set_t *fill_set(set_t *const r, void *const *items, uint64_t count, bool sorted)
+{
+    int8_t result;
+
+    if (r->backend == SET_BTREE && sorted)
+        result = count > 0 ? load_btree(r->btree, items, count) : 1;
+    else
+        result = build_set_from_array(r, items, count);
+
+    if (result < 0) {
+        free_set(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+
+/**
+ * Look the items of one set up in the other. Only the sets a result is
+ * taken from get collected, an intersection takes the smaller one.
+ */
+static set_t *probe_algebra(set_t *const a, set_t *const b, uint8_t emit)
+{
+    uint64_t na = count_set(a), nb = count_set(b);
+    bool take_a = (emit & EMIT_A) || (emit == EMIT_BOTH && na <= nb);
+    bool take_b = (emit & EMIT_B) || (emit == EMIT_BOTH && na > nb);
+    struct collect_items c = {
+        .data = malloc(sizeof(void *) * ((take_a ? na : 0) + (take_b ? nb : 0) + 1))
+    };
+    uint64_t n;
+
+    if (c.data == NULL) return NULL;
+
+    // items of a, then the items of b
+    if (take_a) map_set(a, collect_data, &c);
+    if (take_b) map_set(b, collect_data, &c);
+
+    void **items_a = c.data, **items_b = c.data + (take_a ? na : 0);
+
+    if (emit == EMIT_BOTH) {
+        n = take_a ? probe_sets(b, false, items_a, na, EMIT_BOTH) :
+            probe_sets(a, true, items_b, nb, EMIT_BOTH);
+        memmove(c.data, take_a ? items_a : items_b, sizeof(void *) * n);
+    } else {
+        // a union keeps all of a, the differences what b lacks
+        n = emit & EMIT_BOTH ? na : probe_sets(b, false, items_a, na, 0);
+
+        if (emit & EMIT_B) {
+            uint64_t only_b = probe_sets(a, true, items_b, nb, 0);
+
+            memmove(c.data + n, items_b, sizeof(void *) * only_b);
+            n += only_b;
+        }
+    }
+
+    // items kept from a set in the order of a stay sorted
+    binarytree_t order = order_set(a);
+    bool sorted = !(emit & EMIT_B) && in_order_set(take_a ? a : b, &order);
+    set_t *r = fill_set(create_set_like(a), c.data, n, sorted);
+
+    free(c.data);
+    return r;
+}
+
+/**
+ * Items of a set operation as picked by emit, in a new set like a
+ */
+static set_t *algebra_set(set_t *const a, set_t *const b, uint8_t emit)
+{
+    if (key_type_set(a) != key_type_set(b)) return NULL;
+
+    uint64_t na = count_set(a), nb = count_set(b);
+
+    // hash sets probe each other, so does a small set picked from a large one
+    if ((a->backend == SET_HASH && b->backend == SET_HASH) ||
+            (emit == EMIT_BOTH && (na / SET_GALLOP_RATIO > nb ||
+                nb / SET_GALLOP_RATIO > na)) ||
+            (emit == EMIT_A && nb / SET_GALLOP_RATIO > na))
+        return probe_algebra(a, b, emit);
+
+    // an ordered set gives the order, a hash set of custom items its comparator
+    binarytree_t order = order_set(a->backend != SET_HASH ? a : b);
+    struct set_item *ia = collect_set(a, &order, &na);
+    struct set_item *ib = collect_set(b, &order, &nb);
+    void **out = malloc(sizeof(*out) * (na + nb + 1));
+    set_t *r = NULL;
+
+    if (ia != NULL && ib != NULL && out != NULL) {
+        uint64_t n = merge_sets(&order, ia, na, ib, nb, emit, out);
+
+        r = fill_set(create_set_like(a), out, n, true);
+    }
+
+    free(ia);
+    free(ib);
+    free(out);
+    return r;
+}
+
+set_t *union_set(set_t *const a, set_t *const b)
+{
+    return algebra_set(a, b, EMIT_A | EMIT_B | EMIT_BOTH);
+}
+
+set_t *intersect_set(set_t *const a, set_t *const b)
+{
+    return algebra_set(a, b, EMIT_BOTH);
+}
+
+set_t *difference_set(set_t *const a, set_t *const b)
+{
+    return algebra_set(a, b, EMIT_A);
+}
+
+set_t *symmetric_difference_set(set_t *const a, set_t *const b)
+{
+    return algebra_set(a, b, EMIT_A | EMIT_B);
+}
@@ -0,0 +1,360 @@
+#include "datastructs.h"
+#include <string.h>
+
+
+/**
+ * Snapshot - freezing
+ */
+static set_snapshot_t *create_snapshot(uint64_t count, uint8_t key_type,
+        int (*compare)(const void *, const void *), uint64_t (*prefix)(const void *))
+{
+    set_snapshot_t *s = calloc(1, sizeof(*s));
+
+    if (s == NULL) return NULL;
+
+    // index 0 is unused, so index i * 8 starts a cache line
+    size_t size = (sizeof(*s->keys) * (count + 1) + DATASTRUCTS_CACHE_LINE - 1)
+            & ~(size_t)(DATASTRUCTS_CACHE_LINE - 1);
+
+    s->keys = aligned_alloc(DATASTRUCTS_CACHE_LINE, size);
+    s->data = malloc(sizeof(*s->data) * (count + 1));
+    s->count = count;
+    s->key_type = key_type;
+    s->compare = compare;
+    s->prefix = prefix;
+
+    if (s->keys == NULL || s->data == NULL) {
+        free_snapshot(s);
+        return NULL;
+    }
+
+    s->keys[0] = 0;
+    s->data[0] = NULL;
+    return s;
+}
+
+/**
+ * Place sorted items below index i in order, returns the next sorted item
+ */
+static uint64_t fill_snapshot(set_snapshot_t *const s, const uint64_t *keys,
+        void *const *data, uint64_t next, uint64_t i)
+{
+    if (i > s->count) return next;
+
+    next = fill_snapshot(s, keys, data, next, 2 * i);
+    s->keys[i] = keys[next];
+    s->data[i] = data[next++];
+    return fill_snapshot(s, keys, data, next, 2 * i + 1);
+}
+
+static set_snapshot_t *freeze_sorted(uint64_t count, uint8_t key_type,
+        int (*compare)(const void *, const void *), uint64_t (*prefix)(const void *),
+        const uint64_t *keys, void *const *data)
+{
+    set_snapshot_t *s = create_snapshot(count, key_type, compare, prefix);
+
+    if (s != NULL)
+        fill_snapshot(s, keys, data, 0, 1);
+
+    return s;
+}
+
+set_snapshot_t *freeze_binarytree(binarytree_t *const t)
+{
+    uint64_t count = 0, capacity = 1024;
+    uint64_t *keys = malloc(sizeof(*keys) * capacity);
+    void **data = malloc(sizeof(*data) * capacity);
+    dlp_node_t *n = t->root;
+
+    while (n != NULL && n->prev != NULL)
+        n = n->prev;
+
+    // in order along the parent links, plain trees may be too deep to recurse
+    while (n != NULL && keys != NULL && data != NULL) {
+        if (count == capacity) {
+            capacity *= 2;
+
+            uint64_t *more_keys = realloc(keys, sizeof(*keys) * capacity);
+            if (more_keys != NULL) keys = more_keys;
+            void **more_data = realloc(data, sizeof(*data) * capacity);
+            if (more_data != NULL) data = more_data;
+
+            if (more_keys == NULL || more_data == NULL) break;
+        }
+
+        keys[count] = n->key;
+        data[count++] = n->data;
+
+        if (n->next != NULL) {
+            for (n = n->next; n->prev != NULL; n = n->prev);
+        } else {
+            while (n->parent != NULL && n->parent->next == n)
+                n = n->parent;
+            n = n->parent;
+        }
+    }
+
+    set_snapshot_t *s = NULL;
+
+    if (n == NULL && keys != NULL && data != NULL)
+        s = freeze_sorted(count, t->key_type, t->compare, t->prefix, keys, data);
+
+    free(keys);
+    free(data);
+    return s;
+}
+
+struct freeze_btree {
+    btree_t *t;
+    uint64_t *keys;
+    void **data;
+    uint64_t count;
+};
+
+static void collect_btree_item(void *data, void *arg)
+{
+    struct freeze_btree *f = arg;
+
+    f->keys[f->count] = cached_key(f->t->key_type, f->t->prefix, data);
+    f->data[f->count++] = data;
+}
+
+static void collect_hashset_item(void *data, void *arg)
+{
+    struct freeze_btree *f = arg;
+
+    f->data[f->count++] = data;
+}
+
+/**
+ * Hashsets keep no order, sort their items like a binarytree of their key_type
+ */
+static set_snapshot_t *freeze_hashset(hashset_t *const t)
+{
+    binarytree_t order = {
+        .key_type = t->key_type,
+        .compare = t->compare
+    };
+    uint64_t count = count_hashset(t);
+    struct freeze_btree f = {
+        .keys = malloc(sizeof(*f.keys) * (count + 1)),
+        .data = malloc(sizeof(*f.data) * (count + 1))
+    };
+    set_snapshot_t *snapshot = NULL;
+
+    if (f.keys != NULL && f.data != NULL) {
+        map_hashset(t, collect_hashset_item, &f);
+
+        if (count == 0 || sort_binarytree_array(&order, f.data, count) == count) {
+            for (uint64_t i = 0; i < count; i++)
+                f.keys[i] = cached_key(t->key_type, NULL, f.data[i]);
+
+            snapshot = freeze_sorted(count, t->key_type, t->compare, NULL,
+                    f.keys, f.data);
+        }
+    }
+
+    free(f.keys);
+    free(f.data);
+    return snapshot;
+}
+
+set_snapshot_t *freeze_set(set_t *const s)
+{
+    if (s->backend == SET_HASH)
+        return freeze_hashset(s->hash);
+
+    if (s->backend != SET_BTREE)
+        return freeze_binarytree(s->tree);
+
+    btree_t *t = s->btree;
+    uint64_t count = count_btree(t);
+    struct freeze_btree f = {
+        .t = t,
+        .keys = malloc(sizeof(*f.keys) * (count + 1)),
+        .data = malloc(sizeof(*f.data) * (count + 1))
+    };
+    set_snapshot_t *snapshot = NULL;
+
+    if (f.keys != NULL && f.data != NULL) {
+        map_btree(t, collect_btree_item, &f);
+        snapshot = freeze_sorted(count, t->key_type, t->compare, t->prefix,
+                f.keys, f.data);
+    }
+
+    free(f.keys);
+    free(f.data);
+    return snapshot;
+}
+
+void free_snapshot(set_snapshot_t *s)
+{
+    if (s == NULL) return;
+
+    free(s->keys);
+    free(s->data);
+    free(s);
+}
+
+uint64_t count_snapshot(const set_snapshot_t *const s)
+{
+    return s->count;
+}
+
+
+/**
+ * Snapshot - search
+ */
+
+/**
+ * Whether the item at index i orders before data. Always inlined with a
+ * constant key type, whole value keys compile to a flag instead of a branch.
+ */
+static inline __attribute__((always_inline))
+uint64_t before_snapshot(const set_snapshot_t *const s, const uint8_t key_type,
+        uint64_t i, uint64_t key, const void *const data)
+{
+    uint64_t at = s->keys[i];
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING:
+            return at < key || (at == key && strcmp(s->data[i], data) < 0);
+        case BINARYTREE_KEY_CUSTOM:
+            return at < key || (at == key && s->compare(s->data[i], data) < 0);
+        default:
+            return at < key;
+    }
+}
+
+static inline __attribute__((always_inline))
+bool equal_snapshot(const set_snapshot_t *const s, const uint8_t key_type,
+        uint64_t i, uint64_t key, const void *const data)
+{
+    if (i == 0 || s->keys[i] != key)
+        return false;
+
+    switch (key_type) {
+        case BINARYTREE_KEY_STRING: return strcmp(s->data[i], data) == 0;
+        case BINARYTREE_KEY_CUSTOM: return s->compare(s->data[i], data) == 0;
+        default:                    return true;
+    }
+}
+
+/**
+ * Index past the last step down, turned into the last index where the
+ * search went left: the lowest item not before data, 0 if there is none
+ */
+static inline uint64_t bound_index(uint64_t i)
+{
+    return i >> __builtin_ffsll(~i);
+}
+
+static inline __attribute__((always_inline))
+uint64_t lower_bound_typed(const set_snapshot_t *const s, const uint8_t key_type,
+        uint64_t key, const void *const data)
+{
+    uint64_t i = 1;
+
+    while (i <= s->count) {
+        // the 8 descendants three levels down share one cache line
+        __builtin_prefetch(s->keys + i * 8);
+        i = 2 * i + before_snapshot(s, key_type, i, key, data);
+    }
+
+    return bound_index(i);
+}
+
+/**
+ * Index of the lowest item not before data, 0 if there is none or exact
+ * asks for data itself and it is not there
+ */
+static uint64_t search_snapshot(const set_snapshot_t *const s, const void *const data,
+        bool exact)
+{
+    uint64_t key = cached_key(s->key_type, s->prefix, data);
+    uint64_t i;
+
+    switch (s->key_type) {
+        case BINARYTREE_KEY_INT64:
+            i = lower_bound_typed(s, BINARYTREE_KEY_INT64, key, data);
+            return !exact || equal_snapshot(s, BINARYTREE_KEY_INT64, i, key, data) ? i : 0;
+        case BINARYTREE_KEY_STRING:
+            i = lower_bound_typed(s, BINARYTREE_KEY_STRING, key, data);
+            return !exact || equal_snapshot(s, BINARYTREE_KEY_STRING, i, key, data) ? i : 0;
+        case BINARYTREE_KEY_CUSTOM:
+            i = lower_bound_typed(s, BINARYTREE_KEY_CUSTOM, key, data);
+            return !exact || equal_snapshot(s, BINARYTREE_KEY_CUSTOM, i, key, data) ? i : 0;
+        default:
+            i = lower_bound_typed(s, BINARYTREE_KEY_ADDRESS, key, data);
+            return !exact || equal_snapshot(s, BINARYTREE_KEY_ADDRESS, i, key, data) ? i : 0;
+    }
+}
+
+int8_t contains_snapshot(const set_snapshot_t *const s, const void *const data)
+{
+    return search_snapshot(s, data, true) != 0;
+}
+
+void *lower_bound_snapshot(const set_snapshot_t *const s, const void *const data)
+{
+    return s->data[search_snapshot(s, data, false)];
+}
+
+static inline __attribute__((always_inline))
+uint64_t contains_many_typed(const set_snapshot_t *const s, const uint8_t key_type,
+        void *const *items, uint64_t n, int8_t *results)
+{
+    // every search takes depth - 1 steps, some take one more
+    uint32_t depth = s->count > 0 ? 64 - __builtin_clzll(s->count) : 0;
+    uint64_t index[SNAPSHOT_BATCH], keys[SNAPSHOT_BATCH];
+    uint64_t found = 0;
+
+    for (uint64_t base = 0; base < n; base += SNAPSHOT_BATCH) {
+        uint32_t batch = n - base < SNAPSHOT_BATCH ? n - base : SNAPSHOT_BATCH;
+        void *const *data = items + base;
+
+        for (uint32_t b = 0; b < batch; b++) {
+            keys[b] = cached_key(key_type, s->prefix, data[b]);
+            index[b] = 1;
+        }
+
+        // the line of the next step loads while the rest of the batch steps
+        for (uint32_t level = 1; level < depth; level++) {
+            for (uint32_t b = 0; b < batch; b++) {
+                index[b] = 2 * index[b] + before_snapshot(s, key_type, index[b],
+                        keys[b], data[b]);
+                __builtin_prefetch(s->keys + index[b]);
+            }
+        }
+
+        for (uint32_t b = 0; b < batch; b++) {
+            if (index[b] <= s->count)
+                index[b] = 2 * index[b] + before_snapshot(s, key_type, index[b],
+                        keys[b], data[b]);
+
+            bool equal = equal_snapshot(s, key_type, bound_index(index[b]),
+                    keys[b], data[b]);
+
+            found += equal;
+            if (results != NULL)
+                results[base + b] = equal;
+        }
+    }
+
+    return found;
+}
+
+uint64_t contains_many_snapshot(const set_snapshot_t *const s, void *const *items,
+        uint64_t n, int8_t *results)
+{
+    switch (s->key_type) {
+        case BINARYTREE_KEY_INT64:
+            return contains_many_typed(s, BINARYTREE_KEY_INT64, items, n, results);
+        case BINARYTREE_KEY_STRING:
+            return contains_many_typed(s, BINARYTREE_KEY_STRING, items, n, results);
+        case BINARYTREE_KEY_CUSTOM:
+            return contains_many_typed(s, BINARYTREE_KEY_CUSTOM, items, n, results);
+        default:
+            return contains_many_typed(s, BINARYTREE_KEY_ADDRESS, items, n, results);
+    }
+}
@@ -0,0 +1,131 @@
+#include "datastructs.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * SPSC queue - core
+ */
+spsc_queue_t *create_spsc_queue(uint32_t capacity)
+{
+    // a larger ring would not round up to a power of two in 32 bits
+    if (capacity > 1u << 31) return NULL;
+
+    spsc_queue_t *q = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*q));
+    uint32_t size = 2;
+
+    if (q == NULL) return NULL;
+
+    while (size < capacity)
+        size <<= 1;
+
+    memset(q, 0, sizeof(*q));
+    q->ring = malloc(sizeof(*q->ring) * size);
+    q->mask = size - 1;
+
+    if (q->ring == NULL) {
+        free(q);
+        return NULL;
+    }
+
+    return q;
+}
+
+void free_spsc_queue(spsc_queue_t *q)
+{
+    free(q->ring);
+    free(q);
+}
+
+int8_t add_spsc_queue(spsc_queue_t *const q, void *const data)
+{
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // only look at the consumer's line when the cached head says full
+    if (tail - q->head_cache > q->mask) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->head_cache > q->mask) return 0;
+    }
+
+    q->ring[tail & q->mask] = data;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+
+    return 1;
+}
+
+void *pop_spsc_queue(spsc_queue_t *const q)
+{
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // only look at the producer's line when the cached tail says empty
+    if (head == q->tail_cache) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->tail_cache) return NULL;
+    }
+
+    void *data = q->ring[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    return data;
+}
+
+/**
+ * SPSC queue - batched
+ */
+uint32_t add_many_spsc_queue(spsc_queue_t *const q, void *const *items, uint32_t n)
+{
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t room = q->mask + 1 - (tail - q->head_cache);
+
+    if (room < n) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = q->mask + 1 - (tail - q->head_cache);
+    }
+
+    if (n > room) n = room;
+    if (n == 0) return 0;
+
+    uint32_t first = tail & q->mask;
+    uint32_t split = n < q->mask + 1 - first ? n : q->mask + 1 - first;
+
+    memcpy(q->ring + first, items, sizeof(*items) * split);
+    memcpy(q->ring, items + split, sizeof(*items) * (n - split));
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+
+    return n;
+}
+
+uint32_t pop_many_spsc_queue(spsc_queue_t *const q, void **items, uint32_t n)
+{
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t ready = q->tail_cache - head;
+
+    if (ready < n) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        ready = q->tail_cache - head;
+    }
+
+    if (n > ready) n = ready;
+    if (n == 0) return 0;
+
+    uint32_t first = head & q->mask;
+    uint32_t split = n < q->mask + 1 - first ? n : q->mask + 1 - first;
+
+    memcpy(items, q->ring + first, sizeof(*items) * split);
+    memcpy(items + split, q->ring, sizeof(*items) * (n - split));
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+
+    return n;
+}
+
+/**
+ * SPSC queue - derived
+ */
+uint32_t count_spsc_queue(spsc_queue_t *const q)
+{
+    // head first, tail can only move further away from it meanwhile
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t count = atomic_load_explicit(&q->tail, memory_order_acquire) - head;
+
+    return count > q->mask + 1 ? q->mask + 1 : count;
+}
@@ -6,32 +6,126 @@
  */
 stack_t *create_stack()
 {
-    return malloc(sizeof(stack_t));
+    return calloc(1, sizeof(stack_t));
 }
 
-void add_stack(stack_t *const s, void *const data)
+stack_t *create_stack_pooled()
 {
-    sl_node_t *n = create_slnode(data);
+    stack_t *s = create_stack();
+    s->pool = shared_node_pool(NODE_POOL_SL);
+    return s;
+}
+
+stack_t *create_stack_arena()
+{
+    stack_t *s = create_stack();
+    s->pool = create_node_pool(sizeof(sl_node_t), NODE_ARENA_SLAB);
+    return s;
+}
+
+stack_t *create_stack_vector(uint32_t capacity)
+{
+    stack_t *s = create_stack();
+    s->mode = STACK_VECTOR;
+    reserve_stack(s, capacity);
+    return s;
+}
+
+int8_t reserve_stack(stack_t *const s, uint32_t capacity)
+{
+    if (s->mode != STACK_VECTOR || capacity <= s->capacity) return 1;
+
+    void **items = realloc(s->items, sizeof(*items) * capacity);
+
+    if (items == NULL) return -1;
+
+    s->items = items;
+    s->capacity = capacity;
+    return 1;
+}
+
+void shrink_to_fit_stack(stack_t *const s)
+{
+    if (s->mode != STACK_VECTOR || s->count == s->capacity) return;
+
+    if (s->count == 0) {
+        free(s->items);
+        s->items = NULL;
+        s->capacity = 0;
+        return;
+    }
+
+    void **items = realloc(s->items, sizeof(*items) * s->count);
+
+    if (items == NULL) return;
+
+    s->items = items;
+    s->capacity = s->count;
+}
+
+int8_t add_stack(stack_t *const s, void *const data)
+{
+    if (s->mode == STACK_VECTOR) {
+        if (s->count == s->capacity) {
+            // doubling stops at the largest count a uint32_t holds
+            if (s->capacity == UINT32_MAX) return -1;
+
+            uint32_t capacity = s->capacity == 0 ? 16 :
+                s->capacity > UINT32_MAX / 2 ? UINT32_MAX : s->capacity * 2;
+
+            if (reserve_stack(s, capacity) < 0) return -1;
+        }
+
+        s->items[s->count++] = data;
+        return 1;
+    }
+
+    sl_node_t *n = alloc_slnode(s->pool, data);
     n->next = s->first;
     s->first = n;
+    s->count++;
+    return 1;
 }
 
 void *pop_stack(stack_t *const s)
 {
+    if (s->mode == STACK_VECTOR)
+        return s->count > 0 ? s->items[--s->count] : NULL;
+
     if (s->first == NULL) return NULL;
     
     void *data = s->first->data;
     sl_node_t *n = s->first;
     s->first = s->first->next;
+    s->count--;
 
-    free(n); // Regular free() intended
+    release_slnode(s->pool, n); // Data pointer is returned, not freed
 
     return data;
 }
 
+void reset_stack(stack_t *const s)
+{
+    if (s->mode == STACK_LINKED) {
+        if (s->pool != NULL && s->pool->shared < 0)
+            reset_node_pool(s->pool);
+        else
+            release_slnode_seq(s->pool, s->first);
+    }
+
+    s->first = NULL;
+    s->count = 0;
+}
+
 void free_stack(stack_t *s)
 {
-    free_slnode_seq(s->first);
+    if (s->mode == STACK_VECTOR)
+        free(s->items);
+    else if (s->pool != NULL && s->pool->shared < 0)
+        free_node_pool(s->pool); // Arena, nodes go with their slabs
+    else
+        release_slnode_seq(s->pool, s->first);
+
     free(s);
 }
 
@@ -41,14 +135,21 @@ void free_stack(stack_t *s)
 
 uint32_t count_stack(stack_t *const s) 
 {
-    if (s->first == NULL)
-        return 0;
-
-    return count_slnode_seq(s->first);
+    return s->count;
 }
 
 void map_stack(stack_t *const s, void (*func)(sl_node_t *, void *), void *func_data)
 {
+    if (s->mode == STACK_VECTOR) {
+        sl_node_t n = { .next = NULL };
+
+        for (uint32_t i = s->count; i > 0; i--) {
+            n.data = s->items[i - 1];
+            func(&n, func_data);
+        }
+        return;
+    }
+
     map_slnode_seq(s->first, func, func_data);    
 }
 
@@ -12,16 +12,32 @@ void print_data(void *ndata, void *fdata)
 
 void print_stack(stack_t *s)
 {
-    map_slnode_data_seq(s->first, print_data, NULL);
+    if (s->mode == STACK_VECTOR)
+        for (uint32_t i = s->count; i > 0; i--)
+            print_data(s->items[i - 1], NULL);
+    else
+        map_slnode_data_seq(s->first, print_data, NULL);
 }
 
 void print_queue(queue_t *q)
 {
-    map_slnode_data_seq(q->first, print_data, NULL);
+    if (q->mode == QUEUE_RING)
+        for (uint32_t i = q->head; i != q->tail; i++)
+            print_data(q->ring[i & q->mask], NULL);
+    else
+        map_slnode_data_seq(q->first, print_data, NULL);
 }
 
 void print_deque(deque_t *dq, bool reverse)
 {
+    if (dq->mode == DEQUE_BLOCK) {
+        for (uint32_t i = 0; i < dq->count; i++) {
+            uint32_t index = reverse ? dq->tail - 1 - i : dq->head + i;
+            print_data(dq->map[index / DEQUE_BLOCK_SIZE][index % DEQUE_BLOCK_SIZE], NULL);
+        }
+        return;
+    }
+
     dl_node_t *n = dq->first;
 
     if (reverse) 
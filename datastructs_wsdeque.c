@@ -0,0 +1,150 @@
+#include "datastructs.h"
+#include <stdlib.h>
+
+
+/**
+ * Work-stealing deque - arrays
+ */
+static struct ws_array *create_ws_array(uint64_t size, struct ws_array *prev)
+{
+    struct ws_array *a = malloc(sizeof(*a) + sizeof(a->items[0]) * size);
+
+    if (a == NULL) return NULL;
+
+    a->mask = size - 1;
+    a->prev = prev;
+
+    return a;
+}
+
+static struct ws_array *grow_ws_deque(ws_deque_t *const dq, struct ws_array *a,
+        int64_t top, int64_t bottom)
+{
+    struct ws_array *grown = create_ws_array((a->mask + 1) * 2, a);
+
+    if (grown == NULL) return NULL;
+
+    for (int64_t i = top; i < bottom; i++)
+        atomic_store_explicit(&grown->items[i & grown->mask],
+                atomic_load_explicit(&a->items[i & a->mask], memory_order_relaxed),
+                memory_order_relaxed);
+
+    // thieves that loaded the old array keep reading valid items from it
+    atomic_store_explicit(&dq->array, grown, memory_order_release);
+    return grown;
+}
+
+
+/**
+ * Work-stealing deque - core
+ */
+ws_deque_t *create_ws_deque(uint32_t capacity)
+{
+    ws_deque_t *dq = aligned_alloc(DATASTRUCTS_CACHE_LINE, sizeof(*dq));
+    uint64_t size = 16;
+
+    if (dq == NULL) return NULL;
+
+    while (size < capacity)
+        size <<= 1;
+
+    struct ws_array *a = create_ws_array(size, NULL);
+
+    if (a == NULL) {
+        free(dq);
+        return NULL;
+    }
+
+    atomic_init(&dq->top, 0);
+    atomic_init(&dq->bottom, 0);
+    atomic_init(&dq->array, a);
+
+    return dq;
+}
+
+void free_ws_deque(ws_deque_t *dq)
+{
+    struct ws_array *a = atomic_load(&dq->array);
+    struct ws_array *tmp;
+
+    while (a != NULL) {
+        tmp = a->prev;
+        free(a);
+        a = tmp;
+    }
+
+    free(dq);
+}
+
+int8_t add_last_ws_deque(ws_deque_t *const dq, void *const data)
+{
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+    struct ws_array *a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+    if (bottom - top > (int64_t)a->mask &&
+            (a = grow_ws_deque(dq, a, top, bottom)) == NULL)
+        return -1;
+
+    atomic_store_explicit(&a->items[bottom & a->mask], data, memory_order_relaxed);
+
+    // the item has to be visible before a thief can see the new bottom
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&dq->bottom, bottom + 1, memory_order_relaxed);
+
+    return 1;
+}
+
+void *pop_last_ws_deque(ws_deque_t *const dq)
+{
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    struct ws_array *a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+    // claim the last item before looking at top, thieves do the opposite
+    atomic_store_explicit(&dq->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_relaxed);
+    void *data = NULL;
+
+    if (top <= bottom) {
+        data = atomic_load_explicit(&a->items[bottom & a->mask], memory_order_relaxed);
+
+        if (top != bottom)
+            return data;
+
+        // last item, race thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&dq->top, &top, top + 1,
+                    memory_order_seq_cst, memory_order_relaxed))
+            data = NULL;
+    }
+
+    atomic_store_explicit(&dq->bottom, bottom + 1, memory_order_relaxed);
+    return data;
+}
+
+void *steal_first_ws_deque(ws_deque_t *const dq)
+{
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    if (top >= bottom) return NULL;
+
+    struct ws_array *a = atomic_load_explicit(&dq->array, memory_order_acquire);
+    void *data = atomic_load_explicit(&a->items[top & a->mask], memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&dq->top, &top, top + 1,
+                memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+
+    return data;
+}
+
+uint32_t count_ws_deque(ws_deque_t *const dq)
+{
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    return bottom > top ? bottom - top : 0;
+}
@@ -7,7 +7,14 @@
  * - dl_node_t *for deque*
  * - dlp_node_t *for binarytree*
  * - tree_node_t *for tree*
+ * - lf_node_t *for lock-free queue and stack*
  * 
+ * Nodes are allocated with malloc by default. Containers created with a
+ * *_pooled* constructor take their nodes from a shared node_pool_t instead,
+ * which carves nodes out of fixed-size slabs and caches them per thread.
+ * Containers created with a *_arena* constructor own a private node_pool_t,
+ * freeing or resetting such a container drops whole slabs at once.
+ *
  * The primary intentended use case of this library would be without 
  * interacting with node objects.
  *
@@ -19,12 +26,28 @@
  * Datastructures in pipeline:
  *  - stack (stable implemented)
  *  - queue (stable implemented)
- *  - deque (stable/slow not the nicest implementation, no priority)
+ *  - deque (stable implemented)
  *  - binarytree (not functional with void pointers)
- *  - set (depends on binarytree stable when binarytree is stable)
- *  - bag (NOT IMPLEMENTED YET)
+ *  - btree (B+tree, stable implemented)
+ *  - hashset (open addressing, unordered)
+ *  - set (binarytree, btree or hashset backend)
+ *  - bitmap (compressed, uint32_t values)
+ *  - filter (counting blocked Bloom filter)
+ *  - bag (counting multiset, open addressing)
  *  - tree (NOT IMPLEMENTED YET)
  *
+ * Concurrent datastructures:
+ *  - spsc queue (lock-free, bounded, one producer and one consumer thread)
+ *  - mpmc queue (lock-free, bounded, any number of threads)
+ *  - lf queue (lock-free, unbounded, any number of threads)
+ *  - lf stack (lock-free, unbounded, any number of threads)
+ *  - ws deque (work-stealing, unbounded, one owner and any number of thieves)
+ *
+ * The lf queue hands unlinked nodes to an epoch_domain_t, which frees them
+ * once no thread can still be reading them. The lf stack returns popped
+ * nodes to the type-stable lf_node pool right away and guards its head with
+ * a version tag instead.
+ *
  *  Roadmap:
  *  - **general manner of determining likeness of data based on pointer size**
  *  - **considering: add overall support for variadic arguments**
@@ -39,6 +62,50 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/** Assumed cache line size, used to keep concurrently written fields apart */
+#define DATASTRUCTS_CACHE_LINE 64
+
+/** Default number of nodes carved from one slab of a node_pool */
+#define NODE_POOL_SLAB 1024
+
+/** Number of nodes carved from one slab of a container arena */
+#define NODE_ARENA_SLAB 16384
+
+/** Number of nodes each thread caches per shared node_pool */
+#define NODE_POOL_MAGAZINE 64
+
+/** Items per thread before a bulk binarytree sort runs in parallel */
+#define BINARYTREE_SORT_PARALLEL (1 << 18)
+
+/** Maximum number of threads of a bulk binarytree sort */
+#define BINARYTREE_SORT_THREADS 16
+
+/** Lookups contains_many_snapshot interleaves */
+#define SNAPSHOT_BATCH 16
+
+/** Node types with a process wide shared node_pool */
+enum node_pool_type {
+    NODE_POOL_SL,       /**< pool of sl_node */
+    NODE_POOL_DL,       /**< pool of dl_node */
+    NODE_POOL_DLP,      /**< pool of dlp_node */
+    NODE_POOL_LF,       /**< pool of lf_node */
+    NODE_POOL_SHARED    /**< number of shared pools */
+};
+
+/** Fixed-size node allocator carving nodes out of slabs */
+struct node_pool {
+    size_t node_size;       /**< size of a single node in bytes */
+    uint32_t slab_nodes;    /**< number of nodes per slab */
+    uint32_t carved;        /**< nodes handed out from current slab */
+    void *free;             /**< list of released nodes */
+    void *slabs;            /**< first slab owned by the pool */
+    void *slab;             /**< slab nodes are currently carved from */
+    int8_t shared;          /**< node_pool_type of shared pool, -1 if private */
+    pthread_mutex_t lock;   /**< guards slabs and free list of shared pools */
+};
 
 /** Single linked node */
 struct sl_node {
@@ -53,12 +120,27 @@ struct dl_node {
     struct dl_node *next;   /**< pointer to sequential neighbor */
 };
 
+/** Color of a dlp_node in a red-black binarytree */
+enum node_color {
+    NODE_RED,   /**< new nodes start red */
+    NODE_BLACK  /**< missing children count as black */
+};
+
 /** Double linked node with parent */
 struct dlp_node {
     void *data;                 /**< pointer to object stored by node */ 
     struct dlp_node *parent;    /**< pointer to hierarchical parent */
     struct dlp_node *prev;      /**< pointer to hierarchical child */
     struct dlp_node *next;      /**< pointer to hierarchical child */
+    uint64_t key;               /**< cached order key of data */
+    uint8_t color;              /**< node_color of node (BINARYTREE_REDBLACK) */
+    uint32_t size;              /**< number of nodes in subtree of node */
+};
+
+/** Single linked node with atomic link, for lock-free datastructures */
+struct lf_node {
+    void *data;                     /**< pointer to object stored by node */
+    _Atomic(struct lf_node *) next; /**< pointer to sequential neighbor */
 };
 
 /** Node with parent and a queue of children (todo: make hashmap ;S) */
@@ -69,15 +151,47 @@ struct tree_node {
     struct queue *children;     /**< pointer to queue of hierarchical children */
 };
 
+/** Storage layout of a queue */
+enum queue_mode {
+    QUEUE_LINKED,   /**< one sl_node per item */
+    QUEUE_RING      /**< power of two ring buffer of data pointers */
+};
+
 /** Sequential single linked (repeater) */
 struct queue {
     struct sl_node *first;  /**< pointer to first node in queue */
     struct sl_node *last;   /**< pointer to last node in queue */
+    struct node_pool *pool; /**< node allocator, NULL for malloc, owned if private */
+    void **ring;            /**< item ring buffer (QUEUE_RING) */
+    uint32_t mask;          /**< ring capacity - 1 (QUEUE_RING) */
+    uint32_t head;          /**< free running index of first item (QUEUE_RING) */
+    uint32_t tail;          /**< free running index past last item (QUEUE_RING) */
+    uint8_t mode;           /**< queue_mode of queue */
+};
+
+/** Storage layout of a stack */
+enum stack_mode {
+    STACK_LINKED,   /**< one sl_node per item */
+    STACK_VECTOR    /**< geometrically grown array of data pointers */
 };
 
 /** Sequential single linked (reverser) */
 struct stack {
-    struct sl_node *first; /**< pointer to first item in stack */
+    struct sl_node *first;  /**< pointer to first item in stack */
+    struct node_pool *pool; /**< node allocator, NULL for malloc, owned if private */
+    void **items;           /**< item array with top last (STACK_VECTOR) */
+    uint32_t capacity;      /**< number of items array holds (STACK_VECTOR) */
+    uint32_t count;         /**< number of items in stack */
+    uint8_t mode;           /**< stack_mode of stack */
+};
+
+/** Number of data pointers in one block of a block deque */
+#define DEQUE_BLOCK_SIZE 64
+
+/** Storage layout of a deque */
+enum deque_mode {
+    DEQUE_LINKED,   /**< one dl_node per item */
+    DEQUE_BLOCK     /**< fixed-size blocks of data pointers behind a central map */
 };
 
 /** Sequential double linked (repeater & reverser) */
@@ -85,21 +199,172 @@ struct deque {
     struct dl_node *first;  /**< pointer to first node in deque */
     struct dl_node *last;   /**< pointer to last node in deque */
     uint32_t count;         /**< number of items in deque */
+    struct node_pool *pool; /**< node allocator, NULL for malloc, owned if private */
+    void ***map;            /**< block pointers, NULL where unallocated (DEQUE_BLOCK) */
+    uint32_t map_size;      /**< number of block pointers in map (DEQUE_BLOCK) */
+    uint32_t head;          /**< index of first item over all blocks (DEQUE_BLOCK) */
+    uint32_t tail;          /**< index past last item over all blocks (DEQUE_BLOCK) */
+    uint8_t mode;           /**< deque_mode of deque */
+};
+
+/** Balancing of a binarytree */
+enum binarytree_mode {
+    BINARYTREE_PLAIN,       /**< unbalanced, shape follows insert order */
+    BINARYTREE_REDBLACK,    /**< red-black, depth at most 2 log n */
+    BINARYTREE_SPLAY        /**< splay, lookups move their node to the root */
+};
+
+/** What a binarytree orders its data by */
+enum binarytree_key {
+    BINARYTREE_KEY_ADDRESS, /**< data pointers themselves */
+    BINARYTREE_KEY_INT64,   /**< int64_t pointed to by data */
+    BINARYTREE_KEY_STRING,  /**< NUL terminated string pointed to by data */
+    BINARYTREE_KEY_CUSTOM   /**< user comparator, optionally with a key prefix */
 };
 
 /** Binary tree (sorter) */
 struct binarytree {
     struct dlp_node *root;  /**< pointer to root node of binarytree */
+    struct node_pool *pool; /**< node allocator, NULL for malloc, owned if private */
+    int (*compare)(const void *, const void *); /**< order of data (BINARYTREE_KEY_CUSTOM) */
+    uint64_t (*prefix)(const void *);           /**< order preserving key of data, NULL allowed */
+    uint8_t key_type;       /**< binarytree_key of binarytree */
+    uint8_t mode;           /**< binarytree_mode of binarytree */
+};
+
+/** Number of items in one node of a btree */
+#define BTREE_ORDER 32
+
+/** Upper bound on the height of a btree, nodes split at BTREE_ORDER items */
+#define BTREE_MAX_HEIGHT 32
+
+/** Node of a btree, opaque */
+struct btree_node;
+struct btree_leaf;
+
+/** B+tree, items sorted in linked leaves below inner separator nodes (sorter) */
+struct btree {
+    struct btree_node *root;    /**< pointer to root node of btree */
+    struct btree_leaf *first;   /**< leaf with the lowest items */
+    uint64_t count;             /**< number of items */
+    uint64_t leaves;            /**< number of leaf nodes */
+    uint64_t inners;            /**< number of inner nodes */
+    uint32_t height;            /**< levels of nodes, 0 if empty */
+    int (*compare)(const void *, const void *); /**< order of data (BINARYTREE_KEY_CUSTOM) */
+    uint64_t (*prefix)(const void *);           /**< order preserving key of data, NULL allowed */
+    uint8_t key_type;           /**< binarytree_key of btree */
+};
+
+/** Upper bound on the height of a pbinarytree, AVL trees stay below 1.45 log2 n */
+#define PBINARYTREE_MAX_HEIGHT 96
+
+/** Immutable node of a pbinarytree, opaque */
+struct pb_node;
+
+/** Persistent AVL binarytree, every write copies its path (sorter) */
+struct pbinarytree {
+    _Atomic(struct pb_node *) root; /**< root of the current version */
+    _Atomic uint64_t count;         /**< number of items in the current version */
+    uint64_t writes;                /**< number of versions written so far */
+    pthread_mutex_t lock;           /**< serializes writers */
+    struct epoch_domain *domain;    /**< reclaims nodes of old versions */
+    int (*compare)(const void *, const void *); /**< order of data (BINARYTREE_KEY_CUSTOM) */
+    uint64_t (*prefix)(const void *);           /**< order preserving key of data, NULL allowed */
+    uint8_t key_type;               /**< binarytree_key of pbinarytree */
+};
+
+/** Items per thread before set algebra runs in parallel */
+#define SET_ALGEBRA_PARALLEL (1 << 18)
+
+/** Maximum number of threads of set algebra */
+#define SET_ALGEBRA_THREADS 16
+
+/** Size ratio of two sets beyond which merging them gallops through the larger */
+#define SET_GALLOP_RATIO 16
+
+/** Number of slots of a hashset whose control bytes are matched at once */
+#define HASHSET_GROUP 16
+
+/** Hash set, open addressing over groups of slots with a control byte each */
+struct hashset {
+    uint8_t *ctrl;          /**< control byte per slot, empty or 7 bits of the hash */
+    void **slots;           /**< item data per slot */
+    uint64_t groups;        /**< number of groups, a power of two or 0 */
+    uint64_t count;         /**< number of items */
+    uint64_t (*hash)(const void *);             /**< hash of data, NULL for the key_type default */
+    int (*compare)(const void *, const void *); /**< 0 for equal data (BINARYTREE_KEY_CUSTOM) */
+    uint8_t key_type;       /**< binarytree_key of hashset, decides equality */
+};
+
+/** False positive rate of a filter created without a valid one */
+#define FILTER_DEFAULT_FPR 0.01
+
+/** Counting blocked Bloom filter over 64-bit hashes */
+struct filter {
+    uint8_t *blocks;            /**< cache line blocks of 4-bit counters */
+    uint64_t block_count;       /**< number of blocks */
+    uint64_t count;             /**< hashes added and not deleted */
+    uint64_t capacity;          /**< hashes the filter is sized for */
+    double fpr;                 /**< false positive rate at capacity */
+    uint8_t probes;             /**< counters per hash, all in one block */
+    uint64_t rejected;          /**< set lookups the filter answered alone */
+    uint64_t passed;            /**< set lookups the filter let through */
+    uint64_t false_positives;   /**< lookups let through for absent items */
+};
+
+/** Values of a bitmap sharing their high 16 bits, opaque */
+struct bitmap_container;
+
+/** Compressed bitmap of uint32_t values, containers sorted by high 16 bits */
+struct bitmap {
+    uint16_t *keys;                         /**< high 16 bits of every container */
+    struct bitmap_container *containers;    /**< low 16 bits of the values */
+    uint32_t size;                          /**< number of containers */
+    uint32_t capacity;                      /**< containers keys has room for */
+};
+
+/** Storage of a set */
+enum set_backend {
+    SET_BINARYTREE, /**< binarytree of dlp_nodes */
+    SET_BTREE,      /**< btree with cache line sized nodes */
+    SET_HASH        /**< hashset, unordered */
 };
 
 /** Sequential sorter */
 struct set {
-    struct binarytree *tree;    /**< pointer to binarytree */
+    struct binarytree *tree;    /**< pointer to binarytree (SET_BINARYTREE) */
+    struct btree *btree;        /**< pointer to btree (SET_BTREE) */
+    struct hashset *hash;       /**< pointer to hashset (SET_HASH) */
+    struct filter *filter;      /**< checked before the backend, NULL for none */
+    uint8_t backend;            /**< set_backend of set */
+};
+
+/** Immutable copy of a set in Eytzinger order, searched without locks */
+struct set_snapshot {
+    uint64_t *keys;         /**< cached keys in breadth first order from index 1 */
+    void **data;            /**< item data in the order of keys */
+    uint64_t count;         /**< number of items */
+    int (*compare)(const void *, const void *); /**< order of data (BINARYTREE_KEY_CUSTOM) */
+    uint64_t (*prefix)(const void *);           /**< cached key of data, NULL for none */
+    uint8_t key_type;       /**< binarytree_key of snapshot */
 };
 
-/** Sequential sorter and counter */
+/** Item of a bag with its number of occurrences */
+struct bag_entry {
+    void *data;                 /**< pointer to item data */
+    uint64_t hash;              /**< hashed_key of data */
+    uint64_t count;             /**< occurrences, 0 for an empty slot */
+};
+
+/** Counting multiset, open addressed slots with the counts inline */
 struct bag {
-    struct binarytree *tree;    /**< pointer to binarytree */
+    struct bag_entry *entries;  /**< slots probed linearly from the hash */
+    uint64_t capacity;          /**< number of slots, a power of two */
+    uint64_t distinct;          /**< number of different items */
+    uint64_t total;             /**< sum of all counts */
+    uint64_t (*hash)(const void *);             /**< hash of data, NULL for the default */
+    int (*compare)(const void *, const void *); /**< equality of data (BINARYTREE_KEY_CUSTOM) */
+    uint8_t key_type;           /**< binarytree_key of bag */
 };
 
 /** Arbitrary tree for hierarchical relational storage */
@@ -107,11 +372,102 @@ struct tree {
     struct tree_node *root;     /**< pointer to root node of binarytree */
 };
 
+/** Per-thread state of an epoch_domain, opaque */
+struct epoch_record;
+
+/** Epoch based reclamation of memory shared between threads */
+struct epoch_domain {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint64_t epoch;                     /**< global epoch */
+    _Atomic(struct epoch_record *) records;     /**< every registered thread */
+    uint64_t id;                                /**< unique id of domain */
+    struct epoch_domain *next;                  /**< next live domain */
+};
+
+/** Bounded lock-free single producer single consumer queue (repeater) */
+struct spsc_queue {
+    void **ring;            /**< item ring buffer */
+    uint32_t mask;          /**< ring capacity - 1 */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint32_t head;  /**< free running index of first item, consumer owned */
+    uint32_t tail_cache;    /**< last tail seen by consumer */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint32_t tail;  /**< free running index past last item, producer owned */
+    uint32_t head_cache;    /**< last head seen by producer */
+};
+
+/** Slot of a mpmc_queue, its sequence tells whose turn it is */
+struct mpmc_slot {
+    _Atomic uint64_t sequence;  /**< position the slot is ready for */
+    void *data;                 /**< pointer to object stored by slot */
+};
+
+/** Bounded lock-free multi producer multi consumer queue (repeater) */
+struct mpmc_queue {
+    struct mpmc_slot *slots;    /**< slot ring buffer */
+    uint64_t mask;              /**< ring capacity - 1 */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint64_t head;      /**< free running position of next pop */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint64_t tail;      /**< free running position of next add */
+};
+
+/** Number of exchange slots a lf_stack uses to eliminate push/pop pairs */
+#define LF_STACK_ELIMINATION 8
+
+/** Exchange slot of a lf_stack, on its own cache line */
+struct lf_exchanger {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic(void *) offer;  /**< data offered by a push, NULL if free */
+};
+
+/** Unbounded lock-free stack with elimination (reverser) */
+struct lf_stack {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic uint64_t first; /**< 48 bit first lf_node address, 16 bit version */
+    struct lf_exchanger elimination[LF_STACK_ELIMINATION]; /**< exchange slots */
+};
+
+/** Circular item array of a ws_deque, replaced arrays are kept until free */
+struct ws_array {
+    uint64_t mask;              /**< capacity - 1 */
+    struct ws_array *prev;      /**< array this one replaced */
+    _Atomic(void *) items[];    /**< item slots */
+};
+
+/** Growable work-stealing deque, one owner and any number of thieves */
+struct ws_deque {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic int64_t top;                /**< index of first item, thieves steal here */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic int64_t bottom;             /**< index past last item, owner owned */
+    _Atomic(struct ws_array *) array;   /**< current item array */
+};
+
+/** Unbounded lock-free multi producer multi consumer queue (repeater) */
+struct lf_queue {
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic(struct lf_node *) first;    /**< dummy node preceding first item */
+
+    _Alignas(DATASTRUCTS_CACHE_LINE)
+    _Atomic(struct lf_node *) last;     /**< last node, may lag behind by one */
+    struct epoch_domain *epoch;         /**< domain popped nodes are retired to */
+};
+
+/* Allocators */
+typedef struct node_pool node_pool_t;
+
 /* Nodetypes */
 typedef struct sl_node  sl_node_t;
 typedef struct dl_node  dl_node_t;
 typedef struct dlp_node dlp_node_t;
 typedef struct tree_node tree_node_t;
+typedef struct lf_node  lf_node_t;
 
 /* Datastructures */
 typedef struct stack    stack_t;
@@ -119,8 +475,24 @@ typedef struct queue    queue_t;
 typedef struct deque    deque_t;
 typedef struct tree     tree_t;
 typedef struct set      set_t;
+typedef struct set_snapshot set_snapshot_t;
 typedef struct bag      bag_t;
+typedef struct bag_entry bag_entry_t;
 typedef struct binarytree binarytree_t;
+typedef struct btree    btree_t;
+typedef struct hashset  hashset_t;
+typedef struct bitmap   bitmap_t;
+typedef struct filter   filter_t;
+typedef struct pbinarytree pbinarytree_t;
+typedef struct pb_node  pb_node_t;
+
+/* Concurrent datastructures */
+typedef struct epoch_domain epoch_domain_t;
+typedef struct spsc_queue spsc_queue_t;
+typedef struct mpmc_queue mpmc_queue_t;
+typedef struct lf_queue lf_queue_t;
+typedef struct lf_stack lf_stack_t;
+typedef struct ws_deque ws_deque_t;
 
 /**
  * @defgroup Node Node functions
@@ -179,6 +551,51 @@ tree_node_t *create_treenode(void *const data);
  */
 void free_treenode(tree_node_t *n);
 
+/**
+ * Allocate a sl_node instance from a node pool.
+ * @param[out] p pointer to node pool, NULL to use malloc
+ * @param[in] data pointer to object
+ * @return pointer to newly allocated sl_node
+ */
+sl_node_t *alloc_slnode(node_pool_t *const p, void *const data);
+
+/**
+ * Hand a sl_node back to the pool it was allocated from, data is kept.
+ * @param[out] p pointer to node pool, NULL to use free
+ * @param[in] n pointer to sl_node instance
+ */
+void release_slnode(node_pool_t *const p, sl_node_t *n);
+
+/**
+ * Allocate a dl_node instance from a node pool.
+ * @param[out] p pointer to node pool, NULL to use malloc
+ * @param[in] data pointer to object
+ * @return pointer to newly allocated dl_node
+ */
+dl_node_t *alloc_dlnode(node_pool_t *const p, void *const data);
+
+/**
+ * Hand a dl_node back to the pool it was allocated from, data is kept.
+ * @param[out] p pointer to node pool, NULL to use free
+ * @param[in] n pointer to dl_node instance
+ */
+void release_dlnode(node_pool_t *const p, dl_node_t *n);
+
+/**
+ * Allocate a dlp_node instance from a node pool.
+ * @param[out] p pointer to node pool, NULL to use malloc
+ * @param[in] data pointer to object
+ * @return pointer to newly allocated dlp_node
+ */
+dlp_node_t *alloc_dlpnode(node_pool_t *const p, void *const data);
+
+/**
+ * Hand a dlp_node back to the pool it was allocated from, data is kept.
+ * @param[out] p pointer to node pool, NULL to use free
+ * @param[in] n pointer to dlp_node instance
+ */
+void release_dlpnode(node_pool_t *const p, dlp_node_t *n);
+
 /**
  * Helper for clearing every sequentially linked sl_node.
  * @param[in] n pointer to beginning of sl_node sequence
@@ -191,6 +608,20 @@ void free_slnode_seq(sl_node_t *n); // Helper for clearing
  */
 void free_dlnode_seq(dl_node_t *n); // sequence of nodes
 
+/**
+ * Release every sequentially linked sl_node back to a node pool.
+ * @param[out] p pointer to node pool, NULL to use free
+ * @param[in] n pointer to beginning of sl_node sequence
+ */
+void release_slnode_seq(node_pool_t *const p, sl_node_t *n);
+
+/**
+ * Release every sequentially linked dl_node back to a node pool.
+ * @param[out] p pointer to node pool, NULL to use free
+ * @param[in] n pointer to beginning of dl_node sequence
+ */
+void release_dlnode_seq(node_pool_t *const p, dl_node_t *n);
+
 /**
  * Map a function to interact with each sl_node_t in a sequence of nodes with 
  * *node* pointer passed being the first. The function interacting will get a 
@@ -253,230 +684,1971 @@ uint32_t count_dlnode_seq(dl_node_t *const node, bool reverse);
  */
 
 /**
- * @defgroup Queue Queue functions
+ * @defgroup Pool Node pool functions
  * @{
  */
 
 /**
- * Create a queue instance.
- * @return pointer to newly created queue 
+ * Create a private node pool. A private pool is not synchronized and is meant
+ * to be owned by a single container or thread.
+ * @param[in] node_size size of a single node in bytes
+ * @param[in] slab_nodes number of nodes per slab, 0 for NODE_POOL_SLAB
+ * @return pointer to newly created node pool
  */
-queue_t *create_queue();
+node_pool_t *create_node_pool(size_t node_size, uint32_t slab_nodes);
 
 /**
- * Free queue instance and all its nodes
- * @param[in] q pointer to queue instance
+ * Make every node of a private pool available again while keeping its slabs.
+ * All nodes handed out before are invalidated. Shared pools are left untouched.
+ * @param[out] p pointer to node pool instance
  */
-void free_queue(queue_t *q);
+void reset_node_pool(node_pool_t *const p);
 
 /**
- * Add a node to queue.
- * @param[out] q pointer to queue
- * @param{in] data pointer to node data
+ * Free a private node pool and all its slabs, nodes still in use included.
+ * Shared pools are left untouched.
+ * @param[in] p pointer to node pool instance
  */
-void add_queue(queue_t *const q, void *const data);
+void free_node_pool(node_pool_t *p);
 
 /**
- * Pop a node from the queue (FIFO).
- * @param[out] q pointer to queue
- * @return data pointer stored by the node
+ * Get the process wide pool for a node type. Shared pools are thread safe,
+ * every thread caches up to NODE_POOL_MAGAZINE nodes to avoid the lock.
+ * @param[in] type node type served by the pool
+ * @return pointer to shared node pool
  */
-void *pop_queue(queue_t *const q);
+node_pool_t *shared_node_pool(enum node_pool_type type);
+
+/**
+ * Allocate a node from a pool.
+ * @param[out] p pointer to node pool
+ * @return pointer to uninitialized node or NULL if out of memory
+ */
+void *alloc_node_pool(node_pool_t *const p);
+
+/**
+ * Hand a node back to the pool it was allocated from.
+ * @param[out] p pointer to node pool
+ * @param[in] n pointer to node
+ */
+void release_node_pool(node_pool_t *const p, void *n);
 
-void map_queue(queue_t *const s, void (*func)(sl_node_t *, void *), void *func_data); 
+/**
+ * Return the nodes cached by the calling thread to the shared pools. This is
+ * done automatically when a thread exits.
+ */
+void flush_node_pool_cache();
 /**
  * @}
  */
 
 /**
- * @defgroup Stack Stack functions
+ * @defgroup Epoch Epoch reclamation functions
+ *
+ * Readers wrap every access to shared nodes in enter_epoch/exit_epoch.
+ * Writers retire nodes they unlinked instead of freeing them, the domain
+ * frees them after every thread inside a critical section at the time of
+ * retirement has left it.
  * @{
  */
 
+/** Number of retirements between attempts to advance the epoch */
+#define EPOCH_SCAN 64
+
 /**
- * Create a stack instance.
- * @return pointer to newly created stack 
+ * Create an epoch_domain instance.
+ * @return pointer to newly created epoch_domain or NULL if out of memory
  */
-stack_t *create_stack();
+epoch_domain_t *create_epoch_domain();
 
 /**
- * Free queue instance and all its nodes
- * @param[in] q pointer to queue instance
+ * Free epoch_domain instance and every object still waiting to be freed.
+ * No thread may be inside a critical section of the domain.
+ * @param[in] d pointer to epoch_domain instance
  */
-void free_stack(stack_t *s);
+void free_epoch_domain(epoch_domain_t *d);
 
 /**
- * Add (push) a node to the stack.
- * @param[out] s pointer to stack instance
- * @param[in] data pointer to node data
+ * Get the process wide epoch domain used by the lock-free datastructures.
+ * @return pointer to shared epoch_domain
  */
-void add_stack(stack_t *const s, void *const data);
+epoch_domain_t *shared_epoch_domain();
 
 /**
- * Pop a node from the stack (LIFO).
- * @param[out] s pointer to stack instance
- * @return data pointer stored by the node
+ * Enter a critical section, nodes read inside it stay allocated until
+ * exit_epoch. Critical sections may be nested.
+ * @param[out] d pointer to epoch_domain instance
+ * @return result (-1 if the calling thread could not be registered with the
+ * domain for lack of memory, shared nodes must not be read then, 1 if
+ * entered)
  */
-void *pop_stack(stack_t *const s);
+int8_t enter_epoch(epoch_domain_t *const d);
 
-void map_stack(stack_t *const s, void (*func)(sl_node_t *, void *), void *func_data); 
+/**
+ * Leave the critical section entered last by the calling thread.
+ * @param[out] d pointer to epoch_domain instance
+ */
+void exit_epoch(epoch_domain_t *const d);
+
+/**
+ * Hand an unlinked object to the domain, free_fn is called on it once no
+ * thread can be reading it anymore.
+ * @param[out] d pointer to epoch_domain instance
+ * @param[in] ptr pointer to object
+ * @param[in] free_fn function freeing the object
+ * @return result (-1 if out of memory, the object is then never freed, 1 if
+ * retired)
+ */
+int8_t retire_epoch(epoch_domain_t *const d, void *ptr, void (*free_fn)(void *));
+
+/**
+ * Try to advance the epoch and free what the calling thread retired so far.
+ * Objects retired by other threads are freed by their next retire_epoch.
+ * @param[out] d pointer to epoch_domain instance
+ */
+void flush_epoch(epoch_domain_t *const d);
 /**
  * @}
  */
 
 /**
- * @defgroup Deque Deque functions
+ * @defgroup Queue Queue functions
  * @{
  */
 
 /**
- * Create a deque instance.
- * @return pointer to newly created deque 
+ * Create a queue instance.
+ * @return pointer to newly created queue 
  */
-deque_t *create_deque();
+queue_t *create_queue();
+
+/**
+ * Create a queue instance taking its nodes from the shared sl_node pool.
+ * @return pointer to newly created queue 
+ */
+queue_t *create_queue_pooled();
+
+/**
+ * Create a queue instance owning an arena its nodes are carved from. Freeing
+ * or resetting it releases whole slabs instead of individual nodes.
+ * @return pointer to newly created queue 
+ */
+queue_t *create_queue_arena();
+
+/**
+ * Create a queue instance storing its items in a ring buffer instead of
+ * nodes. The ring doubles when full and never shrinks.
+ * @param[in] capacity number of items to reserve room for, rounded up to a
+ *                     power of two, at most 2^31
+ * @return pointer to newly created queue or NULL if capacity is too large or
+ * out of memory
+ */
+queue_t *create_queue_ring(uint32_t capacity);
 
 /**
  * Free queue instance and all its nodes
  * @param[in] q pointer to queue instance
  */
-void free_deque(deque_t *dq);
+void free_queue(queue_t *q);
 
 /**
- * Add a node to beginning of deque.
- * @param[out] dq pointer to deque instance
- * @param[in] data pointer to node data
+ * Remove all nodes from a queue so it can be reused, data is kept.
+ * @param[out] q pointer to queue instance
  */
-void add_first_deque(deque_t *const dq, void *const data);
+void reset_queue(queue_t *const q);
 
 /**
- * Add a node to end of deque.
- * @param[out] dq pointer to deque instance
- * @param[in] data pointer to node data
+ * Add a node to queue.
+ * @param[out] q pointer to queue
+ * @param{in] data pointer to node data
+ * @return result (-1 if a ring queue could not grow, data is then not added,
+ * 1 if added successfully)
  */
-void add_last_deque(deque_t *const dq, void *const data);
+int8_t add_queue(queue_t *const q, void *const data);
 
 /**
- * Pop a node from the beginning of the deque.
- * @param[out] s pointer to deque instance
+ * Pop a node from the queue (FIFO).
+ * @param[out] q pointer to queue
  * @return data pointer stored by the node
  */
-void *pop_first_deque(deque_t *const dq);
+void *pop_queue(queue_t *const q);
 
 /**
- * Pop a node from the end of the deque.
- * @param[out] s pointer to deque instance
- * @return data pointer stored by the node
+ * Count the number of items in the queue.
+ * @param[in] q pointer to queue instance
+ * @return number of items
  */
-void *pop_last_deque(deque_t *const dq);
+uint32_t count_queue(queue_t *const q);
 
-void map_deque(deque_t *const dq, void (*func)(dl_node_t *, void *), void *func_data, bool reverse);
 /**
- * @}
+ * Map a function to interact with each item from first to last of the queue.
+ * Ring queues pass a temporary sl_node_t that is only valid during the call.
+ * @param[in] q pointer to queue instance
+ * @param[in] func function pointer to user defined function
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
  */
-
+void map_queue(queue_t *const q, void (*func)(sl_node_t *, void *), void *func_data); 
 /**
- * @defgroup Binarytree Binarytree functions
- * @{
+ * @}
  */
 
 /**
- * Create a binarytree instance.
- * @return pointer to newly created binarytree
+ * @defgroup SPSCQueue SPSC queue functions
+ *
+ * Exactly one thread may add and exactly one other thread may pop at a time.
+ * @{
  */
-binarytree_t *create_binarytree();
 
 /**
- * Free binarytree instance and all its dlp_node references.
- * @param[in] t pointer to queue instance
+ * Create a spsc_queue instance.
+ * @param[in] capacity maximum number of items, rounded up to a power of two,
+ * at most 2^31
+ * @return pointer to newly created spsc_queue or NULL if capacity is too
+ * large or out of memory
  */
-void free_binarytree(binarytree_t *t);
+spsc_queue_t *create_spsc_queue(uint32_t capacity);
 
 /**
- * Helper to free nodes of a binarytree recursively below a certain node.
- * @param[in] n pointer to node to free recursively
+ * Free spsc_queue instance, data still queued is kept.
+ * @param[in] q pointer to spsc_queue instance
  */
-void free_sub_binarytree(dlp_node_t *n);
+void free_spsc_queue(spsc_queue_t *q);
 
 /**
- * Add node to a binarytree.
- * @param[out] t pointer to binarytree instance
- * @param[in] data pointer to node data
- * @return result (0 if already in binarytree, 1 if added successfully)
+ * Add an item to the queue (producer).
+ * @param[out] q pointer to spsc_queue instance
+ * @param[in] data pointer to item data, must not be NULL
+ * @return result (0 if queue is full, 1 if added successfully)
  */
-int8_t add_binarytree(binarytree_t *const t, void *const data);
+int8_t add_spsc_queue(spsc_queue_t *const q, void *const data);
 
 /**
- * Delete only node specified by data and reconstruct binarytree accordingly.
- * @param[in] t pointer to binarytree instance
- * @param[in] data pointer to data that will qualify deletion 
+ * Pop an item from the queue (consumer, FIFO).
+ * @param[out] q pointer to spsc_queue instance
+ * @return data pointer of item or NULL if queue is empty
  */
-int8_t del_binarytree(binarytree_t *const t, void *const data);
+void *pop_spsc_queue(spsc_queue_t *const q);
 
 /**
- * Find node in a binarytree.
- * @param[out] n pointer to starting node 
- * @param[in] data pointer to node data
- * @return result (-1 if already in binarytree, 1 if added successfully)
+ * Add up to *n* items to the queue with a single index update (producer).
+ * @param[out] q pointer to spsc_queue instance
+ * @param[in] items array of data pointers
+ * @param[in] n number of items in array
+ * @return number of items added, less than *n* if queue got full
  */
-dlp_node_t *find_binarytree(dlp_node_t *const n, void *const data);
+uint32_t add_many_spsc_queue(spsc_queue_t *const q, void *const *items, uint32_t n);
 
 /**
- * Get node with lowest value on evaluation (WARN: bugged).
- * @param[in] t pointer to binarytree instance
- * @return pointer to node data or NULL if binarytree is empty
+ * Pop up to *n* items from the queue with a single index update (consumer).
+ * @param[out] q pointer to spsc_queue instance
+ * @param[out] items array receiving data pointers
+ * @param[in] n room in array
+ * @return number of items popped
  */
-void *lowest_binarytree(binarytree_t *const t);
+uint32_t pop_many_spsc_queue(spsc_queue_t *const q, void **items, uint32_t n);
 
 /**
- * Get node with highest value on evaluation (WARN: bugged).
- * @param[in] t pointer to binarytree instance
- * @return pointer to node data or NULL if binarytree is empty
+ * Count the number of items in the queue, exact only when called by the
+ * producer or the consumer while the other side is idle.
+ * @param[in] q pointer to spsc_queue instance
+ * @return number of items
  */
-void *highest_binarytree(binarytree_t *const t);
+uint32_t count_spsc_queue(spsc_queue_t *const q);
 /**
  * @}
  */
 
 /**
- * @defgroup Set Set functions
+ * @defgroup MPMCQueue MPMC queue functions
+ *
+ * Any number of threads may add and pop concurrently.
  * @{
  */
 
 /**
- * Create a set instance.
- * @return pointer to newly created set 
+ * Create a mpmc_queue instance.
+ * @param[in] capacity maximum number of items, rounded up to a power of two
+ * @return pointer to newly created mpmc_queue or NULL if out of memory
  */
-set_t *create_set();
+mpmc_queue_t *create_mpmc_queue(uint32_t capacity);
 
 /**
- * Free set instance and all its associated node references.
- * @param[in] s pointer to set instance
+ * Free mpmc_queue instance, data still queued is kept.
+ * @param[in] q pointer to mpmc_queue instance
  */
-void free_set(set_t *s);
+void free_mpmc_queue(mpmc_queue_t *q);
 
 /**
- * Add node to a set.
- * @param[out] s pointer to set
- * @param[in] data pointer to node data
- * @return result (0 if already in set, 1 if added successfully)
+ * Try to add an item to the queue without blocking.
+ * @param[out] q pointer to mpmc_queue instance
+ * @param[in] data pointer to item data, must not be NULL
+ * @return result (0 if queue is full, 1 if added successfully)
  */
-int8_t add_set(set_t *const s, void *const data);
+int8_t try_add_mpmc_queue(mpmc_queue_t *const q, void *const data);
 
 /**
- * Find node in a set.
- * @param[out] s pointer to set
- * @param[in] data pointer to node data
- * @return result (-1 if already in set, 1 if added successfully)
+ * Try to pop an item from the queue without blocking (FIFO).
+ * @param[out] q pointer to mpmc_queue instance
+ * @return data pointer of item or NULL if queue is empty
  */
-int8_t find_set(set_t *const s, void *const data);
+void *try_pop_mpmc_queue(mpmc_queue_t *const q);
 
 /**
- * Delete node in a set.
- * @param[out] s pointer to set instance
- * @param[in] data pointer to data to search for
- * @return result (-1 if not found, 1 if deleted successfully) 
+ * Count the number of items in the queue, approximate under concurrency.
+ * @param[in] q pointer to mpmc_queue instance
+ * @return number of items
  */
-int8_t del_set(set_t *const s, void *const data);
+uint32_t count_mpmc_queue(mpmc_queue_t *const q);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup LFQueue Lock-free queue functions
+ *
+ * Michael-Scott queue, any number of threads may add and pop concurrently.
+ * Nodes come from the shared lf_node pool and popped nodes are retired to
+ * the shared epoch domain.
+ * @{
+ */
+
+/**
+ * Create a lf_queue instance.
+ * @return pointer to newly created lf_queue or NULL if out of memory
+ */
+lf_queue_t *create_lf_queue();
+
+/**
+ * Free lf_queue instance and all its nodes, data is kept.
+ * No thread may use the queue anymore.
+ * @param[in] q pointer to lf_queue instance
+ */
+void free_lf_queue(lf_queue_t *q);
+
+/**
+ * Add an item to the queue.
+ * @param[out] q pointer to lf_queue instance
+ * @param[in] data pointer to item data
+ * @return result (-1 if out of memory, data is then not added, 1 if added
+ * successfully)
+ */
+int8_t add_lf_queue(lf_queue_t *const q, void *const data);
+
+/**
+ * Pop an item from the queue (FIFO).
+ * @param[out] q pointer to lf_queue instance
+ * @return data pointer of item or NULL if queue is empty or the calling
+ * thread could not enter the epoch domain for lack of memory
+ */
+void *pop_lf_queue(lf_queue_t *const q);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Stack Stack functions
+ * @{
+ */
+
+/**
+ * Create a stack instance.
+ * @return pointer to newly created stack 
+ */
+stack_t *create_stack();
+
+/**
+ * Create a stack instance taking its nodes from the shared sl_node pool.
+ * @return pointer to newly created stack 
+ */
+stack_t *create_stack_pooled();
+
+/**
+ * Create a stack instance owning an arena its nodes are carved from. Freeing
+ * or resetting it releases whole slabs instead of individual nodes.
+ * @return pointer to newly created stack 
+ */
+stack_t *create_stack_arena();
+
+/**
+ * Create a stack instance storing its items in a contiguous array instead of
+ * nodes. The array doubles when full and only shrinks on request.
+ * @param[in] capacity number of items to reserve room for, 0 allowed
+ * @return pointer to newly created stack 
+ */
+stack_t *create_stack_vector(uint32_t capacity);
+
+/**
+ * Make sure a vector stack holds at least *capacity* items without growing.
+ * Linked stacks are left untouched.
+ * @param[out] s pointer to stack instance
+ * @param[in] capacity number of items to reserve room for
+ * @return result (-1 if allocation failed, 1 on success)
+ */
+int8_t reserve_stack(stack_t *const s, uint32_t capacity);
+
+/**
+ * Shrink the item array of a vector stack to its number of items.
+ * Linked stacks are left untouched.
+ * @param[out] s pointer to stack instance
+ */
+void shrink_to_fit_stack(stack_t *const s);
+
+/**
+ * Free queue instance and all its nodes
+ * @param[in] q pointer to queue instance
+ */
+void free_stack(stack_t *s);
+
+/**
+ * Remove all nodes from a stack so it can be reused, data is kept.
+ * @param[out] s pointer to stack instance
+ */
+void reset_stack(stack_t *const s);
+
+/**
+ * Add (push) a node to the stack.
+ * @param[out] s pointer to stack instance
+ * @param[in] data pointer to node data
+ * @return result (-1 if a vector stack could not grow, data is then not
+ * added, 1 if added successfully)
+ */
+int8_t add_stack(stack_t *const s, void *const data);
+
+/**
+ * Pop a node from the stack (LIFO).
+ * @param[out] s pointer to stack instance
+ * @return data pointer stored by the node
+ */
+void *pop_stack(stack_t *const s);
+
+/**
+ * Count the number of items in the stack.
+ * @param[in] s pointer to stack instance
+ * @return number of items
+ */
+uint32_t count_stack(stack_t *const s);
+
+/**
+ * Map a function to interact with each item from top to bottom of the stack.
+ * Vector stacks pass a temporary sl_node_t that is only valid during the call.
+ * @param[in] s pointer to stack instance
+ * @param[in] func function pointer to user defined function
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_stack(stack_t *const s, void (*func)(sl_node_t *, void *), void *func_data); 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup LFStack Lock-free stack functions
+ *
+ * Treiber stack, any number of threads may add and pop concurrently. Popped
+ * nodes go straight back to the shared lf_node pool, which never hands
+ * memory back to the system, so a stale read of a node stays a read of an
+ * lf_node. A 16-bit version stored next to the first node address makes a
+ * pop fail when first changed under it. The version wraps: a pop stalled
+ * between reading first and its compare-and-swap while a multiple of 65536
+ * other changes put the same node back on top can still succeed wrongly.
+ * A push and a pop that both lose the race for first may meet in one of the
+ * elimination slots and cancel out without touching first at all.
+ * @{
+ */
+
+/**
+ * Create a lf_stack instance.
+ * @return pointer to newly created lf_stack or NULL if out of memory
+ */
+lf_stack_t *create_lf_stack();
+
+/**
+ * Free lf_stack instance and all its nodes, data is kept.
+ * No thread may use the stack anymore.
+ * @param[in] s pointer to lf_stack instance
+ */
+void free_lf_stack(lf_stack_t *s);
+
+/**
+ * Add (push) an item to the stack.
+ * @param[out] s pointer to lf_stack instance
+ * @param[in] data pointer to item data
+ * @return result (-1 if out of memory, data is then not added, 1 if added
+ * successfully)
+ */
+int8_t add_lf_stack(lf_stack_t *const s, void *const data);
+
+/**
+ * Pop an item from the stack (LIFO).
+ * @param[out] s pointer to lf_stack instance
+ * @return data pointer of item or NULL if stack is empty
+ */
+void *pop_lf_stack(lf_stack_t *const s);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup WSDeque Work-stealing deque functions
+ *
+ * Chase-Lev deque. The owning thread adds and pops at the last end, which
+ * only needs a CAS when it races a thief for the final item. Any other
+ * thread may steal from the first end. The item array doubles when full, and
+ * replaced arrays stay allocated until the deque is freed because a thief
+ * may still read from them.
+ * @{
+ */
+
+/**
+ * Create a ws_deque instance.
+ * @param[in] capacity initial number of items, rounded up to a power of two
+ * @return pointer to newly created ws_deque or NULL if out of memory
+ */
+ws_deque_t *create_ws_deque(uint32_t capacity);
+
+/**
+ * Free ws_deque instance and all its arrays, data is kept.
+ * No thread may use the deque anymore.
+ * @param[in] dq pointer to ws_deque instance
+ */
+void free_ws_deque(ws_deque_t *dq);
+
+/**
+ * Add an item to the end of the deque, owner only.
+ * @param[out] dq pointer to ws_deque instance
+ * @param[in] data pointer to item data, not NULL
+ * @return result (-1 if growing failed, 1 on success)
+ */
+int8_t add_last_ws_deque(ws_deque_t *const dq, void *const data);
+
+/**
+ * Pop the item at the end of the deque (LIFO), owner only.
+ * @param[out] dq pointer to ws_deque instance
+ * @return data pointer of item or NULL if deque is empty
+ */
+void *pop_last_ws_deque(ws_deque_t *const dq);
+
+/**
+ * Steal the item at the beginning of the deque (FIFO), any thread.
+ * @param[out] dq pointer to ws_deque instance
+ * @return data pointer of item or NULL if deque is empty or another thread
+ * took the item first
+ */
+void *steal_first_ws_deque(ws_deque_t *const dq);
+
+/**
+ * Count the number of items in the deque, a snapshot while others run.
+ * @param[in] dq pointer to ws_deque instance
+ * @return number of items
+ */
+uint32_t count_ws_deque(ws_deque_t *const dq);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Deque Deque functions
+ * @{
+ */
+
+/**
+ * Create a deque instance.
+ * @return pointer to newly created deque 
+ */
+deque_t *create_deque();
+
+/**
+ * Create a deque instance taking its nodes from the shared dl_node pool.
+ * @return pointer to newly created deque 
+ */
+deque_t *create_deque_pooled();
+
+/**
+ * Create a deque instance owning an arena its nodes are carved from. Freeing
+ * or resetting it releases whole slabs instead of individual nodes.
+ * @return pointer to newly created deque 
+ */
+deque_t *create_deque_arena();
+
+/**
+ * Create a deque instance storing its items in blocks of DEQUE_BLOCK_SIZE data
+ * pointers linked through a central map instead of one dl_node per item.
+ * Blocks are kept when emptied, so a deque in steady state stops allocating.
+ * @return pointer to newly created deque 
+ */
+deque_t *create_deque_block();
+
+/**
+ * Free queue instance and all its nodes
+ * @param[in] q pointer to queue instance
+ */
+void free_deque(deque_t *dq);
+
+/**
+ * Remove all nodes from a deque so it can be reused, data is kept.
+ * @param[out] dq pointer to deque instance
+ */
+void reset_deque(deque_t *const dq);
+
+/**
+ * Add a node to beginning of deque.
+ * @param[out] dq pointer to deque instance
+ * @param[in] data pointer to node data
+ */
+void add_first_deque(deque_t *const dq, void *const data);
+
+/**
+ * Add a node to end of deque.
+ * @param[out] dq pointer to deque instance
+ * @param[in] data pointer to node data
+ */
+void add_last_deque(deque_t *const dq, void *const data);
+
+/**
+ * Pop a node from the beginning of the deque.
+ * @param[out] s pointer to deque instance
+ * @return data pointer stored by the node
+ */
+void *pop_first_deque(deque_t *const dq);
+
+/**
+ * Pop a node from the end of the deque.
+ * @param[out] s pointer to deque instance
+ * @return data pointer stored by the node
+ */
+void *pop_last_deque(deque_t *const dq);
+
+/**
+ * Count the number of items in the deque.
+ * @param[in] dq pointer to deque instance
+ * @return number of items
+ */
+uint32_t count_deque(deque_t *const dq);
+
+/**
+ * Map a function to interact with each item of the deque, from first to last
+ * or reversed. Block deques pass a temporary dl_node_t that is only valid
+ * during the call.
+ * @param[in] dq pointer to deque instance
+ * @param[in] func function pointer to user defined function
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ * @param[in] reverse map from last to first item
+ */
+void map_deque(deque_t *const dq, void (*func)(dl_node_t *, void *), void *func_data, bool reverse);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Binarytree Binarytree functions
+ * @{
+ */
+
+/**
+ * Create a binarytree instance.
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree();
+
+/**
+ * Create a binarytree instance taking its nodes from the shared dlp_node pool.
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree_pooled();
+
+/**
+ * Create a binarytree instance owning an arena its nodes are carved from.
+ * Freeing or resetting it releases whole slabs instead of individual nodes.
+ * @return pointer to newly created binarytree 
+ */
+binarytree_t *create_binarytree_arena();
+
+/**
+ * Create a binarytree instance with the given balancing. Trees created by
+ * the other constructors may change their mode while they are empty.
+ * @param[in] mode binarytree_mode of binarytree
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree_mode(uint8_t mode);
+
+/**
+ * Create a binarytree instance ordering its data with a comparator. Every
+ * node caches a 64-bit key of its data, the comparator only runs when the
+ * keys of two items are equal. Without a prefix function all keys are 0.
+ * Trees created by the other constructors may change their key_type,
+ * compare and prefix while they are empty.
+ * @param[in] compare returns <0, 0 or >0 when the first item orders before,
+ * equal to or after the second
+ * @param[in] prefix returns a key with prefix(a) < prefix(b) only if a orders
+ * before b, NULL allowed
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *));
+
+/**
+ * Create a binarytree instance ordering data as pointers to int64_t. The
+ * value is the cached key, so data is never dereferenced during a descent.
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree_int();
+
+/**
+ * Create a binarytree instance ordering data as NUL terminated strings. The
+ * first 8 bytes are the cached key, strcmp only runs on equal prefixes.
+ * @return pointer to newly created binarytree
+ */
+binarytree_t *create_binarytree_str();
+
+/**
+ * Free binarytree instance and all its dlp_node references, data is kept.
+ * @param[in] t pointer to queue instance
+ */
+void free_binarytree(binarytree_t *t);
+
+/**
+ * Helper to free nodes of a binarytree and their data below a certain node,
+ * children first along the parent links so deep trees need no stack.
+ * @param[in] n pointer to top node of subtree to free
+ */
+void free_sub_binarytree(dlp_node_t *n);
+
+/**
+ * Remove all nodes from a binarytree so it can be reused, data is kept.
+ * @param[out] t pointer to binarytree instance
+ */
+void reset_binarytree(binarytree_t *const t);
+
+/**
+ * Add node to a binarytree. Splay trees move the node to the root, also if
+ * it was there already.
+ * @param[out] t pointer to binarytree instance
+ * @param[in] data pointer to node data
+ * @return result (0 if already in binarytree, 1 if added successfully)
+ */
+int8_t add_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the 64-bit key cached for data, ordered like data by its key type.
+ * Data with different keys compares like its keys, equal keys of string and
+ * custom data still need the comparator.
+ * @param[in] key_type binarytree_key data is ordered by
+ * @param[in] prefix order preserving key (BINARYTREE_KEY_CUSTOM), NULL allowed
+ * @param[in] data pointer to data
+ * @return cached key of data
+ */
+uint64_t cached_key(uint8_t key_type, uint64_t (*prefix)(const void *),
+        const void *const data);
+
+/**
+ * Sort items in the order of a binarytree and drop duplicates. Items are
+ * radix sorted on their cached keys, comparator ties sorted afterwards. Runs
+ * on up to BINARYTREE_SORT_THREADS threads for large inputs.
+ * @param[in] t pointer to binarytree instance giving the order
+ * @param[in,out] items item data, sorted and deduplicated in place
+ * @param[in] count number of items
+ * @return number of unique items at the start of items, 0 if out of memory
+ */
+uint64_t sort_binarytree_array(binarytree_t *const t, void **const items, uint64_t count);
+
+/**
+ * Build an empty binarytree from unsorted items in O(n) after sorting them
+ * with sort_binarytree_array, duplicates are dropped. The tree comes out
+ * perfectly balanced and colored valid for BINARYTREE_REDBLACK. Its nodes are
+ * carved in breadth first order from a single slab of a private arena the
+ * tree owns from then on, as if created by create_binarytree_arena.
+ * @param[out] t pointer to binarytree instance
+ * @param[in] items item data in any order, left unchanged
+ * @param[in] count number of items
+ * @return result (-1 if binarytree is not empty or out of memory, 1 if built
+ * successfully)
+ */
+int8_t build_binarytree_from_array(binarytree_t *const t, void *const *items,
+        uint64_t count);
+
+/**
+ * Delete only node specified by data and reconstruct binarytree accordingly.
+ * Red-black trees rebalance afterwards, splay trees splay the parent.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data that will qualify deletion 
+ * @return result (-1 if not in binarytree, 1 if deleted successfully)
+ */
+int8_t del_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Find node in a binarytree ordered by the data pointers themselves, starting
+ * from a node. Use search_binarytree for trees with another key type.
+ * O(log n) on balanced trees.
+ * @param[in] n pointer to starting node, usually the root
+ * @param[in] data pointer to node data
+ * @return pointer to node holding data or NULL if not below n
+ */
+dlp_node_t *find_binarytree(dlp_node_t *const n, void *const data);
+
+/**
+ * Find node in a binarytree in the order of its key type, O(log n) on
+ * balanced trees. Splay trees move the node, or the last one visited on a
+ * miss, to the root, so lookups change the tree and need exclusive access.
+ * O(log n) amortized there and faster on skewed lookups.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to node data
+ * @return pointer to node holding data or NULL if not in binarytree
+ */
+dlp_node_t *search_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the lowest item not ordered before data.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *lower_bound_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the lowest item ordered after data.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if no item is higher than data
+ */
+void *upper_bound_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the highest item not ordered after data.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is higher than data
+ */
+void *floor_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the lowest item not ordered before data, same as lower_bound_binarytree.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *ceiling_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get number of items in a binarytree, O(1) from the subtree sizes every
+ * node keeps. Sizes are 32 bit, a tree holds at most UINT32_MAX items.
+ * @param[in] t pointer to binarytree instance
+ * @return number of items
+ */
+uint64_t count_binarytree(binarytree_t *const t);
+
+/**
+ * Get the number of items ordered before data, O(log n) on a red-black tree.
+ * Data does not need to be in the binarytree.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return rank of data, its position if it is in the binarytree
+ */
+uint64_t rank_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Get the item at a position in order, O(log n) on a red-black tree.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] k position of item, 0 for the lowest
+ * @return pointer to item data or NULL if k is not below the item count
+ */
+void *select_binarytree(binarytree_t *const t, uint64_t k);
+
+/**
+ * Count items from low up to but not including high, O(log n) on a
+ * red-black tree.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] low lowest data counted, NULL for no lower limit
+ * @param[in] high first data no longer counted, NULL for no upper limit
+ * @return number of items in the range
+ */
+uint64_t count_range_binarytree(binarytree_t *const t, void *const low,
+        void *const high);
+
+/**
+ * Get the node of the lowest item, start of an in-order iteration.
+ * @param[in] t pointer to binarytree instance
+ * @return pointer to node or NULL if binarytree is empty
+ */
+dlp_node_t *first_binarytree(binarytree_t *const t);
+
+/**
+ * Get the node of the highest item, start of a reverse iteration.
+ * @param[in] t pointer to binarytree instance
+ * @return pointer to node or NULL if binarytree is empty
+ */
+dlp_node_t *last_binarytree(binarytree_t *const t);
+
+/**
+ * Get the in-order successor of a node, following the parent links instead
+ * of keeping a stack. O(1) amortized over a full iteration. The tree may not
+ * change during an iteration.
+ * @param[in] n pointer to node
+ * @return pointer to next node or NULL if n holds the highest item
+ */
+dlp_node_t *next_binarytree(dlp_node_t *n);
+
+/**
+ * Get the in-order predecessor of a node, see next_binarytree.
+ * @param[in] n pointer to node
+ * @return pointer to previous node or NULL if n holds the lowest item
+ */
+dlp_node_t *prev_binarytree(dlp_node_t *n);
+
+/**
+ * Get the node of the lowest item not ordered before data, start of an
+ * in-order iteration from data on.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to node or NULL if every item is lower than data
+ */
+dlp_node_t *seek_binarytree(binarytree_t *const t, void *const data);
+
+/**
+ * Call a function on the items from low up to but excluding high in
+ * ascending order until it returns false. Iterates with next_binarytree, so
+ * memory use is constant whatever the depth of the tree.
+ * @param[in] t pointer to binarytree instance
+ * @param[in] low pointer to lowest data to include, NULL for no lower bound
+ * @param[in] high pointer to data to stop at, NULL for no upper bound
+ * @param[in] func function pointer to user defined function, gets item data
+ * and returns whether to go on
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ * @return number of items func was called on
+ */
+uint64_t scan_binarytree(binarytree_t *const t, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data);
+
+/**
+ * Get node with lowest value on evaluation (WARN: bugged).
+ * @param[in] t pointer to binarytree instance
+ * @return pointer to node data or NULL if binarytree is empty
+ */
+void *lowest_binarytree(binarytree_t *const t);
+
+/**
+ * Get node with highest value on evaluation (WARN: bugged).
+ * @param[in] t pointer to binarytree instance
+ * @return pointer to node data or NULL if binarytree is empty
+ */
+void *highest_binarytree(binarytree_t *const t);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup BTree B-tree functions
+ *
+ * B+tree keeping up to BTREE_ORDER items per node in sorted arrays, so one
+ * cache miss resolves several comparisons. Items are ordered like in a
+ * binarytree of the same key_type, nodes cache the 64-bit key of every item.
+ * All items live in leaves linked in order, inner nodes only hold
+ * separators. Deleting leaves nodes underfull and only removes empty ones.
+ * @{
+ */
+
+/**
+ * Create a btree instance ordering data by address.
+ * @return pointer to newly created btree
+ */
+btree_t *create_btree();
+
+/**
+ * Create a btree instance ordering its data with a comparator, see
+ * create_binarytree_cmp.
+ * @param[in] compare returns <0, 0 or >0 when the first item orders before,
+ * equal to or after the second
+ * @param[in] prefix returns an order preserving key of an item, NULL allowed
+ * @return pointer to newly created btree
+ */
+btree_t *create_btree_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *));
+
+/**
+ * Create a btree instance ordering data as pointers to int64_t.
+ * @return pointer to newly created btree
+ */
+btree_t *create_btree_int();
+
+/**
+ * Create a btree instance ordering data as NUL terminated strings.
+ * @return pointer to newly created btree
+ */
+btree_t *create_btree_str();
+
+/**
+ * Free btree instance and all its nodes, data is kept.
+ * @param[in] t pointer to btree instance
+ */
+void free_btree(btree_t *t);
+
+/**
+ * Remove all items from a btree so it can be reused, data is kept.
+ * @param[out] t pointer to btree instance
+ */
+void reset_btree(btree_t *const t);
+
+/**
+ * Add an item to a btree.
+ * @param[out] t pointer to btree instance
+ * @param[in] data pointer to item data
+ * @return result (-1 if allocation failed, 0 if already in btree, 1 if added
+ * successfully)
+ */
+int8_t add_btree(btree_t *const t, void *const data);
+
+/**
+ * Bulk load sorted items into an empty btree, filling leaves completely.
+ * @param[out] t pointer to btree instance
+ * @param[in] items item data in strictly ascending order
+ * @param[in] n number of items
+ * @return result (-1 if btree is not empty, items are not strictly
+ * ascending or allocation failed, the btree is then empty, 1 if loaded
+ * successfully)
+ */
+int8_t load_btree(btree_t *const t, void *const *items, uint64_t n);
+
+/**
+ * Delete an item from a btree.
+ * @param[out] t pointer to btree instance
+ * @param[in] data pointer to data that will qualify deletion
+ * @return result (-1 if not in btree, 1 if deleted successfully)
+ */
+int8_t del_btree(btree_t *const t, void *const data);
+
+/**
+ * Find the item of a btree ordered equal to data.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to search for
+ * @return pointer to item data or NULL if not in btree
+ */
+void *find_btree(btree_t *const t, void *const data);
+
+/**
+ * Check whether a btree holds an item.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to search for
+ * @return result (0 if not in btree, 1 if in btree)
+ */
+int8_t contains_btree(btree_t *const t, void *const data);
+
+/**
+ * Get the lowest item not ordered before data.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *lower_bound_btree(btree_t *const t, void *const data);
+
+/**
+ * Get the lowest item ordered after data.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if no item is higher than data
+ */
+void *upper_bound_btree(btree_t *const t, void *const data);
+
+/**
+ * Get the highest item not ordered after data.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is higher than data
+ */
+void *floor_btree(btree_t *const t, void *const data);
+
+/**
+ * Get the lowest item not ordered before data, same as lower_bound_btree.
+ * @param[in] t pointer to btree instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *ceiling_btree(btree_t *const t, void *const data);
+
+/**
+ * Count the number of items in the btree.
+ * @param[in] t pointer to btree instance
+ * @return number of items
+ */
+uint64_t count_btree(btree_t *const t);
+
+/**
+ * Bytes taken by a btree and its nodes.
+ * @param[in] t pointer to btree instance
+ * @return size in bytes
+ */
+size_t memory_btree(btree_t *const t);
+
+/**
+ * Map a function over all items in ascending order, walking the leaves.
+ * @param[in] t pointer to btree instance
+ * @param[in] func function pointer to user defined function, gets item data
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_btree(btree_t *const t, void (*func)(void *, void *), void *func_data);
+
+/**
+ * Map a function over the items from low up to but excluding high in
+ * ascending order, walking the leaves.
+ * @param[in] t pointer to btree instance
+ * @param[in] low pointer to lowest data to include, NULL for no lower bound
+ * @param[in] high pointer to data to stop at, NULL for no upper bound
+ * @param[in] func function pointer to user defined function, gets item data
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_range_btree(btree_t *const t, void *const low, void *const high,
+        void (*func)(void *, void *), void *func_data);
+
+/**
+ * Call a function on the items from low up to but excluding high in
+ * ascending order until it returns false, walking the leaves.
+ * @param[in] t pointer to btree instance
+ * @param[in] low pointer to lowest data to include, NULL for no lower bound
+ * @param[in] high pointer to data to stop at, NULL for no upper bound
+ * @param[in] func function pointer to user defined function, gets item data
+ * and returns whether to go on
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ * @return number of items func was called on
+ */
+uint64_t scan_btree(btree_t *const t, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup PBinarytree Persistent binarytree functions
+ *
+ * A pbinarytree never changes a node once it is reachable. Adding or deleting
+ * copies the O(log n) nodes on the path to the change, rebalances the copies
+ * as an AVL tree and publishes the new root atomically. Readers acquire the
+ * root of the current version without locking and search it for as long as
+ * they like, versions they hold are not reclaimed. Nodes replaced by a write
+ * are retired to the epoch_domain of the tree and freed once no reader that
+ * could see them is left. Writers serialize on a mutex.
+ * @{
+ */
+
+/**
+ * Create a pbinarytree instance.
+ * @param[in] key_type binarytree_key the tree orders by
+ * @param[in] compare comparator (BINARYTREE_KEY_CUSTOM), NULL otherwise
+ * @param[in] prefix order preserving key (BINARYTREE_KEY_CUSTOM), NULL allowed
+ * @return pointer to newly created pbinarytree
+ */
+pbinarytree_t *create_pbinarytree(uint8_t key_type,
+        int (*compare)(const void *, const void *), uint64_t (*prefix)(const void *));
+
+/**
+ * Free pbinarytree instance and the nodes of all its versions, data is kept.
+ * No thread may use the tree or hold a version of it anymore.
+ * @param[in] t pointer to pbinarytree instance
+ */
+void free_pbinarytree(pbinarytree_t *t);
+
+/**
+ * Add an item, publishing a new version. Thread safe.
+ * @param[out] t pointer to pbinarytree instance
+ * @param[in] data pointer to item data
+ * @return result (0 if already in pbinarytree, 1 if added successfully, -1
+ * if out of memory)
+ */
+int8_t add_pbinarytree(pbinarytree_t *const t, void *const data);
+
+/**
+ * Delete an item, publishing a new version. Thread safe.
+ * @param[out] t pointer to pbinarytree instance
+ * @param[in] data pointer to data that qualifies deletion
+ * @return result (-1 if not in pbinarytree or out of memory, 1 if deleted
+ * successfully)
+ */
+int8_t del_pbinarytree(pbinarytree_t *const t, void *const data);
+
+/**
+ * Get number of items in the current version.
+ * @param[in] t pointer to pbinarytree instance
+ * @return number of items
+ */
+uint64_t count_pbinarytree(pbinarytree_t *const t);
+
+/**
+ * Acquire the current version for reading, entering a critical section of
+ * the epoch_domain of the tree. Writes after this do not change the version.
+ * Pair with release_pbinarytree on the same thread, acquires may be nested.
+ * Entering orders memory, so holding a version over several lookups lets
+ * their cache misses overlap.
+ * @param[in] t pointer to pbinarytree instance
+ * @return root of the version, NULL if it is empty
+ */
+const pb_node_t *acquire_pbinarytree(pbinarytree_t *const t);
+
+/**
+ * Release the version acquired last by the calling thread.
+ * @param[in] t pointer to pbinarytree instance
+ */
+void release_pbinarytree(pbinarytree_t *const t);
+
+/**
+ * Search an acquired version for an item.
+ * @param[in] t pointer to pbinarytree instance
+ * @param[in] version root of a version held by the calling thread
+ * @param[in] data pointer to data to search for
+ * @return pointer to item data or NULL if not in the version
+ */
+void *find_pbinarytree(pbinarytree_t *const t, const pb_node_t *version,
+        void *const data);
+
+/**
+ * Get the lowest item of an acquired version not ordered before data.
+ * @param[in] t pointer to pbinarytree instance
+ * @param[in] version root of a version held by the calling thread
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *lower_bound_pbinarytree(pbinarytree_t *const t, const pb_node_t *version,
+        void *const data);
+
+/**
+ * Search the current version for an item, acquiring and releasing it.
+ * @param[in] t pointer to pbinarytree instance
+ * @param[in] data pointer to data to search for
+ * @return pointer to item data or NULL if not in pbinarytree
+ */
+void *search_pbinarytree(pbinarytree_t *const t, void *const data);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup HashSet Hash set functions
+ *
+ * Hash set keeping item pointers in open addressed slots. Slots come in
+ * groups of HASHSET_GROUP with one control byte each, holding 7 bits of the
+ * item hash or marking the slot empty. A lookup matches all control bytes of
+ * a group against the hash in one SSE2 compare and only follows the item
+ * pointers of matching slots, moving on to the next group while the current
+ * one is full. Deleting shifts later items of the probe back instead of
+ * leaving tombstones, so lookups never slow down with churn. The table
+ * doubles beyond 7/8 load, costing about 10.3 bytes per item at that load.
+ * @{
+ */
+
+/**
+ * Create a hashset instance.
+ * @param[in] key_type binarytree_key deciding equality of items
+ * @param[in] hash hash of an item, NULL for the default of key_type, required
+ * for BINARYTREE_KEY_CUSTOM
+ * @param[in] compare returns 0 for equal items (BINARYTREE_KEY_CUSTOM), NULL
+ * otherwise
+ * @return pointer to newly created hashset
+ */
+hashset_t *create_hashset(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *));
+
+/**
+ * Get the hash a hashset uses for an item, every bit of it depends on every
+ * bit of the key.
+ * @param[in] key_type binarytree_key of item
+ * @param[in] hash hash of an item, NULL for the default of key_type
+ * @param[in] data pointer to item data
+ * @return 64-bit hash
+ */
+uint64_t hashed_key(uint8_t key_type, uint64_t (*hash)(const void *),
+        const void *const data);
+
+/**
+ * Free hashset instance and its slots, data is kept.
+ * @param[in] t pointer to hashset instance
+ */
+void free_hashset(hashset_t *t);
+
+/**
+ * Remove all items from a hashset so it can be reused, the slots are kept.
+ * @param[out] t pointer to hashset instance
+ */
+void reset_hashset(hashset_t *const t);
+
+/**
+ * Make room for a number of items, so adding them does not grow the table.
+ * @param[out] t pointer to hashset instance
+ * @param[in] count number of items
+ * @return result (-1 if allocation failed, 1 if successful)
+ */
+int8_t reserve_hashset(hashset_t *const t, uint64_t count);
+
+/**
+ * Add an item to a hashset.
+ * @param[out] t pointer to hashset instance
+ * @param[in] data pointer to item data
+ * @return result (-1 if allocation failed, 0 if already in hashset, 1 if
+ * added successfully)
+ */
+int8_t add_hashset(hashset_t *const t, void *const data);
+
+/**
+ * Delete an item from a hashset.
+ * @param[out] t pointer to hashset instance
+ * @param[in] data pointer to data that will qualify deletion
+ * @return result (-1 if not in hashset, 1 if deleted successfully)
+ */
+int8_t del_hashset(hashset_t *const t, void *const data);
+
+/**
+ * Find the item of a hashset equal to data.
+ * @param[in] t pointer to hashset instance
+ * @param[in] data pointer to data to search for
+ * @return pointer to item data or NULL if not in hashset
+ */
+void *find_hashset(hashset_t *const t, const void *const data);
+
+/**
+ * Check whether a hashset holds an item.
+ * @param[in] t pointer to hashset instance
+ * @param[in] data pointer to data to search for
+ * @return result (0 if not in hashset, 1 if in hashset)
+ */
+int8_t contains_hashset(hashset_t *const t, const void *const data);
+
+/**
+ * Count the number of items in the hashset.
+ * @param[in] t pointer to hashset instance
+ * @return number of items
+ */
+uint64_t count_hashset(hashset_t *const t);
+
+/**
+ * Bytes taken by a hashset and its slots.
+ * @param[in] t pointer to hashset instance
+ * @return size in bytes
+ */
+size_t memory_hashset(hashset_t *const t);
+
+/**
+ * Map a function over all items in slot order, which follows the hashes.
+ * @param[in] t pointer to hashset instance
+ * @param[in] func function pointer to user defined function, gets item data
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_hashset(hashset_t *const t, void (*func)(void *, void *), void *func_data);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Set Set functions
+ * @{
+ */
+
+/**
+ * Create a set instance.
+ * @return pointer to newly created set 
+ */
+set_t *create_set();
+
+/**
+ * Create a set instance taking its nodes from the shared dlp_node pool.
+ * @return pointer to newly created set 
+ */
+set_t *create_set_pooled();
+
+/**
+ * Create a set instance owning an arena its nodes are carved from. Freeing
+ * or resetting it releases whole slabs instead of individual nodes.
+ * @return pointer to newly created set 
+ */
+set_t *create_set_arena();
+
+/**
+ * Create a set instance whose binarytree uses the given balancing.
+ * @param[in] mode binarytree_mode of binarytree
+ * @return pointer to newly created set 
+ */
+set_t *create_set_mode(uint8_t mode);
+
+/**
+ * Create a set instance ordering its items with a comparator, see
+ * create_binarytree_cmp.
+ * @param[in] compare returns <0, 0 or >0 when the first item orders before,
+ * equal to or after the second
+ * @param[in] prefix returns an order preserving key of an item, NULL allowed
+ * @return pointer to newly created set 
+ */
+set_t *create_set_cmp(int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *));
+
+/**
+ * Create a set instance of pointers to int64_t, ordered by value.
+ * @return pointer to newly created set 
+ */
+set_t *create_set_int();
+
+/**
+ * Create a set instance of NUL terminated strings, ordered by strcmp.
+ * @return pointer to newly created set 
+ */
+set_t *create_set_str();
+
+/**
+ * Create a set instance stored in a btree instead of a binarytree.
+ * @param[in] key_type binarytree_key the set orders by
+ * @param[in] compare comparator (BINARYTREE_KEY_CUSTOM), NULL otherwise
+ * @param[in] prefix order preserving key (BINARYTREE_KEY_CUSTOM), NULL allowed
+ * @return pointer to newly created set 
+ */
+set_t *create_set_btree(uint8_t key_type, int (*compare)(const void *, const void *),
+        uint64_t (*prefix)(const void *));
+
+/**
+ * Create a set instance stored in a hashset, for membership without order.
+ * Ordered lookups and scans of such a set find nothing, see create_hashset.
+ * @param[in] key_type binarytree_key deciding equality of items
+ * @param[in] hash hash of an item, NULL for the default of key_type
+ * @param[in] compare comparator (BINARYTREE_KEY_CUSTOM), NULL otherwise. A
+ * comparator ordering the items lets freeze_set sort them
+ * @return pointer to newly created set 
+ */
+set_t *create_set_hash(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *));
+
+/**
+ * Free set instance and all its associated node references.
+ * @param[in] s pointer to set instance
+ */
+void free_set(set_t *s);
+
+/**
+ * Remove all nodes from a set so it can be reused, data is kept.
+ * @param[out] s pointer to set instance
+ */
+void reset_set(set_t *const s);
+
+/**
+ * Add node to a set.
+ * @param[out] s pointer to set
+ * @param[in] data pointer to node data
+ * @return result (0 if already in set, 1 if added successfully)
+ */
+int8_t add_set(set_t *const s, void *const data);
+
+/**
+ * Check whether a set holds an item.
+ * @param[in] s pointer to set
+ * @param[in] data pointer to node data
+ * @return result (0 if not in set, 1 if in set)
+ */
+int8_t contains_set(set_t *const s, void *const data);
+
+/**
+ * Get the lowest item of a set not ordered before data.
+ * @param[in] s pointer to set
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *lower_bound_set(set_t *const s, void *const data);
+
+/**
+ * Get the lowest item of a set ordered after data.
+ * @param[in] s pointer to set
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if no item is higher than data
+ */
+void *upper_bound_set(set_t *const s, void *const data);
+
+/**
+ * Get the highest item of a set not ordered after data.
+ * @param[in] s pointer to set
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is higher than data
+ */
+void *floor_set(set_t *const s, void *const data);
+
+/**
+ * Get the lowest item of a set not ordered before data, same as
+ * lower_bound_set.
+ * @param[in] s pointer to set
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *ceiling_set(set_t *const s, void *const data);
+
+/**
+ * Call a function on the items of a set from low up to but excluding high in
+ * ascending order until it returns false, in constant memory.
+ * @param[in] s pointer to set
+ * @param[in] low pointer to lowest data to include, NULL for no lower bound
+ * @param[in] high pointer to data to stop at, NULL for no upper bound
+ * @param[in] func function pointer to user defined function, gets item data
+ * and returns whether to go on
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ * @return number of items func was called on
+ */
+uint64_t scan_set(set_t *const s, void *const low, void *const high,
+        bool (*func)(void *, void *), void *func_data);
+
+/**
+ * Build an empty set from unsorted items, duplicates are dropped. Binarytree
+ * sets are built by build_binarytree_from_array, btree sets bulk loaded and
+ * hash sets sized once before adding.
+ * @param[out] s pointer to set instance
+ * @param[in] items item data in any order, left unchanged
+ * @param[in] count number of items
+ * @return result (-1 if set is not empty or out of memory, 1 if built
+ * successfully)
+ */
+int8_t build_set_from_array(set_t *const s, void *const *items, uint64_t count);
+
+/**
+ * Create a set of the items in a or b. Set algebra takes two sets holding
+ * items of the same key_type and returns a new set with the backend and
+ * order of a, items in both sets are taken from a. Ordered sets are merged
+ * in order, galloping through the larger one beyond SET_GALLOP_RATIO times
+ * the size of the smaller. At such a ratio an intersection, like the
+ * difference of the smaller set, looks the items of the small set up in the
+ * large one instead, and two hash sets always look up each other's items. A
+ * hash set merged with an ordered one is sorted first, so a comparator of
+ * custom items has to order them. Merging and lookups are split over up to
+ * SET_ALGEBRA_THREADS threads for large sets. Only splay sets change, by
+ * the lookups.
+ * @param[in] a pointer to set instance
+ * @param[in] b pointer to set instance
+ * @return pointer to newly created set or NULL if the key_types differ or
+ * out of memory
+ */
+set_t *union_set(set_t *const a, set_t *const b);
+
+/**
+ * Create a set of the items in both a and b, see union_set.
+ * @param[in] a pointer to set instance
+ * @param[in] b pointer to set instance
+ * @return pointer to newly created set or NULL if the key_types differ or
+ * out of memory
+ */
+set_t *intersect_set(set_t *const a, set_t *const b);
+
+/**
+ * Create a set of the items in a but not in b, see union_set.
+ * @param[in] a pointer to set instance
+ * @param[in] b pointer to set instance
+ * @return pointer to newly created set or NULL if the key_types differ or
+ * out of memory
+ */
+set_t *difference_set(set_t *const a, set_t *const b);
+
+/**
+ * Create a set of the items in exactly one of a and b, see union_set.
+ * @param[in] a pointer to set instance
+ * @param[in] b pointer to set instance
+ * @return pointer to newly created set or NULL if the key_types differ or
+ * out of memory
+ */
+set_t *symmetric_difference_set(set_t *const a, set_t *const b);
+
+/**
+ * Delete node in a set.
+ * @param[out] s pointer to set instance
+ * @param[in] data pointer to data to search for
+ * @return result (-1 if not found, 1 if deleted successfully) 
+ */
+int8_t del_set(set_t *const s, void *const data);
+
+/**
+ * Put a filter in front of a set, so most lookups of absent items return
+ * after reading one cache line. add_set and del_set keep it up to date and
+ * rebuild it twice as large once the set outgrows it. The counters of the
+ * filter report how lookups went, they are not updated atomically.
+ * @param[out] s pointer to set instance
+ * @param[in] fpr share of absent items the filter lets through, 0 for
+ * FILTER_DEFAULT_FPR
+ * @return result (-1 if out of memory or custom items have neither a hash
+ * nor a prefix, 1 if attached successfully)
+ */
+int8_t attach_filter_set(set_t *const s, double fpr);
+
+/**
+ * Remove and free the filter of a set, if any.
+ * @param[out] s pointer to set instance
+ */
+void detach_filter_set(set_t *const s);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Snapshot Set snapshot functions
+ *
+ * Snapshots copy the items of a set into arrays in Eytzinger order: the root
+ * at index 1 and the children of index i at 2i and 2i + 1. The top levels
+ * share a few cache lines and a search steps down without branching on the
+ * comparison, prefetching the line holding the descendants three levels
+ * below. A snapshot never changes after it is frozen, so any number of
+ * threads may search it concurrently without locks.
+ * @{
+ */
+
+/**
+ * Freeze the items of a binarytree into a snapshot, the tree is unchanged.
+ * @param[in] t pointer to binarytree instance
+ * @return pointer to newly created snapshot or NULL if out of memory
+ */
+set_snapshot_t *freeze_binarytree(binarytree_t *const t);
+
+/**
+ * Freeze the items of a set into a snapshot, the set is unchanged.
+ * @param[in] s pointer to set instance
+ * @return pointer to newly created snapshot or NULL if out of memory
+ */
+set_snapshot_t *freeze_set(set_t *const s);
+
+/**
+ * Free snapshot instance, data is kept. No thread may search it anymore.
+ * @param[in] s pointer to snapshot instance
+ */
+void free_snapshot(set_snapshot_t *s);
+
+/**
+ * Get number of items in a snapshot.
+ * @param[in] s pointer to snapshot instance
+ * @return number of items
+ */
+uint64_t count_snapshot(const set_snapshot_t *const s);
+
+/**
+ * Check whether a snapshot holds an item.
+ * @param[in] s pointer to snapshot instance
+ * @param[in] data pointer to data to search for
+ * @return result (0 if not in snapshot, 1 if in snapshot)
+ */
+int8_t contains_snapshot(const set_snapshot_t *const s, const void *const data);
+
+/**
+ * Get the lowest item of a snapshot not ordered before data.
+ * @param[in] s pointer to snapshot instance
+ * @param[in] data pointer to data to compare with
+ * @return pointer to item data or NULL if every item is lower than data
+ */
+void *lower_bound_snapshot(const set_snapshot_t *const s, const void *const data);
+
+/**
+ * Check a batch of items against a snapshot. SNAPSHOT_BATCH searches step
+ * down in lockstep, so their cache misses overlap instead of queueing.
+ * @param[in] s pointer to snapshot instance
+ * @param[in] items data to search for
+ * @param[in] n number of items
+ * @param[out] results 1 for every item found and 0 otherwise, NULL allowed
+ * @return number of items found
+ */
+uint64_t contains_many_snapshot(const set_snapshot_t *const s, void *const *items,
+        uint64_t n, int8_t *results);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Filter Filter functions
+ *
+ * Counting Bloom filter answering whether a hash may have been added. Every
+ * hash maps to one cache line block and to several 4-bit counters within
+ * it, so a lookup reads a single cache line. Counters let hashes be deleted
+ * again, a counter reaching 15 stays there. A filter holding capacity
+ * hashes lets through about fpr of the absent ones.
+ * @{
+ */
+
+/**
+ * Create a filter instance.
+ * @param[in] capacity number of hashes to size the filter for
+ * @param[in] fpr false positive rate at capacity, 0 for FILTER_DEFAULT_FPR
+ * @return pointer to newly created filter or NULL if out of memory
+ */
+filter_t *create_filter(uint64_t capacity, double fpr);
+
+/**
+ * Free filter instance.
+ * @param[in] f pointer to filter instance
+ */
+void free_filter(filter_t *f);
+
+/**
+ * Remove all hashes from a filter, the counters of lookups are kept.
+ * @param[out] f pointer to filter instance
+ */
+void reset_filter(filter_t *const f);
+
+/**
+ * Add a hash to a filter.
+ * @param[out] f pointer to filter instance
+ * @param[in] hash hash of an item
+ */
+void add_filter(filter_t *const f, uint64_t hash);
+
+/**
+ * Delete a hash added before from a filter.
+ * @param[out] f pointer to filter instance
+ * @param[in] hash hash of an item
+ */
+void del_filter(filter_t *const f, uint64_t hash);
+
+/**
+ * Check whether a filter may hold a hash.
+ * @param[in] f pointer to filter instance
+ * @param[in] hash hash of an item
+ * @return result (0 if never added, 1 if maybe added)
+ */
+int8_t contains_filter(const filter_t *const f, uint64_t hash);
+
+/**
+ * Bytes taken by a filter and its blocks.
+ * @param[in] f pointer to filter instance
+ * @return size in bytes
+ */
+size_t memory_filter(const filter_t *const f);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Bitmap Compressed bitmap functions
+ *
+ * Set of uint32_t values split by their high 16 bits into containers of up
+ * to 65536 low values. A container is a sorted array of uint16_t up to 4096
+ * values, beyond that a bitset of 8KB. optimize_bitmap turns containers into
+ * sorted runs where those are smaller still. A dense range of values costs
+ * about a bit each, a sparse one 2 bytes each. Unions and intersections
+ * combine bitsets 128 bits at a time with SSE2 and count the result on the
+ * way, arrays are merged.
+ * @{
+ */
+
+/**
+ * Create a bitmap instance.
+ * @return pointer to newly created bitmap
+ */
+bitmap_t *create_bitmap();
+
+/**
+ * Free bitmap instance and all its containers.
+ * @param[in] b pointer to bitmap instance
+ */
+void free_bitmap(bitmap_t *b);
+
+/**
+ * Remove all values from a bitmap so it can be reused.
+ * @param[out] b pointer to bitmap instance
+ */
+void reset_bitmap(bitmap_t *const b);
+
+/**
+ * Add a value to a bitmap.
+ * @param[out] b pointer to bitmap instance
+ * @param[in] value value to add
+ * @return result (-1 if allocation failed, 0 if already in bitmap, 1 if
+ * added successfully)
+ */
+int8_t add_bitmap(bitmap_t *const b, uint32_t value);
+
+/**
+ * Delete a value from a bitmap.
+ * @param[out] b pointer to bitmap instance
+ * @param[in] value value to delete
+ * @return result (-1 if not in bitmap or allocation failed, 1 if deleted
+ * successfully)
+ */
+int8_t del_bitmap(bitmap_t *const b, uint32_t value);
+
+/**
+ * Check whether a bitmap holds a value.
+ * @param[in] b pointer to bitmap instance
+ * @param[in] value value to search for
+ * @return result (0 if not in bitmap, 1 if in bitmap)
+ */
+int8_t contains_bitmap(const bitmap_t *const b, uint32_t value);
+
+/**
+ * Store every container of a bitmap as array, bitset or runs, whichever is
+ * smallest. Adding and deleting values keeps the runs, until they outgrow a
+ * bitset.
+ * @param[out] b pointer to bitmap instance
+ * @return result (-1 if allocation failed, 1 if successful)
+ */
+int8_t optimize_bitmap(bitmap_t *const b);
+
+/**
+ * Create a bitmap of the values in a or b.
+ * @param[in] a pointer to bitmap instance
+ * @param[in] b pointer to bitmap instance
+ * @return pointer to newly created bitmap or NULL if out of memory
+ */
+bitmap_t *union_bitmap(const bitmap_t *const a, const bitmap_t *const b);
+
+/**
+ * Create a bitmap of the values in both a and b.
+ * @param[in] a pointer to bitmap instance
+ * @param[in] b pointer to bitmap instance
+ * @return pointer to newly created bitmap or NULL if out of memory
+ */
+bitmap_t *intersect_bitmap(const bitmap_t *const a, const bitmap_t *const b);
+
+/**
+ * Count the values in both a and b without creating their intersection.
+ * @param[in] a pointer to bitmap instance
+ * @param[in] b pointer to bitmap instance
+ * @return number of values
+ */
+uint64_t count_intersect_bitmap(const bitmap_t *const a, const bitmap_t *const b);
+
+/**
+ * Count the number of values in the bitmap.
+ * @param[in] b pointer to bitmap instance
+ * @return number of values
+ */
+uint64_t count_bitmap(const bitmap_t *const b);
+
+/**
+ * Bytes taken by a bitmap and its containers.
+ * @param[in] b pointer to bitmap instance
+ * @return size in bytes
+ */
+size_t memory_bitmap(const bitmap_t *const b);
+
+/**
+ * Map a function over all values in ascending order.
+ * @param[in] b pointer to bitmap instance
+ * @param[in] func function pointer to user defined function, gets a value
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_bitmap(const bitmap_t *const b, void (*func)(uint32_t, void *), void *func_data);
+
+/**
+ * Create an optimized bitmap of the values of a set of int64_t, the set is
+ * unchanged.
+ * @param[in] s pointer to set instance
+ * @return pointer to newly created bitmap or NULL if the set holds no
+ * int64_t, a value outside of uint32_t or out of memory
+ */
+bitmap_t *compress_set(set_t *const s);
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Bag Bag functions
+ *
+ * Counting multiset keeping item pointers and their counts side by side in
+ * open addressed slots, so adding, removing and counting an item touches one
+ * run of slots with no allocation. The full hash is kept with every item, a
+ * probe compares items only on equal hashes and a resize or merge never
+ * hashes again. The table doubles beyond 3/4 load. A bag is not thread safe,
+ * threads count into bags of their own and merge them at the end.
+ * @{
+ */
+
+/**
+ * Create a bag instance.
+ * @param[in] key_type binarytree_key deciding equality of items
+ * @param[in] hash hash of an item, NULL for the default of key_type, required
+ * for BINARYTREE_KEY_CUSTOM
+ * @param[in] compare returns 0 for equal items (BINARYTREE_KEY_CUSTOM), NULL
+ * otherwise
+ * @return pointer to newly created bag or NULL if out of memory
+ */
+bag_t *create_bag(uint8_t key_type, uint64_t (*hash)(const void *),
+        int (*compare)(const void *, const void *));
+
+/**
+ * Free bag instance and its slots, data is kept.
+ * @param[in] b pointer to bag instance
+ */
+void free_bag(bag_t *b);
+
+/**
+ * Remove all items from a bag so it can be reused, the slots are kept.
+ * @param[out] b pointer to bag instance
+ */
+void reset_bag(bag_t *const b);
+
+/**
+ * Make room for a number of different items, so adding them does not grow
+ * the table.
+ * @param[out] b pointer to bag instance
+ * @param[in] distinct number of different items
+ * @return result (-1 if allocation failed, 1 if successful)
+ */
+int8_t reserve_bag(bag_t *const b, uint64_t distinct);
+
+/**
+ * Add one occurrence of an item to a bag. The first occurrence keeps its
+ * data pointer, later ones only count.
+ * @param[out] b pointer to bag instance
+ * @param[in] data pointer to item data
+ * @return result (-1 if allocation failed, 1 if added successfully)
+ */
+int8_t add_bag(bag_t *const b, void *const data);
+
+/**
+ * Remove one occurrence of an item from a bag, the item leaves the bag with
+ * its last occurrence.
+ * @param[out] b pointer to bag instance
+ * @param[in] data pointer to data that will qualify removal
+ * @return result (-1 if not in bag, 1 if removed successfully)
+ */
+int8_t remove_bag(bag_t *const b, void *const data);
+
+/**
+ * Count the occurrences of an item in a bag.
+ * @param[in] b pointer to bag instance
+ * @param[in] data pointer to data to search for
+ * @return number of occurrences, 0 if not in bag
+ */
+uint64_t count_bag(bag_t *const b, const void *const data);
+
+/**
+ * Count the different items in a bag.
+ * @param[in] b pointer to bag instance
+ * @return number of different items
+ */
+uint64_t distinct_bag(bag_t *const b);
+
+/**
+ * Count all occurrences of all items in a bag.
+ * @param[in] b pointer to bag instance
+ * @return sum of the counts
+ */
+uint64_t total_bag(bag_t *const b);
+
+/**
+ * Bytes taken by a bag and its slots.
+ * @param[in] b pointer to bag instance
+ * @return size in bytes
+ */
+size_t memory_bag(bag_t *const b);
+
+/**
+ * Map a function over all items in slot order, which follows the hashes.
+ * @param[in] b pointer to bag instance
+ * @param[in] func function pointer to user defined function, gets item data
+ * and its count
+ * @param[out] func_data pointer to data for user defined function, NULL allowed
+ */
+void map_bag(bag_t *const b, void (*func)(void *, uint64_t, void *), void *func_data);
+
+/**
+ * Get the k most frequent items of a bag, in O(n log k) with a heap of k
+ * entries. Items of equal count come in no particular order.
+ * @param[in] b pointer to bag instance
+ * @param[in] k number of items wanted
+ * @param[out] top array with room for the smaller of k and distinct_bag
+ * entries, filled by decreasing count
+ * @return number of entries filled, the smaller of k and distinct_bag
+ */
+uint64_t top_bag(bag_t *const b, uint64_t k, bag_entry_t *const top);
+
+/**
+ * Add all occurrences of the items of one bag to another, src is unchanged.
+ * Items new to dst keep the data pointer of src. Both bags need the same
+ * key_type, hash and compare.
+ * @param[out] dst pointer to bag instance counting the merge
+ * @param[in] src pointer to bag instance merged into dst
+ * @return result (-1 if the bags do not match or allocation failed, dst is
+ * then unchanged, 1 if merged successfully)
+ */
+int8_t merge_bag(bag_t *const dst, bag_t *const src);
 /**
  * @}
  */
@@ -0,0 +1,157 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * SET ALGEBRA BENCHMARK
+ *
+ * Builds pairs of int64_t sets on btrees and on hashsets, once of equal size
+ * with half of the items shared and once with the second set a thousandth of
+ * the first. Reports the time of every set operation on each pair, next to
+ * an intersection computed by looking up the items of the smaller set in
+ * the larger one by hand. Checks first that sets of custom items ordered
+ * by opposite comparators combine into the right items.
+ *
+ * usage: example_algebra [number of items]
+ */
+
+struct lookup_loop {
+    set_t *other;
+    set_t *result;
+};
+
+void add_if_contained(void *data, void *arg)
+{
+    struct lookup_loop *l = arg;
+
+    if (contains_set(l->other, data))
+        add_set(l->result, data);
+}
+
+double time_op(set_t *(*op)(set_t *const, set_t *const), set_t *a, set_t *b)
+{
+    double start = now_seconds();
+    set_t *r = op(a, b);
+    double time = now_seconds() - start;
+
+    free_set(r);
+    return time;
+}
+
+int ascending(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+int descending(const void *a, const void *b)
+{
+    return ascending(b, a);
+}
+
+void check_count(const char *name, set_t *r, uint64_t expected)
+{
+    uint64_t count = r == NULL ? 0 : r->backend == SET_BTREE ? count_btree(r->btree) :
+        count_binarytree(r->tree);
+
+    if (count != expected)
+        printf("%s of opposite orders: %lu items, expected %lu\n", name, count, expected);
+
+    if (r != NULL)
+        free_set(r);
+}
+
+/**
+ * Multiples of 2 and of 3 below 20, ascending in a and descending in b
+ */
+void check_orders(set_t *a, set_t *b, int64_t *values)
+{
+    for (int64_t i = 0; i < 20; i++) {
+        if (i % 2 == 0) add_set(a, &values[i]);
+        if (i % 3 == 0) add_set(b, &values[i]);
+    }
+
+    check_count("union", union_set(a, b), 13);
+    check_count("intersection", intersect_set(a, b), 4);
+    check_count("difference", difference_set(a, b), 6);
+    check_count("symmetric difference", symmetric_difference_set(a, b), 9);
+
+    free_set(a);
+    free_set(b);
+}
+
+void run(const char *name, uint8_t backend, int64_t *values, uint64_t na,
+        uint64_t nb, uint64_t shift)
+{
+    set_t *a, *b;
+
+    if (backend == SET_HASH) {
+        a = create_set_hash(BINARYTREE_KEY_INT64, NULL, NULL);
+        b = create_set_hash(BINARYTREE_KEY_INT64, NULL, NULL);
+    } else {
+        a = create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL);
+        b = create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL);
+    }
+
+    // b starts shift items into a, so it shares nb - shift of them
+    for (uint64_t i = 0; i < na; i++)
+        add_set(a, &values[i]);
+    for (uint64_t i = 0; i < nb; i++)
+        add_set(b, &values[shift + i]);
+
+    struct lookup_loop l = { .other = a };
+
+    l.result = backend == SET_HASH ? create_set_hash(BINARYTREE_KEY_INT64, NULL, NULL) :
+        create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL);
+
+    double start = now_seconds();
+    if (backend == SET_HASH)
+        map_hashset(b->hash, add_if_contained, &l);
+    else
+        map_btree(b->btree, add_if_contained, &l);
+    double loop = now_seconds() - start;
+
+    free_set(l.result);
+
+    printf("%-16s %10.4f %10.4f %10.4f %10.4f %10.4f\n", name, loop,
+            time_op(intersect_set, a, b), time_op(union_set, a, b),
+            time_op(difference_set, a, b), time_op(symmetric_difference_set, a, b));
+
+    free_set(a);
+    free_set(b);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *values = malloc(sizeof(*values) * 2 * n);
+    int64_t small[20];
+    uint64_t state = 88172645463325252ULL;
+
+    for (int64_t i = 0; i < 20; i++)
+        small[i] = i;
+
+    check_orders(create_set_cmp(ascending, NULL), create_set_cmp(descending, NULL), small);
+    check_orders(create_set_btree(BINARYTREE_KEY_CUSTOM, ascending, NULL),
+            create_set_cmp(descending, NULL), small);
+
+    for (uint64_t i = 0; i < 2 * n; i++) {
+        next_random(&state);
+
+        values[i] = (int64_t)state;
+    }
+
+    printf("%-16s %10s %10s %10s %10s %10s\n", "sets", "loop s", "intersect s",
+            "union s", "diff s", "symdiff s");
+
+    run("btree balanced", SET_BTREE, values, n, n, n / 2);
+    run("hash balanced", SET_HASH, values, n, n, n / 2);
+    run("btree skewed", SET_BTREE, values, n, n / 1000, n - n / 2000);
+    run("hash skewed", SET_HASH, values, n, n / 1000, n - n / 2000);
+
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,166 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+
+/**
+ * BAG BENCHMARK
+ *
+ * Counts a stream of int64_t events drawn from a Zipf distribution over a
+ * number of keys, first with counters found through a hashset, then with a
+ * bag, then with one bag per thread counting a slice of the stream and the
+ * bags merged at the end. Reports the time per event and of the merge and
+ * the most frequent keys.
+ *
+ * usage: example_bag [number of keys] [number of events] [threads] [exponent s]
+ */
+
+#define MAX_THREADS 64
+
+struct counter {
+    int64_t key;            /**< first, so the hashset compares it as an int64_t */
+    uint64_t count;
+};
+
+struct worker {
+    bag_t *bag;
+    int64_t **events;
+    uint64_t count;
+};
+
+void *run_worker(void *arg)
+{
+    struct worker *w = arg;
+
+    for (uint64_t i = 0; i < w->count; i++)
+        add_bag(w->bag, w->events[i]);
+
+    return NULL;
+}
+
+void count_hashset_events(int64_t **events, uint64_t m, uint64_t n)
+{
+    hashset_t *t = create_hashset(BINARYTREE_KEY_INT64, NULL, NULL);
+    struct counter *counters = malloc(sizeof(*counters) * n);
+    uint64_t used = 0;
+
+    double start = now_seconds();
+    for (uint64_t i = 0; i < m; i++) {
+        struct counter *c = find_hashset(t, events[i]);
+
+        if (c == NULL) {
+            c = &counters[used++];
+            c->key = *events[i];
+            c->count = 0;
+            add_hashset(t, c);
+        }
+
+        c->count++;
+    }
+
+    printf("%-10s %10.1f ns/event %10lu keys\n", "hashset",
+            (now_seconds() - start) / m * 1e9, count_hashset(t));
+
+    free_hashset(t);
+    free(counters);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t m = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000000;
+    int threads = argc > 3 ? atoi(argv[3]) : 4;
+    double s = argc > 4 ? atof(argv[4]) : 1.1;
+    int64_t *keys = malloc(sizeof(*keys) * n);
+    double *cdf = malloc(sizeof(*cdf) * n);
+    int64_t **events = malloc(sizeof(*events) * m);
+    uint64_t state = 88172645463325252ULL;
+    double sum = 0;
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    for (uint64_t i = 0; i < n; i++) {
+        keys[i] = (int64_t)next_random(&state);
+        sum += 1.0 / pow(i + 1, s);
+        cdf[i] = sum;
+    }
+
+    for (uint64_t i = 0; i < m; i++) {
+        double u = (next_random(&state) >> 11) * 0x1p-53 * sum;
+        uint64_t low = 0, high = n - 1;
+
+        while (low < high) {
+            uint64_t mid = (low + high) / 2;
+
+            if (cdf[mid] < u) low = mid + 1;
+            else high = mid;
+        }
+
+        events[i] = &keys[low];
+    }
+
+    printf("%lu keys, %lu events, s = %.2f\n", n, m, s);
+
+    count_hashset_events(events, m, n);
+
+    bag_t *b = create_bag(BINARYTREE_KEY_INT64, NULL, NULL);
+    double start = now_seconds();
+    for (uint64_t i = 0; i < m; i++)
+        add_bag(b, events[i]);
+    printf("%-10s %10.1f ns/event %10lu keys %10.1f bytes/key\n", "bag",
+            (now_seconds() - start) / m * 1e9, distinct_bag(b),
+            (double)memory_bag(b) / distinct_bag(b));
+
+    pthread_t tid[MAX_THREADS];
+    struct worker w[MAX_THREADS];
+
+    start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        w[i].bag = create_bag(BINARYTREE_KEY_INT64, NULL, NULL);
+        w[i].events = events + m / threads * i;
+        w[i].count = i == threads - 1 ? m - m / threads * i : m / threads;
+        pthread_create(&tid[i], NULL, run_worker, &w[i]);
+    }
+
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+    double counted = now_seconds();
+
+    for (int i = 1; i < threads; i++) {
+        merge_bag(w[0].bag, w[i].bag);
+        free_bag(w[i].bag);
+    }
+    double merged = now_seconds();
+
+    printf("%-10s %10.1f ns/event %10lu keys %10.2f ms merge, %d threads\n", "bags",
+            (merged - start) / m * 1e9, distinct_bag(w[0].bag),
+            (merged - counted) * 1e3, threads);
+
+    if (total_bag(w[0].bag) != total_bag(b))
+        printf("merged bags counted %lu events of %lu\n", total_bag(w[0].bag),
+                total_bag(b));
+
+    bag_entry_t top[5];
+    uint64_t k = top_bag(w[0].bag, 5, top);
+
+    for (uint64_t i = 0; i < k; i++) {
+        if (count_bag(b, top[i].data) != top[i].count)
+            printf("counts differ\n");
+
+        printf("top %lu: %20ld %10lu times\n", i + 1, *(int64_t *)top[i].data,
+                top[i].count);
+    }
+
+    free_bag(w[0].bag);
+    free_bag(b);
+    free(events);
+    free(cdf);
+    free(keys);
+
+    exit(EXIT_SUCCESS);
+}
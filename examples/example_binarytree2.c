@@ -6,22 +6,32 @@
 
 int64_t randomInt()
 {
-    return rand() - (RAND_MAX / 2); 
+    return rand() - (RAND_MAX / 2);
+}
+
+double measure_build(binarytree_t *tree, int64_t **order, uint64_t inserts)
+{
+    clock_t start = clock();
+    for (int i = 0; i < inserts; i++)
+        add_binarytree(tree, order[i]);
+    clock_t end = clock();
+
+    return (double)(end - start) / (double)CLOCKS_PER_SEC;
 }
 
 /**
  * BINARY TREE EXAMPLES AND TESTS
- */ 
+ */
 int main()
 {
     uint64_t inserts = 1000000;
 
-    struct binarytree *tree = create_binarytree();
     int64_t *values = malloc(sizeof(*values) * inserts);
+    int64_t **order = malloc(sizeof(*order) * inserts);
 
-    if (values == NULL)
+    if (values == NULL || order == NULL)
         printf("Test value allocation failed");
-    
+
     clock_t start, end;
     double in_seconds;
 
@@ -34,20 +44,51 @@ int main()
 
     printf("Made %ld random numbers in %f seconds\n", inserts, in_seconds);
 
-    start = clock(); 
+    // the tree orders by address, shuffle the addresses to keep it shallow
     for (int i = 0; i < inserts; i++)
-        add_binarytree(tree, &values[i]);
+        order[i] = &values[i];
+    for (int i = inserts - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int64_t *tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    struct binarytree *tree = create_binarytree();
+    in_seconds = measure_build(tree, order, inserts);
+    printf("Made %ld inserts in %f seconds\n", inserts, in_seconds);
+
+    start = clock();
+    free_binarytree(tree);
     end = clock();
 
     in_seconds = (double)(end - start) / (double)CLOCKS_PER_SEC;
 
-    printf("Made %ld inserts in %f seconds\n", inserts, in_seconds);
-    
+    printf("Freed %ld nodes in %f seconds\n", inserts, in_seconds);
+
+    tree = create_binarytree_arena();
+    in_seconds = measure_build(tree, order, inserts);
+    printf("Made %ld arena inserts in %f seconds\n", inserts, in_seconds);
+
+    start = clock();
+    reset_binarytree(tree);
+    end = clock();
+
+    in_seconds = (double)(end - start) / (double)CLOCKS_PER_SEC;
+
+    printf("Reset %ld arena nodes in %f seconds\n", inserts, in_seconds);
+
+    in_seconds = measure_build(tree, order, inserts);
+    printf("Made %ld inserts into reset arena in %f seconds\n", inserts, in_seconds);
+
     start = clock();
     free_binarytree(tree);
     end = clock();
 
     in_seconds = (double)(end - start) / (double)CLOCKS_PER_SEC;
 
-    printf("Made %ld inserts in %f seconds\n", inserts, in_seconds);
+    printf("Freed %ld arena nodes in %f seconds\n", inserts, in_seconds);
+
+    free(order);
+    free(values);
 }
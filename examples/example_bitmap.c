@@ -0,0 +1,84 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * COMPRESSED BITMAP BENCHMARK
+ *
+ * Builds two sets of uint32_t IDs, each holding about half of the IDs below
+ * 2n at random plus a dense range, as hash sets and as compressed bitmaps.
+ * Reports the memory taken per ID next to that of a binarytree node, and the
+ * time of their intersection, union and intersection count.
+ *
+ * usage: example_bitmap [number of ids]
+ */
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *ids = malloc(sizeof(*ids) * 2 * n);
+    uint64_t state = 88172645463325252ULL;
+    set_t *sets[2];
+    bitmap_t *bitmaps[2];
+    double start;
+
+    for (uint64_t i = 0; i < 2 * n; i++)
+        ids[i] = i;
+
+    for (int k = 0; k < 2; k++) {
+        sets[k] = create_set_hash(BINARYTREE_KEY_INT64, NULL, NULL);
+
+        for (uint64_t i = 0; i < 2 * n; i++)
+            if (next_random(&state) & 1 || (i > n / 4 * (k + 1) && i < n / 4 * (k + 3)))
+                add_set(sets[k], &ids[i]);
+
+        start = now_seconds();
+        bitmaps[k] = compress_set(sets[k]);
+        printf("set %d: %lu ids, compressed in %.3f s\n", k, count_bitmap(bitmaps[k]),
+                now_seconds() - start);
+    }
+
+    printf("\n%-12s %12s\n", "storage", "bytes/id");
+    printf("%-12s %12.2f\n", "dlp_node", (double)sizeof(dlp_node_t));
+    printf("%-12s %12.2f\n", "hashset",
+            (double)memory_hashset(sets[0]->hash) / count_hashset(sets[0]->hash));
+    printf("%-12s %12.2f\n", "bitmap",
+            (double)memory_bitmap(bitmaps[0]) / count_bitmap(bitmaps[0]));
+
+    printf("\n%-12s %12s %12s %12s\n", "operation", "hashset s", "bitmap s", "ids");
+
+    start = now_seconds();
+    set_t *s = intersect_set(sets[0], sets[1]);
+    double set_time = now_seconds() - start;
+
+    start = now_seconds();
+    bitmap_t *b = intersect_bitmap(bitmaps[0], bitmaps[1]);
+    printf("%-12s %12.4f %12.4f %12lu\n", "intersect", set_time, now_seconds() - start,
+            count_bitmap(b));
+    free_set(s);
+    free_bitmap(b);
+
+    start = now_seconds();
+    s = union_set(sets[0], sets[1]);
+    set_time = now_seconds() - start;
+
+    start = now_seconds();
+    b = union_bitmap(bitmaps[0], bitmaps[1]);
+    printf("%-12s %12.4f %12.4f %12lu\n", "union", set_time, now_seconds() - start,
+            count_bitmap(b));
+    free_set(s);
+    free_bitmap(b);
+
+    start = now_seconds();
+    uint64_t count = count_intersect_bitmap(bitmaps[0], bitmaps[1]);
+    printf("%-12s %12s %12.4f %12lu\n", "count", "-", now_seconds() - start, count);
+
+    for (int k = 0; k < 2; k++) {
+        free_bitmap(bitmaps[k]);
+        free_set(sets[k]);
+    }
+    free(ids);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,122 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * B-TREE BENCHMARK
+ *
+ * Builds an int64_t index over random values as red-black binarytree and as
+ * btree, the latter both by adding items and by bulk loading them sorted.
+ * Reports build time, lookup throughput in random order, the time of an
+ * in-order leaf scan and the memory taken per item.
+ *
+ * usage: example_btree [number of items]
+ */
+
+int compare_int(const void *a, const void *b)
+{
+    int64_t x = **(int64_t *const *)a;
+    int64_t y = **(int64_t *const *)b;
+
+    return (x > y) - (x < y);
+}
+
+double lookups(void *index, bool btree, void **items, uint64_t n)
+{
+    double start = now_seconds();
+
+    for (uint64_t i = 0; i < n; i++)
+        if (btree ? !contains_btree(index, items[i]) :
+                search_binarytree(index, items[i]) == NULL)
+            printf("item not found\n");
+
+    return n / (now_seconds() - start) / 1e6;
+}
+
+void count_item(void *data, void *count)
+{
+    (*(uint64_t *)count)++;
+}
+
+void report(const char *name, double build, double lookup, double scan, double bytes)
+{
+    printf("%-20s %10.3f %14.2f %10.3f %12.1f\n", name, build, lookup, scan, bytes);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *values = malloc(sizeof(*values) * n);
+    void **items = malloc(sizeof(*items) * n);
+    void **sorted = malloc(sizeof(*sorted) * n);
+    uint64_t state = 88172645463325252ULL;
+    double start, build, scan;
+
+    for (uint64_t i = 0; i < n; i++) {
+        next_random(&state);
+
+        values[i] = (int64_t)state;
+        items[i] = sorted[i] = &values[i];
+    }
+
+    printf("%-20s %10s %14s %10s %12s\n", "index", "build s", "Mlookups/s",
+            "scan s", "bytes/item");
+
+    binarytree_t *tree = create_binarytree_arena();
+    tree->key_type = BINARYTREE_KEY_INT64;
+    tree->mode = BINARYTREE_REDBLACK;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(tree, items[i]);
+    build = now_seconds() - start;
+
+    report("redblack dlp_node", build, lookups(tree, false, items, n), 0,
+            sizeof(dlp_node_t));
+    free_binarytree(tree);
+
+    btree_t *btree = create_btree_int();
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_btree(btree, items[i]);
+    build = now_seconds() - start;
+
+    uint64_t count = 0;
+    start = now_seconds();
+    map_btree(btree, count_item, &count);
+    scan = now_seconds() - start;
+
+    report("btree add", build, lookups(btree, true, items, n), scan,
+            (double)memory_btree(btree) / count_btree(btree));
+    free_btree(btree);
+
+    // bulk loading wants strictly ascending items
+    start = now_seconds();
+    qsort(sorted, n, sizeof(*sorted), compare_int);
+
+    uint64_t unique = 0;
+    for (uint64_t i = 0; i < n; i++)
+        if (unique == 0 || compare_int(&sorted[unique - 1], &sorted[i]) != 0)
+            sorted[unique++] = sorted[i];
+
+    btree = create_btree_int();
+    load_btree(btree, sorted, unique);
+    build = now_seconds() - start;
+
+    count = 0;
+    start = now_seconds();
+    map_btree(btree, count_item, &count);
+    scan = now_seconds() - start;
+
+    report("btree load", build, lookups(btree, true, items, n), scan,
+            (double)memory_btree(btree) / count_btree(btree));
+    free_btree(btree);
+
+    free(sorted);
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
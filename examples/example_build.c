@@ -0,0 +1,81 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * BINARYTREE BULK BUILD BENCHMARK
+ *
+ * Indexes random int64_t values, a quarter of them duplicates, once by adding
+ * them one by one to a red-black binarytree and once by building the tree
+ * from the whole array. Reports the build time, the time to look every value
+ * up again and the height of the resulting tree.
+ *
+ * usage: example_build [number of items]
+ */
+
+uint32_t height(dlp_node_t *const n)
+{
+    if (n == NULL) return 0;
+
+    uint32_t prev = height(n->prev);
+    uint32_t next = height(n->next);
+
+    return 1 + (prev > next ? prev : next);
+}
+
+void report(const char *name, binarytree_t *t, double build, void **items, uint64_t n)
+{
+    double start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        if (search_binarytree(t, items[i]) == NULL)
+            printf("item not found\n");
+    double lookup = now_seconds() - start;
+
+    printf("%-12s %10.3f %10.3f %8u\n", name, build, lookup, height(t->root));
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *values = malloc(sizeof(*values) * n);
+    void **items = malloc(sizeof(*items) * n);
+    uint64_t state = 88172645463325252ULL;
+    double start, build;
+
+    for (uint64_t i = 0; i < n; i++) {
+        next_random(&state);
+
+        values[i] = i % 4 == 3 ? values[state % i] : (int64_t)state;
+        items[i] = &values[i];
+    }
+
+    printf("%-12s %10s %10s %8s\n", "tree", "build s", "lookup s", "height");
+
+    binarytree_t *t = create_binarytree_arena();
+    t->key_type = BINARYTREE_KEY_INT64;
+    t->mode = BINARYTREE_REDBLACK;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(t, items[i]);
+    build = now_seconds() - start;
+
+    report("add", t, build, items, n);
+    free_binarytree(t);
+
+    t = create_binarytree_int();
+    t->mode = BINARYTREE_REDBLACK;
+
+    start = now_seconds();
+    build_binarytree_from_array(t, items, n);
+    build = now_seconds() - start;
+
+    report("build", t, build, items, n);
+    free_binarytree(t);
+
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,92 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * BINARYTREE KEY BENCHMARK
+ *
+ * Builds red-black binarytrees over random int64_t values and random strings
+ * and looks every item up again. The specialized int and string trees are
+ * compared with trees calling a comparator, with and without a cached key
+ * prefix.
+ *
+ * usage: example_comparator [number of items]
+ */
+#define STRING_SIZE 24
+
+int compare_int(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+uint64_t prefix_int(const void *a)
+{
+    return (uint64_t)*(const int64_t *)a ^ 1ULL << 63;
+}
+
+int compare_str(const void *a, const void *b)
+{
+    return strcmp(a, b);
+}
+
+void run(const char *name, binarytree_t *t, void **items, uint64_t n)
+{
+    t->mode = BINARYTREE_REDBLACK;
+
+    double start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(t, items[i]);
+    double insert = now_seconds() - start;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        if (search_binarytree(t, items[i]) == NULL)
+            printf("item not found\n");
+    double search = now_seconds() - start;
+
+    printf("%-22s %10.3f %10.3f\n", name, insert, search);
+
+    free_binarytree(t);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *values = malloc(sizeof(*values) * n);
+    char *strings = malloc(STRING_SIZE * n);
+    void **items = malloc(sizeof(*items) * n);
+    uint64_t state = 88172645463325252ULL;
+
+    for (uint64_t i = 0; i < n; i++) {
+        next_random(&state);
+
+        values[i] = (int64_t)state;
+        snprintf(strings + i * STRING_SIZE, STRING_SIZE, "%016lx-item", state >> 4);
+    }
+
+    printf("%-22s %10s %10s\n", "tree", "insert s", "search s");
+
+    for (uint64_t i = 0; i < n; i++)
+        items[i] = &values[i];
+
+    run("int", create_binarytree_int(), items, n);
+    run("int comparator+prefix", create_binarytree_cmp(compare_int, prefix_int), items, n);
+    run("int comparator", create_binarytree_cmp(compare_int, NULL), items, n);
+
+    for (uint64_t i = 0; i < n; i++)
+        items[i] = strings + i * STRING_SIZE;
+
+    run("string", create_binarytree_str(), items, n);
+    run("string comparator", create_binarytree_cmp(compare_str, NULL), items, n);
+
+    free(items);
+    free(strings);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,88 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * FILTER BENCHMARK
+ *
+ * Fills int64_t sets on a red-black binarytree and a btree with random
+ * values, then looks up a stream of which nine in ten values are absent,
+ * once without and once with a counting Bloom filter attached. Reports the
+ * time per lookup, the false positive rate measured by the filter and the
+ * bytes per item the filter adds.
+ *
+ * usage: example_filter [number of items] [false positive rate]
+ */
+
+void run(const char *name, set_t *s, void **items, void **lookups, uint64_t n, double fpr)
+{
+    for (uint64_t i = 0; i < n; i++)
+        add_set(s, items[i]);
+
+    for (int filtered = 0; filtered < 2; filtered++) {
+        if (filtered && attach_filter_set(s, fpr) < 0) {
+            printf("filter could not be attached\n");
+            break;
+        }
+
+        uint64_t found = 0;
+        double start = now_seconds();
+        for (uint64_t i = 0; i < 10 * n; i++)
+            found += contains_set(s, lookups[i]);
+        double lookup = now_seconds() - start;
+
+        if (found != n)
+            printf("found %lu items of %lu\n", found, n);
+
+        if (!filtered) {
+            printf("%-10s %10s %10.1f %10s %10s %12s\n", name, "none",
+                    lookup / (10 * n) * 1e9, "-", "-", "-");
+            continue;
+        }
+
+        filter_t *f = s->filter;
+        printf("%-10s %10g %10.1f %10.4f %10lu %12.1f\n", name, fpr,
+                lookup / (10 * n) * 1e9,
+                (double)f->false_positives / (f->false_positives + f->rejected),
+                f->rejected, (double)memory_filter(f) / n);
+    }
+
+    free_set(s);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    double fpr = argc > 2 ? strtod(argv[2], NULL) : FILTER_DEFAULT_FPR;
+    int64_t *values = malloc(sizeof(*values) * 10 * n);
+    void **items = malloc(sizeof(*items) * n);
+    void **lookups = malloc(sizeof(*lookups) * 10 * n);
+    uint64_t state = 88172645463325252ULL;
+
+    for (uint64_t i = 0; i < 10 * n; i++) {
+        next_random(&state);
+
+        // odd values are added, even ones stay absent
+        values[i] = (int64_t)(state | 1) - (int64_t)(i % 10 != 0);
+        lookups[i] = &values[i];
+    }
+
+    for (uint64_t i = 0; i < n; i++)
+        items[i] = &values[10 * i];
+
+    printf("%-10s %10s %10s %10s %10s %12s\n", "set", "filter", "lookup ns",
+            "measured", "rejected", "bytes/item");
+
+    set_t *s = create_set_arena();
+    s->tree->key_type = BINARYTREE_KEY_INT64;
+    s->tree->mode = BINARYTREE_REDBLACK;
+    run("redblack", s, items, lookups, n, fpr);
+    run("btree", create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL), items, lookups, n, fpr);
+
+    free(lookups);
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
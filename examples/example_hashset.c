@@ -0,0 +1,87 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * HASH SET BENCHMARK
+ *
+ * Fills int64_t sets on a red-black binarytree, a btree and a hashset with
+ * random values, then looks up every value and as many absent ones in random
+ * order. Reports the time of each phase per item and the memory taken per
+ * item.
+ *
+ * usage: example_hashset [number of items]
+ */
+
+void run(const char *name, set_t *s, void **items, void **absent, uint64_t n)
+{
+    double start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_set(s, items[i]);
+    double add = now_seconds() - start;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        if (!contains_set(s, items[i]))
+            printf("item not found\n");
+    double hit = now_seconds() - start;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        if (contains_set(s, absent[i]))
+            printf("absent item found\n");
+    double miss = now_seconds() - start;
+
+    double bytes;
+    if (s->backend == SET_BTREE)
+        bytes = (double)memory_btree(s->btree) / count_btree(s->btree);
+    else if (s->backend == SET_HASH)
+        bytes = (double)memory_hashset(s->hash) / count_hashset(s->hash);
+    else if (s->tree->pool != NULL)
+        bytes = s->tree->pool->node_size; // carved from slabs, no chunk header
+    else
+        bytes = sizeof(dlp_node_t) + sizeof(size_t); // malloc chunk header
+
+    printf("%-10s %10.1f %10.1f %10.1f %12.1f\n", name, add / n * 1e9,
+            hit / n * 1e9, miss / n * 1e9, bytes);
+
+    free_set(s);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int64_t *values = malloc(sizeof(*values) * 2 * n);
+    void **items = malloc(sizeof(*items) * n);
+    void **absent = malloc(sizeof(*absent) * n);
+    uint64_t state = 88172645463325252ULL;
+
+    for (uint64_t i = 0; i < 2 * n; i++) {
+        next_random(&state);
+
+        // odd values are added, even ones stay absent
+        values[i] = (int64_t)(state | 1) - (int64_t)(i & 1);
+    }
+
+    for (uint64_t i = 0; i < n; i++) {
+        items[i] = &values[2 * i];
+        absent[i] = &values[2 * i + 1];
+    }
+
+    printf("%-10s %10s %10s %10s %12s\n", "set", "add ns", "hit ns", "miss ns",
+            "bytes/item");
+
+    set_t *s = create_set_arena();
+    s->tree->key_type = BINARYTREE_KEY_INT64;
+    s->tree->mode = BINARYTREE_REDBLACK;
+    run("redblack", s, items, absent, n);
+    run("btree", create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL), items, absent, n);
+    run("hash", create_set_hash(BINARYTREE_KEY_INT64, NULL, NULL), items, absent, n);
+
+    free(absent);
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,197 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+/**
+ * LOCK-FREE QUEUE STRESS TEST AND BENCHMARK
+ *
+ * Stress: producers add items tagged with their id and a sequence number,
+ * consumers check that items of every producer arrive in order and that
+ * nothing gets lost or duplicated.
+ * Throughput: every thread repeatedly adds and pops one item, lf_queue
+ * against a mutex guarded queue_t from 1 up to the given number of threads.
+ *
+ * usage: example_lfqueue [items per thread] [max threads]
+ */
+#define MAX_THREADS 64
+#define SEQ_BITS 40
+
+struct stress {
+    lf_queue_t *q;
+    uint64_t items;
+    int producers;
+    _Atomic uint64_t consumed;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t errors;
+};
+
+struct bench {
+    lf_queue_t *lf;
+    queue_t *locked;
+    pthread_mutex_t lock;
+    uint64_t ops;
+};
+
+struct worker {
+    void *shared;
+    uintptr_t id;
+};
+
+/**
+ * Stress
+ */
+void *stress_producer(void *arg)
+{
+    struct worker *w = arg;
+    struct stress *s = w->shared;
+
+    for (uint64_t i = 1; i <= s->items; i++)
+        add_lf_queue(s->q, (void *)(w->id << SEQ_BITS | i));
+
+    return NULL;
+}
+
+void *stress_consumer(void *arg)
+{
+    struct worker *w = arg;
+    struct stress *s = w->shared;
+    uint64_t last[MAX_THREADS] = { 0 };
+    uint64_t total = s->items * s->producers;
+
+    while (atomic_load(&s->consumed) < total) {
+        uintptr_t item = (uintptr_t)pop_lf_queue(s->q);
+
+        if (item == 0) {
+            sched_yield();
+            continue;
+        }
+
+        uintptr_t producer = item >> SEQ_BITS;
+        uint64_t seq = item & ((1ULL << SEQ_BITS) - 1);
+
+        if (seq <= last[producer])
+            atomic_fetch_add(&s->errors, 1);
+
+        last[producer] = seq;
+        atomic_fetch_add(&s->sum, seq);
+        atomic_fetch_add(&s->consumed, 1);
+    }
+
+    return NULL;
+}
+
+int run_stress(uint64_t items, int producers, int consumers)
+{
+    struct stress s = { .q = create_lf_queue(), .items = items, .producers = producers };
+    struct worker w[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    int threads = producers + consumers;
+
+    for (int i = 0; i < threads; i++) {
+        w[i].shared = &s;
+        w[i].id = i < producers ? i : i - producers;
+        pthread_create(&tid[i], NULL, i < producers ? stress_producer : stress_consumer, &w[i]);
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+
+    uint64_t expected = producers * (items * (items + 1) / 2);
+    bool ok = s.errors == 0 && s.sum == expected && pop_lf_queue(s.q) == NULL;
+
+    printf("  %d producers %d consumers: %s\n", producers, consumers, ok ? "ok" : "FAILED");
+
+    free_lf_queue(s.q);
+    return ok;
+}
+
+/**
+ * Throughput
+ */
+void *run_lf(void *arg)
+{
+    struct bench *b = arg;
+
+    for (uint64_t i = 1; i <= b->ops; i++) {
+        add_lf_queue(b->lf, (void *)(uintptr_t)i);
+        while (pop_lf_queue(b->lf) == NULL)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+void *run_locked(void *arg)
+{
+    struct bench *b = arg;
+    void *data;
+
+    for (uint64_t i = 1; i <= b->ops; i++) {
+        pthread_mutex_lock(&b->lock);
+        add_queue(b->locked, (void *)(uintptr_t)i);
+        pthread_mutex_unlock(&b->lock);
+
+        do {
+            pthread_mutex_lock(&b->lock);
+            data = pop_queue(b->locked);
+            pthread_mutex_unlock(&b->lock);
+        } while (data == NULL);
+    }
+
+    return NULL;
+}
+
+double measure(struct bench *b, void *(*run)(void *), int threads)
+{
+    pthread_t tid[threads];
+    double start = now_seconds();
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, run, b);
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+
+    // one add and one pop per op
+    return 2.0 * b->ops * threads / (now_seconds() - start) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t items = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    int failed = 0;
+
+    if (max_threads > MAX_THREADS / 2)
+        max_threads = MAX_THREADS / 2;
+
+    printf("Stress, %lu items per producer\n", items);
+    for (int t = 1; t <= max_threads; t *= 2) {
+        failed += !run_stress(items, t, t);
+        failed += !run_stress(items, 1, t);
+    }
+
+    struct bench b = {
+        .lf = create_lf_queue(),
+        .locked = create_queue_pooled(),
+        .ops = items,
+    };
+
+    pthread_mutex_init(&b.lock, NULL);
+
+    printf("Throughput, %lu add/pop pairs per thread\n", items);
+    printf("%8s %16s %16s %8s\n", "threads", "mutex Mop/s", "lf Mop/s", "speedup");
+
+    for (int t = 1; t <= max_threads; t *= 2) {
+        double locked = measure(&b, run_locked, t);
+        double lf = measure(&b, run_lf, t);
+
+        printf("%8d %16.1f %16.1f %7.2fx\n", t, locked, lf, lf / locked);
+    }
+
+    pthread_mutex_destroy(&b.lock);
+    free_queue(b.locked);
+    free_lf_queue(b.lf);
+
+    exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,121 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+/**
+ * LOCK-FREE STACK BENCHMARK
+ *
+ * Every thread repeatedly pushes a few items and pops as many, lf_stack
+ * against a mutex guarded stack_t from 1 up to the given number of threads.
+ * A checksum over all popped items catches lost or duplicated items.
+ *
+ * usage: example_lfstack [operations per thread] [max threads]
+ */
+#define BURST 4
+
+struct bench {
+    lf_stack_t *lf;
+    stack_t *locked;
+    pthread_mutex_t lock;
+    uint64_t ops;
+    _Atomic uint64_t sum;
+};
+
+void *run_lf(void *arg)
+{
+    struct bench *b = arg;
+    uint64_t sum = 0;
+    void *data;
+
+    for (uint64_t i = 1; i <= b->ops; i += BURST) {
+        for (int j = 0; j < BURST; j++)
+            add_lf_stack(b->lf, (void *)(uintptr_t)(i + j));
+
+        for (int j = 0; j < BURST; j++) {
+            while ((data = pop_lf_stack(b->lf)) == NULL)
+                sched_yield();
+            sum += (uintptr_t)data;
+        }
+    }
+
+    atomic_fetch_add(&b->sum, sum);
+    return NULL;
+}
+
+void *run_locked(void *arg)
+{
+    struct bench *b = arg;
+    uint64_t sum = 0;
+    void *data;
+
+    for (uint64_t i = 1; i <= b->ops; i += BURST) {
+        for (int j = 0; j < BURST; j++) {
+            pthread_mutex_lock(&b->lock);
+            add_stack(b->locked, (void *)(uintptr_t)(i + j));
+            pthread_mutex_unlock(&b->lock);
+        }
+
+        for (int j = 0; j < BURST; j++) {
+            do {
+                pthread_mutex_lock(&b->lock);
+                data = pop_stack(b->locked);
+                pthread_mutex_unlock(&b->lock);
+            } while (data == NULL);
+            sum += (uintptr_t)data;
+        }
+    }
+
+    atomic_fetch_add(&b->sum, sum);
+    return NULL;
+}
+
+double measure(struct bench *b, void *(*run)(void *), int threads)
+{
+    pthread_t tid[threads];
+    uint64_t rounds = (b->ops + BURST - 1) / BURST * BURST;
+
+    atomic_store(&b->sum, 0);
+    double start = now_seconds();
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, run, b);
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+
+    double elapsed = now_seconds() - start;
+
+    if (b->sum != threads * (rounds * (rounds + 1) / 2))
+        printf("checksum mismatch\n");
+
+    // one push and one pop per op
+    return 2.0 * rounds * threads / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench b = {
+        .lf = create_lf_stack(),
+        .locked = create_stack_pooled(),
+        .ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 5000000,
+    };
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+
+    pthread_mutex_init(&b.lock, NULL);
+
+    printf("%8s %16s %16s %8s\n", "threads", "mutex Mop/s", "lf Mop/s", "speedup");
+
+    for (int t = 1; t <= max_threads; t *= 2) {
+        double locked = measure(&b, run_locked, t);
+        double lf = measure(&b, run_lf, t);
+
+        printf("%8d %16.1f %16.1f %7.2fx\n", t, locked, lf, lf / locked);
+    }
+
+    pthread_mutex_destroy(&b.lock);
+    free_stack(b.locked);
+    free_lf_stack(b.lf);
+
+    exit(EXIT_SUCCESS);
+}
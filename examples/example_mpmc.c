@@ -0,0 +1,98 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+/**
+ * MPMC QUEUE BENCHMARK
+ *
+ * Every thread repeatedly adds an item and pops one, so all threads act as
+ * producer and consumer at once. Compares mpmc_queue with a mutex guarded
+ * queue_t from 1 up to the given number of threads.
+ *
+ * usage: example_mpmc [operations per thread] [max threads]
+ */
+#define CAPACITY 4096
+
+struct bench {
+    mpmc_queue_t *mpmc;
+    queue_t *locked;
+    pthread_mutex_t lock;
+    uint64_t ops;
+};
+
+void *run_mpmc(void *arg)
+{
+    struct bench *b = arg;
+
+    for (uint64_t i = 1; i <= b->ops; i++) {
+        while (!try_add_mpmc_queue(b->mpmc, (void *)(uintptr_t)i))
+            sched_yield();
+        while (try_pop_mpmc_queue(b->mpmc) == NULL)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+void *run_locked(void *arg)
+{
+    struct bench *b = arg;
+    void *data;
+
+    for (uint64_t i = 1; i <= b->ops; i++) {
+        pthread_mutex_lock(&b->lock);
+        add_queue(b->locked, (void *)(uintptr_t)i);
+        pthread_mutex_unlock(&b->lock);
+
+        do {
+            pthread_mutex_lock(&b->lock);
+            data = pop_queue(b->locked);
+            pthread_mutex_unlock(&b->lock);
+        } while (data == NULL);
+    }
+
+    return NULL;
+}
+
+double measure(struct bench *b, void *(*run)(void *), int threads)
+{
+    pthread_t tid[threads];
+    double start = now_seconds();
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, run, b);
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+
+    // one add and one pop per op
+    return 2.0 * b->ops * threads / (now_seconds() - start) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench b = {
+        .mpmc = create_mpmc_queue(CAPACITY),
+        .locked = create_queue_ring(CAPACITY),
+        .ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 5000000,
+    };
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+
+    pthread_mutex_init(&b.lock, NULL);
+
+    printf("%8s %16s %16s %8s\n", "threads", "mutex Mop/s", "mpmc Mop/s", "speedup");
+
+    for (int t = 1; t <= max_threads; t *= 2) {
+        double locked = measure(&b, run_locked, t);
+        double mpmc = measure(&b, run_mpmc, t);
+
+        printf("%8d %16.1f %16.1f %7.2fx\n", t, locked, mpmc, mpmc / locked);
+    }
+
+    pthread_mutex_destroy(&b.lock);
+    free_queue(b.locked);
+    free_mpmc_queue(b.mpmc);
+
+    exit(EXIT_SUCCESS);
+}
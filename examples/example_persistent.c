@@ -0,0 +1,179 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * PERSISTENT BINARYTREE BENCHMARK
+ *
+ * Reader threads look up random int64_t values while one writer thread keeps
+ * adding and deleting random values, for a fixed time. Runs on a red-black
+ * set behind a pthread_rwlock_t and on a pbinarytree, where readers never
+ * lock and the writer copies paths. Readers of the pbinarytree hold one
+ * version for READ_BATCH lookups. Reports the lookups and the updates per
+ * second.
+ *
+ * usage: example_persistent [number of items] [reader threads] [seconds]
+ */
+#define MAX_THREADS 64
+#define READ_BATCH 64
+
+struct bench {
+    set_t *set;
+    pthread_rwlock_t lock;
+    pbinarytree_t *tree;
+    int64_t *values;
+    uint64_t n;
+    _Atomic bool stop;
+};
+
+struct worker {
+    struct bench *b;
+    uint64_t seed;
+    uint64_t ops;
+    uint64_t found;
+};
+
+void *read_locked(void *arg)
+{
+    struct worker *w = arg;
+    struct bench *b = w->b;
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        int64_t *value = &b->values[next_random(&w->seed) % (2 * b->n)];
+
+        pthread_rwlock_rdlock(&b->lock);
+        w->found += contains_set(b->set, value);
+        pthread_rwlock_unlock(&b->lock);
+        w->ops++;
+    }
+
+    return NULL;
+}
+
+void *write_locked(void *arg)
+{
+    struct worker *w = arg;
+    struct bench *b = w->b;
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        uint64_t r = next_random(&w->seed);
+        int64_t *value = &b->values[r % (2 * b->n)];
+
+        pthread_rwlock_wrlock(&b->lock);
+        if (r >> 63) add_set(b->set, value);
+        else del_set(b->set, value);
+        pthread_rwlock_unlock(&b->lock);
+        w->ops++;
+    }
+
+    return NULL;
+}
+
+void *read_persistent(void *arg)
+{
+    struct worker *w = arg;
+    struct bench *b = w->b;
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        const pb_node_t *version = acquire_pbinarytree(b->tree);
+
+        for (int i = 0; i < READ_BATCH; i++) {
+            int64_t *value = &b->values[next_random(&w->seed) % (2 * b->n)];
+            w->found += find_pbinarytree(b->tree, version, value) != NULL;
+        }
+
+        release_pbinarytree(b->tree);
+        w->ops += READ_BATCH;
+    }
+
+    return NULL;
+}
+
+void *write_persistent(void *arg)
+{
+    struct worker *w = arg;
+    struct bench *b = w->b;
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        uint64_t r = next_random(&w->seed);
+        int64_t *value = &b->values[r % (2 * b->n)];
+
+        if (r >> 63) add_pbinarytree(b->tree, value);
+        else del_pbinarytree(b->tree, value);
+        w->ops++;
+    }
+
+    return NULL;
+}
+
+void run(const char *name, struct bench *b, int readers, double seconds,
+        void *(*read)(void *), void *(*write)(void *))
+{
+    pthread_t tid[MAX_THREADS + 1];
+    struct worker w[MAX_THREADS + 1];
+    struct timespec duration = {
+        .tv_sec = (time_t)seconds,
+        .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9)
+    };
+
+    atomic_store(&b->stop, false);
+
+    for (int i = 0; i <= readers; i++) {
+        w[i] = (struct worker) { .b = b, .seed = 88172645463325252ULL + i * 7919 };
+        pthread_create(&tid[i], NULL, i < readers ? read : write, &w[i]);
+    }
+
+    nanosleep(&duration, NULL);
+    atomic_store(&b->stop, true);
+
+    uint64_t lookups = 0;
+    for (int i = 0; i <= readers; i++) {
+        pthread_join(tid[i], NULL);
+        if (i < readers) lookups += w[i].ops;
+    }
+
+    printf("%-16s %8d %14.3f %14.1f\n", name, readers,
+            lookups / seconds / 1e6, w[readers].ops / seconds / 1e3);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int max_readers = argc > 2 ? atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? atof(argv[3]) : 1.0;
+    struct bench b = { .n = n };
+    uint64_t state = 88172645463325252ULL;
+
+    if (max_readers > MAX_THREADS)
+        max_readers = MAX_THREADS;
+
+    // half of the values start out in the trees
+    b.values = malloc(sizeof(*b.values) * 2 * n);
+    for (uint64_t i = 0; i < 2 * n; i++)
+        b.values[i] = (int64_t)next_random(&state);
+
+    b.set = create_set_int();
+    b.set->tree->mode = BINARYTREE_REDBLACK;
+    b.tree = create_pbinarytree(BINARYTREE_KEY_INT64, NULL, NULL);
+    pthread_rwlock_init(&b.lock, NULL);
+
+    for (uint64_t i = 0; i < n; i++) {
+        add_set(b.set, &b.values[i]);
+        add_pbinarytree(b.tree, &b.values[i]);
+    }
+
+    printf("%-16s %8s %14s %14s\n", "tree", "readers", "Mlookups/s", "kupdates/s");
+
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        run("rwlock set", &b, readers, seconds, read_locked, write_locked);
+        run("pbinarytree", &b, readers, seconds, read_persistent, write_persistent);
+    }
+
+    pthread_rwlock_destroy(&b.lock);
+    free_pbinarytree(b.tree);
+    free_set(b.set);
+    free(b.values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,138 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * NODE POOL BENCHMARK
+ *
+ * Push/pop throughput of stack, queue, deque and binarytree with malloc'd
+ * nodes against nodes from the shared node pools. Every thread works on its
+ * own container, so the multi-threaded runs show allocator contention.
+ *
+ * usage: example_pool [operations per thread] [max threads]
+ */
+#define BATCH 1000
+
+struct bench {
+    const char *name;
+    void (*run)(uint64_t ops, bool pooled);
+};
+
+struct worker {
+    struct bench *bench;
+    uint64_t ops;
+    bool pooled;
+};
+
+void run_stack(uint64_t ops, bool pooled)
+{
+    stack_t *s = pooled ? create_stack_pooled() : create_stack();
+
+    for (uint64_t i = 0; i < ops; i += BATCH) {
+        for (int j = 0; j < BATCH; j++)
+            add_stack(s, s);
+        for (int j = 0; j < BATCH; j++)
+            pop_stack(s);
+    }
+
+    free_stack(s);
+}
+
+void run_queue(uint64_t ops, bool pooled)
+{
+    queue_t *q = pooled ? create_queue_pooled() : create_queue();
+
+    for (uint64_t i = 0; i < ops; i += BATCH) {
+        for (int j = 0; j < BATCH; j++)
+            add_queue(q, q);
+        for (int j = 0; j < BATCH; j++)
+            pop_queue(q);
+    }
+
+    free_queue(q);
+}
+
+void run_deque(uint64_t ops, bool pooled)
+{
+    deque_t *dq = pooled ? create_deque_pooled() : create_deque();
+
+    for (uint64_t i = 0; i < ops; i += BATCH) {
+        for (int j = 0; j < BATCH; j++)
+            add_last_deque(dq, dq);
+        for (int j = 0; j < BATCH; j++)
+            pop_first_deque(dq);
+    }
+
+    free_deque(dq);
+}
+
+void run_binarytree(uint64_t ops, bool pooled)
+{
+    // keys are addresses, so insert distinct offsets into a dummy buffer
+    char *keys = malloc(BATCH);
+    uint64_t state = 88172645463325252ULL;
+
+    for (uint64_t i = 0; i < ops; i += BATCH) {
+        binarytree_t *t = pooled ? create_binarytree_pooled() : create_binarytree();
+
+        for (int j = 0; j < BATCH; j++) {
+            next_random(&state);
+            add_binarytree(t, keys + state % BATCH);
+        }
+
+        free_binarytree(t);
+    }
+
+    free(keys);
+}
+
+void *run_worker(void *arg)
+{
+    struct worker *w = arg;
+    w->bench->run(w->ops, w->pooled);
+    return NULL;
+}
+
+double measure(struct bench *b, uint64_t ops, int threads, bool pooled)
+{
+    pthread_t tid[threads];
+    struct worker w = { .bench = b, .ops = ops, .pooled = pooled };
+
+    double start = now_seconds();
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, run_worker, &w);
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+
+    // one push and one pop per op
+    return 2.0 * ops * threads / (now_seconds() - start) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    struct bench benches[] = {
+        { "stack", run_stack },
+        { "queue", run_queue },
+        { "deque", run_deque },
+        { "binarytree", run_binarytree },
+    };
+
+    printf("%-12s %8s %14s %14s %8s\n", "structure", "threads",
+            "malloc Mop/s", "pooled Mop/s", "speedup");
+
+    for (int i = 0; i < sizeof(benches) / sizeof(*benches); i++)
+        for (int t = 1; t <= max_threads; t *= 2) {
+            double plain = measure(&benches[i], ops, t, false);
+            double pooled = measure(&benches[i], ops, t, true);
+
+            printf("%-12s %8d %14.1f %14.1f %7.2fx\n", benches[i].name, t,
+                    plain, pooled, pooled / plain);
+        }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,94 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * ORDER STATISTICS BENCHMARK
+ *
+ * Indexes random int64_t values in a red-black binarytree and answers
+ * percentile and range count queries with select_binarytree and
+ * count_range_binarytree. The range counts are checked against, and timed
+ * against, a walk over the whole tree as needed without subtree sizes.
+ *
+ * usage: example_rank [number of items] [number of queries]
+ */
+
+uint64_t walk_range(dlp_node_t *const n, int64_t low, int64_t high)
+{
+    if (n == NULL) return 0;
+
+    int64_t value = *(int64_t *)n->data;
+
+    return walk_range(n->prev, low, high) + walk_range(n->next, low, high)
+        + (value >= low && value < high);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t queries = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    uint64_t walks = queries < 20 ? queries : 20;
+    int64_t *values = malloc(sizeof(*values) * n);
+    int64_t *bounds = malloc(sizeof(*bounds) * 2 * queries);
+    uint64_t state = 88172645463325252ULL;
+    uint64_t sum = 0;
+    double start;
+
+    for (uint64_t i = 0; i < n + 2 * queries; i++) {
+        next_random(&state);
+
+        if (i < n) values[i] = (int64_t)state;
+        else bounds[i - n] = (int64_t)state;
+    }
+
+    binarytree_t *t = create_binarytree_arena();
+    t->key_type = BINARYTREE_KEY_INT64;
+    t->mode = BINARYTREE_REDBLACK;
+
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(t, &values[i]);
+
+    printf("%lu items, percentiles:", count_binarytree(t));
+    for (int p = 0; p <= 100; p += 25) {
+        uint64_t k = p < 100 ? count_binarytree(t) * p / 100 : count_binarytree(t) - 1;
+        printf(" p%d=%ld", p, *(int64_t *)select_binarytree(t, k));
+    }
+    printf("\n");
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < queries; i++)
+        sum += *(int64_t *)select_binarytree(t, (uint64_t)bounds[i] % n);
+    printf("select         %10.3f us/query\n", (now_seconds() - start) / queries * 1e6);
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < queries; i++) {
+        int64_t *low = &bounds[2 * i], *high = &bounds[2 * i + 1];
+        sum += count_range_binarytree(t, *low < *high ? low : high, *low < *high ? high : low);
+    }
+    printf("count_range    %10.3f us/query\n", (now_seconds() - start) / queries * 1e6);
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < walks; i++) {
+        int64_t low = bounds[2 * i], high = bounds[2 * i + 1];
+
+        if (low > high) {
+            int64_t swap = low;
+            low = high;
+            high = swap;
+        }
+
+        if (walk_range(t->root, low, high) != count_range_binarytree(t, &low, &high))
+            printf("range count mismatch\n");
+    }
+    printf("tree walk      %10.3f us/query\n", (now_seconds() - start) / walks * 1e6);
+
+    // keeps the queries from being optimized away
+    printf("checksum %lu\n", sum);
+
+    free_binarytree(t);
+    free(bounds);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,114 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * RED-BLACK BINARYTREE BENCHMARK
+ *
+ * Inserts keys in sorted, reverse and random order into a plain and a
+ * red-black binarytree, looks all of them up and deletes them in the same
+ * order. Reports the time of every phase and the height of the full tree.
+ * A plain tree degenerates into a list on sorted input, so those runs are
+ * capped at PLAIN_LIMIT keys.
+ *
+ * usage: example_redblack [number of keys]
+ */
+#define PLAIN_LIMIT 20000
+
+enum order { SORTED, REVERSE, RANDOM };
+
+static const char *order_names[] = { "sorted", "reverse", "random" };
+
+/**
+ * Bijection on [0, mask], walked until it lands inside [0, n) so random
+ * order needs no permutation array
+ */
+uint64_t permute(uint64_t i, uint64_t n, uint64_t mask)
+{
+    do {
+        i = (i * 0x9e3779b97f4a7c15ULL) & mask;
+        i ^= i >> 17;
+        i = (i * 0xbf58476d1ce4e5b9ULL) & mask;
+        i ^= i >> 11;
+    } while (i >= n);
+
+    return i;
+}
+
+uint64_t key_index(enum order order, uint64_t i, uint64_t n, uint64_t mask)
+{
+    switch (order) {
+        case SORTED:  return i;
+        case REVERSE: return n - 1 - i;
+        default:      return permute(i, n, mask);
+    }
+}
+
+uint32_t height(dlp_node_t *const n)
+{
+    if (n == NULL) return 0;
+
+    uint32_t prev = height(n->prev);
+    uint32_t next = height(n->next);
+
+    return 1 + (prev > next ? prev : next);
+}
+
+void run(char *keys, uint64_t n, enum order order, uint8_t mode)
+{
+    binarytree_t *t = create_binarytree_arena();
+    uint64_t mask = 1;
+
+    while (mask < n)
+        mask = mask << 1 | 1;
+
+    t->mode = mode;
+
+    double start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(t, keys + key_index(order, i, n, mask));
+    double insert = now_seconds() - start;
+
+    uint32_t h = height(t->root);
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        if (find_binarytree(t->root, keys + key_index(order, i, n, mask)) == NULL)
+            printf("key not found\n");
+    double find = now_seconds() - start;
+
+    start = now_seconds();
+    for (uint64_t i = 0; i < n; i++)
+        del_binarytree(t, keys + key_index(order, i, n, mask));
+    double delete = now_seconds() - start;
+
+    printf("%-8s %-9s %10lu %10.3f %10.3f %10.3f %8u\n", order_names[order],
+            mode == BINARYTREE_REDBLACK ? "redblack" : "plain", n, insert, find,
+            delete, h);
+
+    free_binarytree(t);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    char *keys = malloc(n);
+
+    // the tree orders by address, so every byte of keys is one key
+    memset(keys, 0, n);
+
+    printf("%-8s %-9s %10s %10s %10s %10s %8s\n", "order", "mode", "keys",
+            "insert s", "find s", "delete s", "height");
+
+    for (enum order o = SORTED; o <= RANDOM; o++) {
+        uint64_t plain = o == RANDOM || n < PLAIN_LIMIT ? n : PLAIN_LIMIT;
+
+        run(keys, plain, o, BINARYTREE_PLAIN);
+        run(keys, n, o, BINARYTREE_REDBLACK);
+    }
+
+    free(keys);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,99 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * BINARYTREE SCAN BENCHMARK
+ *
+ * Exports a red-black binarytree of random int64_t values in order, once by
+ * a recursive walk and once by scan_binarytree following parent links, then
+ * reads pages of PAGE_SIZE items starting at random values. The same pages
+ * are read from a btree set through scan_set.
+ *
+ * usage: example_scan [number of items] [number of pages]
+ */
+#define PAGE_SIZE 100
+
+struct export {
+    int64_t sum;
+    uint64_t count;
+    uint64_t limit;
+};
+
+bool export_item(void *data, void *arg)
+{
+    struct export *e = arg;
+
+    e->sum += *(int64_t *)data;
+    return ++e->count < e->limit;
+}
+
+void walk(dlp_node_t *const n, struct export *e)
+{
+    if (n == NULL) return;
+
+    walk(n->prev, e);
+    export_item(n->data, e);
+    walk(n->next, e);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t pages = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    int64_t *values = malloc(sizeof(*values) * (n + pages));
+    void **items = malloc(sizeof(*items) * n);
+    uint64_t state = 88172645463325252ULL;
+    double start;
+
+    for (uint64_t i = 0; i < n + pages; i++) {
+        next_random(&state);
+
+        values[i] = (int64_t)state;
+        if (i < n) items[i] = &values[i];
+    }
+
+    set_t *s = create_set_int();
+    set_t *b = create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL);
+    s->tree->mode = BINARYTREE_REDBLACK;
+
+    for (uint64_t i = 0; i < n; i++)
+        add_set(s, items[i]);
+    build_set_from_array(b, items, n);
+
+    struct export walked = { .limit = UINT64_MAX };
+    start = now_seconds();
+    walk(s->tree->root, &walked);
+    printf("recursive export   %10.3f s\n", now_seconds() - start);
+
+    struct export scanned = { .limit = UINT64_MAX };
+    start = now_seconds();
+    scan_binarytree(s->tree, NULL, NULL, export_item, &scanned);
+    printf("scan export        %10.3f s\n", now_seconds() - start);
+
+    if (walked.sum != scanned.sum || walked.count != scanned.count)
+        printf("export mismatch\n");
+
+    set_t *sets[] = { s, b };
+    const char *names[] = { "redblack pages", "btree pages" };
+
+    for (int i = 0; i < 2; i++) {
+        struct export paged = { 0 };
+
+        start = now_seconds();
+        for (uint64_t p = 0; p < pages; p++) {
+            paged.limit = paged.count + PAGE_SIZE;
+            scan_set(sets[i], &values[n + p], NULL, export_item, &paged);
+        }
+        printf("%-18s %10.3f us/page, %lu items\n", names[i],
+                (now_seconds() - start) / pages * 1e6, paged.count);
+    }
+
+    free_set(b);
+    free_set(s);
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
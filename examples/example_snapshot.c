@@ -0,0 +1,122 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+
+/**
+ * SET SNAPSHOT BENCHMARK
+ *
+ * Builds a red-black set and a btree set over random int64_t values and
+ * freezes the first one into a snapshot. Probes, half of them present, are
+ * looked up in the sets, one by one in the snapshot and batched in the
+ * snapshot. The batched lookups are then repeated by several reader threads
+ * sharing the snapshot.
+ *
+ * usage: example_snapshot [number of items] [reader threads]
+ */
+#define MAX_THREADS 64
+
+struct reader {
+    set_snapshot_t *snapshot;
+    void **probes;
+    uint64_t n;
+    uint64_t found;
+};
+
+void report(const char *name, double seconds, uint64_t n, uint64_t found)
+{
+    printf("%-22s %12.2f %10lu\n", name, n / seconds / 1e6, found);
+}
+
+void *run_reader(void *arg)
+{
+    struct reader *r = arg;
+    r->found = contains_many_snapshot(r->snapshot, r->probes, r->n, NULL);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    int64_t *values = malloc(sizeof(*values) * 2 * n);
+    void **items = malloc(sizeof(*items) * n);
+    void **probes = malloc(sizeof(*probes) * n);
+    uint64_t state = 88172645463325252ULL;
+    uint64_t found;
+    double start;
+
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    // values past n are probes likely not in the set
+    for (uint64_t i = 0; i < 2 * n; i++) {
+        next_random(&state);
+        values[i] = (int64_t)state;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        items[i] = &values[i];
+        probes[i] = &values[(i * 0x9e3779b97f4a7c15ULL >> 16) % (2 * n)];
+    }
+
+    set_t *tree = create_set_int();
+    set_t *btree = create_set_btree(BINARYTREE_KEY_INT64, NULL, NULL);
+    tree->tree->mode = BINARYTREE_REDBLACK;
+    build_set_from_array(tree, items, n);
+    build_set_from_array(btree, items, n);
+
+    start = now_seconds();
+    set_snapshot_t *snapshot = freeze_set(tree);
+    printf("Froze %lu items in %.3f seconds\n", count_snapshot(snapshot),
+            now_seconds() - start);
+    printf("%-22s %12s %10s\n", "lookup", "Mlookups/s", "found");
+
+    start = now_seconds();
+    found = 0;
+    for (uint64_t i = 0; i < n; i++)
+        found += contains_set(tree, probes[i]);
+    report("redblack set", now_seconds() - start, n, found);
+
+    start = now_seconds();
+    found = 0;
+    for (uint64_t i = 0; i < n; i++)
+        found += contains_set(btree, probes[i]);
+    report("btree set", now_seconds() - start, n, found);
+
+    start = now_seconds();
+    found = 0;
+    for (uint64_t i = 0; i < n; i++)
+        found += contains_snapshot(snapshot, probes[i]);
+    report("snapshot", now_seconds() - start, n, found);
+
+    start = now_seconds();
+    found = contains_many_snapshot(snapshot, probes, n, NULL);
+    report("snapshot batched", now_seconds() - start, n, found);
+
+    pthread_t tid[MAX_THREADS];
+    struct reader r[MAX_THREADS];
+
+    start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        r[i] = (struct reader) { .snapshot = snapshot, .probes = probes, .n = n };
+        pthread_create(&tid[i], NULL, run_reader, &r[i]);
+    }
+    found = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+        found += r[i].found;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "batched, %d readers", threads);
+    report(name, now_seconds() - start, n * threads, found);
+
+    free_snapshot(snapshot);
+    free_set(btree);
+    free_set(tree);
+    free(probes);
+    free(items);
+    free(values);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,95 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * SPLAY BINARYTREE BENCHMARK
+ *
+ * Looks up int64_t keys drawn from a Zipf distribution, the key of rank r
+ * being drawn in proportion to 1 / r^s, in a plain, a red-black and a splay
+ * binarytree. Keys are added in random order and ranks are assigned to keys
+ * at random, so hot keys are spread over the whole tree. Reports the share
+ * of lookups going to the hottest 1% of keys and the lookup time per tree.
+ *
+ * usage: example_splay [number of keys] [number of lookups] [exponent s]
+ */
+
+void run(const char *name, uint8_t mode, int64_t *keys, uint64_t n,
+        uint32_t *lookups, uint64_t m)
+{
+    binarytree_t *t = create_binarytree_arena();
+    t->key_type = BINARYTREE_KEY_INT64;
+    t->mode = mode;
+
+    for (uint64_t i = 0; i < n; i++)
+        add_binarytree(t, &keys[i]);
+
+    double start = now_seconds();
+    for (uint64_t i = 0; i < m; i++)
+        if (search_binarytree(t, &keys[lookups[i]]) == NULL)
+            printf("key not found\n");
+
+    printf("%-10s %12.1f ns/lookup\n", name, (now_seconds() - start) / m * 1e9);
+
+    free_binarytree(t);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t m = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000000;
+    double s = argc > 3 ? atof(argv[3]) : 1.1;
+    int64_t *keys = malloc(sizeof(*keys) * n);
+    uint64_t *ranked = malloc(sizeof(*ranked) * n);
+    double *cdf = malloc(sizeof(*cdf) * n);
+    uint32_t *lookups = malloc(sizeof(*lookups) * m);
+    uint64_t state = 88172645463325252ULL;
+    uint64_t hot = 0;
+    double sum = 0;
+
+    for (uint64_t i = 0; i < n; i++) {
+        keys[i] = (int64_t)next_random(&state);
+        ranked[i] = i;
+        sum += 1.0 / pow(i + 1, s);
+        cdf[i] = sum;
+    }
+
+    // key of every rank at random
+    for (uint64_t i = n - 1; i > 0; i--) {
+        uint64_t j = next_random(&state) % (i + 1);
+        uint64_t swap = ranked[i];
+        ranked[i] = ranked[j];
+        ranked[j] = swap;
+    }
+
+    for (uint64_t i = 0; i < m; i++) {
+        double u = (next_random(&state) >> 11) * 0x1p-53 * sum;
+        uint64_t low = 0, high = n - 1;
+
+        while (low < high) {
+            uint64_t mid = (low + high) / 2;
+
+            if (cdf[mid] < u) low = mid + 1;
+            else high = mid;
+        }
+
+        hot += low < n / 100;
+        lookups[i] = ranked[low];
+    }
+
+    printf("%lu keys, %lu lookups, s = %.2f, %.1f%% to the hottest 1%% of keys\n",
+            n, m, s, 100.0 * hot / m);
+
+    run("plain", BINARYTREE_PLAIN, keys, n, lookups, m);
+    run("redblack", BINARYTREE_REDBLACK, keys, n, lookups, m);
+    run("splay", BINARYTREE_SPLAY, keys, n, lookups, m);
+
+    free(lookups);
+    free(cdf);
+    free(ranked);
+    free(keys);
+
+    exit(EXIT_SUCCESS);
+}
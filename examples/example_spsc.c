@@ -0,0 +1,256 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+/**
+ * SPSC QUEUE BENCHMARK
+ *
+ * Throughput of handing items from a producer thread to a consumer thread
+ * through a spsc_queue (single and batched) and through a mutex guarded
+ * queue_t, followed by round trip latency of a ping-pong between two threads.
+ *
+ * usage: example_spsc [items] [round trips]
+ */
+#define CAPACITY 1024
+#define BATCH 64
+
+struct locked_queue {
+    queue_t *q;
+    pthread_mutex_t lock;
+};
+
+struct channel {
+    spsc_queue_t *spsc[2];
+    struct locked_queue locked[2];
+    uint64_t items;
+    bool batched;
+};
+
+void backoff(uint32_t *spins)
+{
+    // spinning only helps while the other side runs on another core
+    if (++*spins > 64) {
+        sched_yield();
+        *spins = 0;
+    }
+}
+
+int8_t add_locked(struct locked_queue *lq, void *data)
+{
+    pthread_mutex_lock(&lq->lock);
+    bool full = count_queue(lq->q) >= CAPACITY;
+    if (!full) add_queue(lq->q, data);
+    pthread_mutex_unlock(&lq->lock);
+    return !full;
+}
+
+void *pop_locked(struct locked_queue *lq)
+{
+    pthread_mutex_lock(&lq->lock);
+    void *data = pop_queue(lq->q);
+    pthread_mutex_unlock(&lq->lock);
+    return data;
+}
+
+/**
+ * Throughput
+ */
+void *spsc_producer(void *arg)
+{
+    struct channel *c = arg;
+    void *items[BATCH];
+    uint32_t spins = 0;
+
+    for (uint64_t i = 1; i <= c->items;) {
+        if (c->batched) {
+            uint32_t n = 0;
+            while (n < BATCH && i + n <= c->items) {
+                items[n] = (void *)(uintptr_t)(i + n);
+                n++;
+            }
+
+            uint32_t added = 0;
+            while (added < n) {
+                uint32_t k = add_many_spsc_queue(c->spsc[0], items + added, n - added);
+                if (k == 0) backoff(&spins);
+                added += k;
+            }
+            i += n;
+        }
+        else if (add_spsc_queue(c->spsc[0], (void *)(uintptr_t)i))
+            i++;
+        else
+            backoff(&spins);
+    }
+
+    return NULL;
+}
+
+void *spsc_consumer(void *arg)
+{
+    struct channel *c = arg;
+    void *items[BATCH];
+    uint64_t seen = 0, sum = 0;
+    uint32_t spins = 0;
+
+    while (seen < c->items) {
+        if (c->batched) {
+            uint32_t n = pop_many_spsc_queue(c->spsc[0], items, BATCH);
+            if (n == 0) backoff(&spins);
+            for (uint32_t k = 0; k < n; k++)
+                sum += (uintptr_t)items[k];
+            seen += n;
+        }
+        else {
+            void *data = pop_spsc_queue(c->spsc[0]);
+            if (data == NULL) backoff(&spins);
+            else {
+                sum += (uintptr_t)data;
+                seen++;
+            }
+        }
+    }
+
+    if (sum != c->items * (c->items + 1) / 2)
+        printf("checksum mismatch\n");
+
+    return NULL;
+}
+
+void *locked_producer(void *arg)
+{
+    struct channel *c = arg;
+    uint32_t spins = 0;
+
+    for (uint64_t i = 1; i <= c->items;) {
+        if (add_locked(&c->locked[0], (void *)(uintptr_t)i)) i++;
+        else backoff(&spins);
+    }
+
+    return NULL;
+}
+
+void *locked_consumer(void *arg)
+{
+    struct channel *c = arg;
+    uint64_t seen = 0;
+    uint32_t spins = 0;
+
+    while (seen < c->items) {
+        if (pop_locked(&c->locked[0]) != NULL) seen++;
+        else backoff(&spins);
+    }
+
+    return NULL;
+}
+
+double measure_throughput(struct channel *c, void *(*producer)(void *),
+        void *(*consumer)(void *))
+{
+    pthread_t p, q;
+    double start = now_seconds();
+
+    pthread_create(&q, NULL, consumer, c);
+    pthread_create(&p, NULL, producer, c);
+    pthread_join(p, NULL);
+    pthread_join(q, NULL);
+
+    return c->items / (now_seconds() - start) / 1e6;
+}
+
+/**
+ * Latency, the echo thread sends every item straight back
+ */
+void *spsc_echo(void *arg)
+{
+    struct channel *c = arg;
+    uint32_t spins = 0;
+
+    for (uint64_t i = 0; i < c->items; i++) {
+        void *data;
+        while ((data = pop_spsc_queue(c->spsc[0])) == NULL) backoff(&spins);
+        while (!add_spsc_queue(c->spsc[1], data)) backoff(&spins);
+    }
+
+    return NULL;
+}
+
+void *locked_echo(void *arg)
+{
+    struct channel *c = arg;
+    uint32_t spins = 0;
+
+    for (uint64_t i = 0; i < c->items; i++) {
+        void *data;
+        while ((data = pop_locked(&c->locked[0])) == NULL) backoff(&spins);
+        while (!add_locked(&c->locked[1], data)) backoff(&spins);
+    }
+
+    return NULL;
+}
+
+double measure_latency(struct channel *c, bool locked)
+{
+    pthread_t echo;
+    uint32_t spins = 0;
+
+    pthread_create(&echo, NULL, locked ? locked_echo : spsc_echo, c);
+
+    double start = now_seconds();
+
+    for (uint64_t i = 1; i <= c->items; i++) {
+        void *data = (void *)(uintptr_t)i;
+
+        if (locked) {
+            while (!add_locked(&c->locked[0], data)) backoff(&spins);
+            while (pop_locked(&c->locked[1]) == NULL) backoff(&spins);
+        }
+        else {
+            while (!add_spsc_queue(c->spsc[0], data)) backoff(&spins);
+            while (pop_spsc_queue(c->spsc[1]) == NULL) backoff(&spins);
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+    pthread_join(echo, NULL);
+
+    return elapsed / c->items * 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    struct channel c = {};
+
+    for (int i = 0; i < 2; i++) {
+        c.spsc[i] = create_spsc_queue(CAPACITY);
+        c.locked[i].q = create_queue_ring(CAPACITY);
+        pthread_mutex_init(&c.locked[i].lock, NULL);
+    }
+
+    c.items = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+
+    printf("Throughput, %lu items\n", c.items);
+    printf("  mutex queue_t  %8.1f Mitems/s\n",
+            measure_throughput(&c, locked_producer, locked_consumer));
+    printf("  spsc_queue     %8.1f Mitems/s\n",
+            measure_throughput(&c, spsc_producer, spsc_consumer));
+    c.batched = true;
+    printf("  spsc_queue x%d %8.1f Mitems/s\n", BATCH,
+            measure_throughput(&c, spsc_producer, spsc_consumer));
+
+    c.items = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+
+    printf("Round trip latency, %lu round trips\n", c.items);
+    printf("  mutex queue_t  %8.0f ns\n", measure_latency(&c, true));
+    printf("  spsc_queue     %8.0f ns\n", measure_latency(&c, false));
+
+    for (int i = 0; i < 2; i++) {
+        free_spsc_queue(c.spsc[i]);
+        free_queue(c.locked[i].q);
+        pthread_mutex_destroy(&c.locked[i].lock);
+    }
+
+    exit(EXIT_SUCCESS);
+}
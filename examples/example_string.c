@@ -66,7 +66,7 @@ int main(int argc, char *argv[])
     printf("\n");
 
     parse_data_t *pd = malloc(sizeof(*pd));
-    pd->open = create_stack();
+    pd->open = create_stack_vector(16);
     pd->order = create_queue();
 
     map_dlnode_data_seq(dq->first, handle_nested_parent, pd, 0);
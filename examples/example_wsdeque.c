@@ -0,0 +1,211 @@
+#include "datastructs.h"
+#include "profile_time.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+/**
+ * WORK-STEALING TASK TREE BENCHMARK
+ *
+ * A task of depth d forks a task of depth d - 1 and runs another one of
+ * depth d - 1 itself, leaves do a bit of busy work. Workers keep their tasks
+ * in their own ws_deque and steal from a random victim when it runs dry.
+ * The same tree runs on a single mutex guarded deque_t all workers share,
+ * and recursively on one thread as baseline. A checksum over all leaves
+ * catches lost or duplicated tasks.
+ *
+ * usage: example_wsdeque [tree depth] [max threads]
+ */
+#define MAX_THREADS 64
+#define LEAF_WORK 200
+
+struct pool {
+    ws_deque_t *deques[MAX_THREADS];
+    deque_t *shared;
+    pthread_mutex_t lock;
+    int threads;
+    uint64_t leaves;
+    _Atomic uint64_t done;
+    _Atomic uint64_t sum;
+};
+
+struct worker {
+    struct pool *pool;
+    int id;
+};
+
+uint64_t leaf(uint64_t seed)
+{
+    for (int i = 0; i < LEAF_WORK; i++)
+        next_random(&seed);
+
+    return seed;
+}
+
+uint64_t run_recursive(uintptr_t depth)
+{
+    if (depth == 0)
+        return leaf(depth + 1);
+
+    return run_recursive(depth - 1) + run_recursive(depth - 1);
+}
+
+/**
+ * Work stealing
+ */
+void *run_stealing(void *arg)
+{
+    struct worker *w = arg;
+    struct pool *p = w->pool;
+    ws_deque_t *own = p->deques[w->id];
+    uint32_t seed = w->id * 2654435761u | 1;
+    uint64_t done = 0, sum = 0;
+    void *task;
+
+    while (1) {
+        // tasks carry their depth + 1, so they are never NULL
+        while ((task = pop_last_ws_deque(own)) != NULL) {
+            uintptr_t depth = (uintptr_t)task - 1;
+
+            for (; depth > 0; depth--)
+                add_last_ws_deque(own, (void *)depth);
+
+            sum += leaf(depth + 1);
+            done++;
+        }
+
+        if (done > 0) {
+            atomic_fetch_add(&p->done, done);
+            done = 0;
+        }
+
+        if (atomic_load(&p->done) >= p->leaves)
+            break;
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        int victim = seed % p->threads;
+
+        if (victim == w->id ||
+                (task = steal_first_ws_deque(p->deques[victim])) == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        add_last_ws_deque(own, task);
+    }
+
+    atomic_fetch_add(&p->sum, sum);
+    return NULL;
+}
+
+/**
+ * Shared deque
+ */
+void *run_shared(void *arg)
+{
+    struct worker *w = arg;
+    struct pool *p = w->pool;
+    uint64_t sum = 0;
+    void *task;
+
+    while (1) {
+        pthread_mutex_lock(&p->lock);
+        task = pop_last_deque(p->shared);
+        pthread_mutex_unlock(&p->lock);
+
+        if (task == NULL) {
+            if (atomic_load(&p->done) >= p->leaves)
+                break;
+
+            sched_yield();
+            continue;
+        }
+
+        uintptr_t depth = (uintptr_t)task - 1;
+
+        for (; depth > 0; depth--) {
+            pthread_mutex_lock(&p->lock);
+            add_last_deque(p->shared, (void *)depth);
+            pthread_mutex_unlock(&p->lock);
+        }
+
+        sum += leaf(depth + 1);
+        atomic_fetch_add(&p->done, 1);
+    }
+
+    atomic_fetch_add(&p->sum, sum);
+    return NULL;
+}
+
+double measure(struct pool *p, void *(*run)(void *), uintptr_t depth, uint64_t expected)
+{
+    pthread_t tid[MAX_THREADS];
+    struct worker w[MAX_THREADS];
+
+    atomic_store(&p->done, 0);
+    atomic_store(&p->sum, 0);
+
+    // the root task goes to the first worker
+    if (run == run_stealing)
+        add_last_ws_deque(p->deques[0], (void *)(depth + 1));
+    else
+        add_last_deque(p->shared, (void *)(depth + 1));
+
+    double start = now_seconds();
+
+    for (int i = 0; i < p->threads; i++) {
+        w[i].pool = p;
+        w[i].id = i;
+        pthread_create(&tid[i], NULL, run, &w[i]);
+    }
+    for (int i = 0; i < p->threads; i++)
+        pthread_join(tid[i], NULL);
+
+    double elapsed = now_seconds() - start;
+
+    if (atomic_load(&p->sum) != expected)
+        printf("checksum mismatch\n");
+
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    uintptr_t depth = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    struct pool p = { .shared = create_deque_block(), .leaves = 1ULL << depth };
+
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+
+    pthread_mutex_init(&p.lock, NULL);
+    for (int i = 0; i < max_threads; i++)
+        p.deques[i] = create_ws_deque(64);
+
+    double start = now_seconds();
+    uint64_t expected = run_recursive(depth);
+    double recursive = now_seconds() - start;
+
+    printf("Task tree of depth %lu, %lu leaves, recursive %.3fs\n",
+            depth, p.leaves, recursive);
+    printf("%8s %12s %12s %10s\n", "threads", "mutex s", "stealing s", "speedup");
+
+    for (int t = 1; t <= max_threads; t *= 2) {
+        p.threads = t;
+
+        double shared = measure(&p, run_shared, depth, expected);
+        double stealing = measure(&p, run_stealing, depth, expected);
+
+        printf("%8d %12.3f %12.3f %9.2fx\n", t, shared, stealing, recursive / stealing);
+    }
+
+    for (int i = 0; i < max_threads; i++)
+        free_ws_deque(p.deques[i]);
+    pthread_mutex_destroy(&p.lock);
+    free_deque(p.shared);
+
+    exit(EXIT_SUCCESS);
+}
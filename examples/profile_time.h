@@ -1,34 +1,102 @@
 #ifndef _PROFILE_TIME_H
 #define _PROFILE_TIME_H
 
-#include <time.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Timing and random helpers shared by the examples. Every example is built
+ * on its own, so everything here is static inline. A time_measurement counts
+ * processor time of the calling process, now_seconds wall time for
+ * benchmarks running threads.
+ */
 
 struct time_measurement {
-    time_t timestamp;
-    
-    clock_t start;
-    clock_t stop;
-
-    uint64_t raw_result;
-    double ms_result;
-    double s_result;
+    time_t timestamp;   /**< wall clock time of the start */
+
+    clock_t start;      /**< processor time at the start */
+    clock_t stop;       /**< processor time at the stop */
+
+    uint64_t raw_result;    /**< runtime in clock ticks */
+    double ms_result;       /**< runtime in milliseconds */
+    double s_result;        /**< runtime in seconds */
 };
 
-struct time_measurement *create_measurement();
+/**
+ * Seconds on the monotonic clock, for differences only
+ */
+static inline double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Next value of a xorshift64 generator, state must not start at 0
+ */
+static inline uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static inline struct time_measurement *create_measurement()
+{
+    return calloc(1, sizeof(struct time_measurement));
+}
+
+// Helpers
+static inline void populate_measurement(struct time_measurement *t)
+{
+    t->raw_result = t->stop - t->start;
+    t->s_result = (double)t->raw_result / CLOCKS_PER_SEC;
+    t->ms_result = t->s_result * 1e3;
+}
 
+static inline void print_measurement(struct time_measurement *t)
+{
+    printf("runtime: %.3f ms\n", t->ms_result);
+}
 
 // In-place method for measuring runtime
-void start_measurement(struct time_measurement *t);
-void stop_measurement(struct time_measurement *t);
+static inline void start_measurement(struct time_measurement *t)
+{
+    t->timestamp = time(NULL);
+    t->start = clock();
+}
+
+static inline void stop_measurement(struct time_measurement *t)
+{
+    t->stop = clock();
+    populate_measurement(t);
+}
 
 // Composite solutions
-void print_runtime(void (*func)(void *), void *data);
-struct time_measurement *measure_runtime(void (*func)(void *), void *data);
+static inline struct time_measurement *measure_runtime(void (*func)(void *), void *data)
+{
+    struct time_measurement *t = create_measurement();
 
-// Helpers
-void print_measurement(struct time_measurement *t);
-void populate_measurement(struct time_measurement *t);
+    if (t == NULL) return NULL;
 
-#endif
+    start_measurement(t);
+    func(data);
+    stop_measurement(t);
+    return t;
+}
 
+static inline void print_runtime(void (*func)(void *), void *data)
+{
+    struct time_measurement *t = measure_runtime(func, data);
+
+    if (t == NULL) return;
+
+    print_measurement(t);
+    free(t);
+}
+
+#endif